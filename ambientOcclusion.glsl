@@ -0,0 +1,148 @@
+// Ambient occlusion rays shared by the lighting shader and the reduced resolution ambient occlusion pass. The including shader includes
+//  frameData.glsl and octreeTraversal.glsl first.
+
+uniform sampler2D u_blueNoiseTexture;
+
+float phi1 = 1.6180339887498948; // x^2 = x + 1
+float phi2 = 1.3247179572447460; // x^3 = x + 1
+
+// Calculates the center of the next voxel by traversing a ray starting on 'startPos' with direction 'rayDir'. 
+vec3 getNextVoxel(vec3 cubeCenterPos, inout float rayLength, vec3 startPos, float cubeWidth, vec3 rayDir, vec3 invRayDir) {
+    // startPos + rayDir * dRay = cubeCenterPos +- width/2 <=> dRay = (cubeCenterPos +- width/2 - startPos) / rayDir
+    vec3 dPos = cubeCenterPos + vec3(((rayDir.x >= 0) ? cubeWidth : -cubeWidth), ((rayDir.y >= 0) ? cubeWidth : -cubeWidth), ((rayDir.z >= 0) ? cubeWidth : -cubeWidth)) * 0.5 - startPos;
+    vec3 dRay = dPos * invRayDir;
+
+    vec3 normal;
+    if(dRay.x < dRay.y && dRay.x < dRay.z) {
+        normal = vec3(-sign(rayDir.x), 0.0, 0.0);
+        rayLength = dRay.x;
+    }
+    else if(dRay.y < dRay.z) {
+        normal = vec3(0.0, -sign(rayDir.y), 0.0);
+        rayLength = dRay.y;
+    }
+    else {
+        normal = vec3(0.0, 0.0, -sign(rayDir.z));
+        rayLength = dRay.z;
+    }
+    cubeCenterPos = startPos + rayLength * rayDir - normal * 0.5;
+
+    return floor(cubeCenterPos) + vec3(0.5, 0.5, 0.5);
+}
+
+// Raymarches through a chunk and returns the length of the ray untill the first voxel is hit, or -1 if no voxels were hit.
+//  localVoxelPos should always be the position of the center of a voxel. Empty sub-blocks are crossed in one step.
+float getRayLengthInChunk(uint chunkDataIndex, vec3 localVoxelPos, vec3 localStartPos, vec3 rayDir, vec3 invRayDir) {
+    float rayLength = 0.0;
+    // A ray can not visit more than 3 * u_chunkWidth voxels before leaving the chunk
+    for(uint iteration = 0; iteration < 3u * u_chunkWidth; ++iteration) {
+        if(localVoxelPos.x < 0 || localVoxelPos.x >= u_chunkWidth || localVoxelPos.y < 0.0 || localVoxelPos.y >= u_chunkWidth || localVoxelPos.z < 0.0 || localVoxelPos.z >= u_chunkWidth) {
+            break;
+        }
+
+        ivec3 iLocalPos = ivec3(floor(localVoxelPos));
+        ivec3 iSubBlockPos = iLocalPos / int(SUB_BLOCK_WIDTH);
+        if(!isSubBlockOccupied(chunkDataIndex, iSubBlockPos)) {
+            vec3 subBlockPos = vec3(iSubBlockPos * int(SUB_BLOCK_WIDTH)) + vec3(SUB_BLOCK_WIDTH * 0.5); // position of the center of the sub-block
+            localVoxelPos = getNextVoxel(subBlockPos, rayLength, localStartPos, float(SUB_BLOCK_WIDTH), rayDir, invRayDir);
+            continue;
+        }
+
+        uint voxelByte = getVoxelByte(chunkDataIndex, iLocalPos);
+        if(voxelByte != 0) {
+            return rayLength;
+        }
+
+        localVoxelPos = getNextVoxel(localVoxelPos, rayLength, localStartPos, 1.0, rayDir, invRayDir);        
+    }
+
+    return -1;
+}
+
+// Calculates the length of a ray untill it reaches a voxel by raymarching through an octree 
+float getRayLength(vec3 pos, vec3 rayDir, uint maxIterations, float maxDistance) {
+    vec3 startPos = pos;
+    vec3 voxelPos = floor(pos) + vec3(0.5, 0.5, 0.5); // voxelPos is always in the center of a voxel
+    vec3 normal = vec3(1.0, 0.0, 0.0);
+    float rayLength = 0;
+
+    vec3 invRayDir = 1.0 / rayDir;
+    float hWorldWidth = u_worldWidth / 2.0;
+    OctreeCursor cursor = ROOT_CURSOR;
+
+    for(uint iterations = 0; iterations < maxIterations && rayLength < maxDistance; ++iterations) {
+        if(voxelPos.x <= -hWorldWidth || voxelPos.x >= hWorldWidth || voxelPos.y <= -hWorldWidth || voxelPos.y >= hWorldWidth || voxelPos.z <= -hWorldWidth || voxelPos.z >= hWorldWidth) {
+            break;
+        }
+
+        uint currentDepth = 0;
+        vec3 localOctreeNodeVoxelPos = voxelPos;
+        uint leafData;
+        if(u_octreeRopesEnabled != 0u) leafData = getOctreeNodeFromCursor(cursor, currentDepth, localOctreeNodeVoxelPos);
+        else leafData = getOctreeNode(currentDepth, localOctreeNodeVoxelPos);
+
+        if((leafData & CHUNK_FLAG) != 0u) { // Search for voxel in current chunk
+            // localOctreeNodeVoxelPos is in the range [-width/2, width/2], we want to transform it into the range [0, width]
+            vec3 localVoxelPos = floor(localOctreeNodeVoxelPos + vec3(u_chunkWidth * 0.5)) + vec3(0.5);
+            rayLength = getRayLengthInChunk(leafData & ~CHUNK_FLAG, localVoxelPos, startPos + (localVoxelPos - voxelPos), rayDir, invRayDir);
+            if(rayLength >= 0.0) {
+                return rayLength;
+            }
+        }
+        else if(leafData != 0u) { // Every voxel in the current octree node is the same color
+            float octreeNodeWidth = u_worldWidth / pow(2, currentDepth);
+            vec3 localChunkPos = vec3(localOctreeNodeVoxelPos) + vec3(octreeNodeWidth) * 0.5;
+
+            return rayLength;
+        }
+
+        float width = u_worldWidth / pow(2, currentDepth);
+        vec3 octreeNodePos = floor(voxelPos / width) * width + vec3(width * 0.5);  // position of the center of the current octreeNode
+
+        voxelPos = getNextVoxel(octreeNodePos, rayLength, startPos, width, rayDir, invRayDir);
+    }
+
+    return maxDistance;
+}
+
+float random(vec2 st) {
+    return fract(sin(dot(st.xy, vec2(12.9898,78.233))) * 43758.5453123);
+}
+
+vec3 getRandomRayDir(vec3 normal, vec2 noiseSamplePos, float frame) {
+    vec2 rand = texture(u_blueNoiseTexture, noiseSamplePos).xy;
+    rand.x = mod(rand.x + phi1 * mod(frame, 128.0), 1.0) * 2.0 - 1.0;
+    rand.y = mod(rand.y + phi2 * mod(frame, 128.0), 1.0) * 2.0 - 1.0;
+    rand *= 2.0;
+
+    vec3 rayDir;
+    if(normal.x != 0.0) rayDir = vec3(normal.x, rand.x, rand.y);
+    else if(normal.y != 0.0) rayDir = vec3(rand.x, normal.y, rand.y);
+    else rayDir = vec3(rand.x, rand.y, normal.z);
+    
+    rayDir = normalize(rayDir);
+
+    return rayDir;
+}
+
+// Traces one ray in a random direction around the normal of a g buffer pixel and returns how much of the light reaches it. 'fragPos' is
+//  the position of the pixel on the screen in the range [0, 1].
+float getAmbientOcclusion(vec3 albedo, vec3 normal, vec3 pos, vec2 fragPos) {
+    uint maxIterations = (albedo.x < 0.0) ? 0 : 16;
+    float maxDistance = 16.0;
+    vec3 rayDir = getRandomRayDir(normal, fragPos * u_noiseTextureScale, u_frame);
+    float rayLength = getRayLength(pos + rayDir * 0.01, rayDir, maxIterations, maxDistance);
+    float oclusion = rayLength / maxDistance;
+    return min(pow(oclusion, 0.8), 1.0);
+}
+
+// The reduced resolution pass traces one pixel of every 'scale' x 'scale' block of pixels per frame. Returns the offset of that pixel in its
+//  block, which visits every pixel of the block in 'scale' * 'scale' frames. A 4x4 block is visited as four 2x2 patterns, so that the
+//  first frames of the sequence are spread over the whole block.
+ivec2 getAmbientOcclusionSampleOffset(uint scale, float frame) {
+    const ivec2 PATTERN[4] = ivec2[4](ivec2(0, 0), ivec2(1, 1), ivec2(1, 0), ivec2(0, 1));
+    if(scale <= 1u) return ivec2(0);
+
+    uint index = uint(mod(frame, float(scale * scale)));
+    return PATTERN[index % 4u] * int(scale / 2u) + PATTERN[index / 4u];
+}
\ No newline at end of file
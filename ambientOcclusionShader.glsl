@@ -0,0 +1,36 @@
+#section vertex
+#version 430 core
+layout (location = 0) in vec3 aPos;
+
+void main() {
+    gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);
+}
+
+
+#section fragment
+#version 430 core
+
+// Traces the ambient occlusion of one pixel of every u_aoResolutionScale x u_aoResolutionScale block of the g buffer. Drawn with a viewport
+//  of the reduced resolution, the lighting shader upsamples the result.
+layout (location = 0) out float ambientOcclusion;
+
+uniform sampler2D u_gAlbedo;
+uniform sampler2D u_gNormal;
+uniform sampler2D u_gPos;
+uniform usampler2D u_gVisibility;
+
+#include "frameData.glsl"
+#include "octreeTraversal.glsl"
+#include "ambientOcclusion.glsl"
+
+void main() {
+    ivec2 offset = getAmbientOcclusionSampleOffset(u_aoResolutionScale, u_frame);
+    ivec2 pixel = min(ivec2(gl_FragCoord.xy) * int(u_aoResolutionScale) + offset, ivec2(u_renderSize) - ivec2(1));
+
+    gBufferData gbd = readGBuffer(u_gAlbedo, u_gNormal, u_gPos, u_gVisibility, pixel);
+    vec3 albedo = gbd.albedo;
+    vec3 normal = gbd.normal;
+    vec3 pos = gbd.pos;
+
+    ambientOcclusion = getAmbientOcclusion(albedo, normal, pos, (vec2(pixel) + vec2(0.5)) / u_renderSize);
+}
\ No newline at end of file
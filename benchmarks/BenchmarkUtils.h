@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+// Timing that every benchmark shares. The helpers of the ray casting and loading benchmarks are in RayBenchmarkUtils.h and
+//  LoaderBenchmarkUtils.h, so that a benchmark only needs the headers of what it measures.
+
+struct BenchmarkTimes {
+    double median, min;
+};
+
+// Runs 'function' 'repetitions' times and returns the median and the shortest time in milliseconds
+template<typename F>
+BenchmarkTimes measureTimes(unsigned int repetitions, F function) {
+    std::vector<double> times;
+    for(unsigned int i = 0; i < repetitions; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - start;
+        times.push_back(time.count());
+    }
+    std::sort(times.begin(), times.end());
+    return { times[times.size() / 2], times.front() };
+}
+
+template<typename F>
+double medianTime(unsigned int repetitions, F function) {
+    return measureTimes(repetitions, function).median;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+#include "VoxelLoader.h"
+
+// Helpers of the benchmarks that load voxel files
+
+inline void freeVoxelData(VoxelData& voxelData) {
+    delete[] voxelData.voxelData;
+    delete[] voxelData.paletteData;
+    voxelData = {nullptr, 0, 0, 0, nullptr};
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "Octree.h"
+#include "OctreeRayCaster.h"
+#include "BenchmarkUtils.h"
+#include "RayBenchmarkUtils.h"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+
+// Measures how many rays per second OctreeRayCaster traces through generated worlds, one ray at a time, in packets, and as the short
+//  ambient occlusion rays of the lighting shader. The hits are checked by OctreeRayCasterTest, this only measures how fast they are found.
+
+struct BenchmarkRays {
+    std::vector<glm::vec3> origins, directions;
+};
+
+BenchmarkRays generateCameraRays(unsigned int worldWidth, unsigned int imageWidth, unsigned int imageHeight);
+
+// Enough for every camera ray in the generated worlds to reach the edge of the world
+const unsigned int MAX_ITERATIONS = 1000;
+
+int main(int argc, char** argv) {
+    std::vector<unsigned int> widths;
+    unsigned int chunkWidth = 16;
+    unsigned int imageWidth = 640, imageHeight = 360;
+    unsigned int repetitions = 5;
+
+    for(int i = 1; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--chunk-width") == 0 && i + 1 < argc) chunkWidth = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--image") == 0 && i + 2 < argc) {
+            imageWidth = std::atoi(argv[++i]);
+            imageHeight = std::atoi(argv[++i]);
+        }
+        else if(std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) repetitions = std::max(std::atoi(argv[++i]), 1);
+        else if(std::atoi(argv[i]) > 0) widths.push_back(std::atoi(argv[i]));
+        else {
+            std::cout << "Usage: OctreeRayCasterBenchmark [world widths...] [--chunk-width N] [--image WIDTH HEIGHT] [--repetitions N]" << std::endl;
+            return -1;
+        }
+    }
+    if(widths.empty()) widths = { 128, 256, 512 };
+    // The packets are rows of RAY_PACKET_SIZE pixels
+    imageWidth = std::max((imageWidth + RAY_PACKET_SIZE - 1) / RAY_PACKET_SIZE * RAY_PACKET_SIZE, RAY_PACKET_SIZE);
+
+    std::cout << "Packets are traced " << (OctreeRayCaster::isPacketTracingVectorized() ? "with AVX2" : "one ray at a time") << std::endl;
+    std::printf("%-6s %6s %9s %16s %16s %16s\n", "width", "chunk", "rays", "single (Mray/s)", "packet (Mray/s)", "AO (Mray/s)");
+    for(unsigned int width : widths) {
+        unsigned int maxDepth = 0;
+        while((width >> maxDepth) > chunkWidth) maxDepth++;
+        if((width >> maxDepth) != chunkWidth) {
+            std::cout << "ERROR: A " << width << "^3 world can not be split into chunks of width " << chunkWidth << std::endl;
+            return -1;
+        }
+
+        std::vector<uint8_t> world = generateWorld(width);
+        Octree octree(world.data(), width, maxDepth);
+        std::unique_ptr<OctreeRayCaster> rayCaster = OctreeRayCaster::create(octree);
+        if(!rayCaster) {
+            std::cout << "ERROR: There is no ray caster for chunks of width " << chunkWidth << std::endl;
+            return -1;
+        }
+
+        BenchmarkRays rays = generateCameraRays(width, imageWidth, imageHeight);
+        size_t rayCount = rays.origins.size();
+
+        // The ambient occlusion rays start where the camera rays hit
+        std::vector<OctreeRayHit> hits(rayCount);
+        for(size_t i = 0; i < rayCount; ++i) hits[i] = rayCaster->castRay(rays.origins[i], rays.directions[i], 0.0f, MAX_ITERATIONS, INFINITY);
+
+        std::vector<OctreeRayPacket> packets(rayCount / RAY_PACKET_SIZE);
+        for(size_t i = 0; i < rayCount; ++i) {
+            OctreeRayPacket& packet = packets[i / RAY_PACKET_SIZE];
+            unsigned int lane = i % RAY_PACKET_SIZE;
+            packet.originX[lane] = rays.origins[i].x;
+            packet.originY[lane] = rays.origins[i].y;
+            packet.originZ[lane] = rays.origins[i].z;
+            packet.directionX[lane] = rays.directions[i].x;
+            packet.directionY[lane] = rays.directions[i].y;
+            packet.directionZ[lane] = rays.directions[i].z;
+            packet.startDistance[lane] = 0.0f;
+            packet.maxDistance[lane] = INFINITY;
+        }
+        std::vector<OctreeRayHit> packetHits(rayCount);
+
+        // Ambient occlusion rays leave the hits in a direction that is rotated a little each time, like the lighting shader's
+        std::vector<glm::vec3> aoOrigins, aoDirections;
+        for(size_t i = 0; i < rayCount; ++i) {
+            if(!hits[i].hit) continue;
+            float angle = i * 2.39996f;
+            glm::vec3 direction = hits[i].normal + glm::vec3(std::cos(angle), std::sin(angle * 1.7f), std::sin(angle)) * 0.8f;
+            direction = glm::normalize(direction);
+            aoDirections.push_back(direction);
+            aoOrigins.push_back(hits[i].pos + direction * 0.01f);
+        }
+
+        float checksum = 0.0f;
+        double singleTime = medianTime(repetitions, [&]() {
+            for(size_t i = 0; i < rayCount; ++i) checksum += rayCaster->castRay(rays.origins[i], rays.directions[i], 0.0f, MAX_ITERATIONS, INFINITY).distance;
+        });
+        double packetTime = medianTime(repetitions, [&]() {
+            for(size_t i = 0; i < packets.size(); ++i) rayCaster->castRayPacket(packets[i], MAX_ITERATIONS, &packetHits[i * RAY_PACKET_SIZE]);
+            checksum += packetHits[0].distance;
+        });
+        double aoTime = medianTime(repetitions, [&]() {
+            for(size_t i = 0; i < aoOrigins.size(); ++i) checksum += rayCaster->getRayLength(aoOrigins[i], aoDirections[i], 16, 16.0f);
+        });
+        if(checksum == 1.0f) std::cout << std::endl; // Keeps the traced rays from being optimized away
+
+        std::printf("%-6u %6u %9zu %16.2f %16.2f %16.2f\n", width, chunkWidth, rayCount,
+            rayCount / singleTime / 1000.0, rayCount / packetTime / 1000.0, aoOrigins.size() / aoTime / 1000.0);
+    }
+
+    return 0;
+}
+
+// Rays of three pinhole cameras above the spheres, one looking down at the terrain, one across it and one towards the horizon, where most
+//  rays leave the world
+BenchmarkRays generateCameraRays(unsigned int worldWidth, unsigned int imageWidth, unsigned int imageHeight) {
+    const float w = (float)worldWidth;
+    // The cameras are not on voxel faces, where the rays through the edges of nodes are ambiguous
+    const glm::vec3 positions[3] = { glm::vec3(0.31f, w * 0.4f + 0.27f, 0.43f), glm::vec3(-w * 0.4f + 0.61f, w * 0.38f + 0.19f, -w * 0.4f + 0.37f), glm::vec3(w * 0.3f + 0.23f, w * 0.42f + 0.71f, w * 0.2f + 0.53f) };
+    const glm::vec3 forwards[3] = { glm::vec3(0.3f, -1.0f, -0.6f), glm::vec3(1.0f, -0.45f, 0.8f), glm::vec3(-0.5f, -0.1f, -0.7f) };
+
+    BenchmarkRays rays;
+    for(int camera = 0; camera < 3; ++camera) {
+        glm::vec3 forward = glm::normalize(forwards[camera]);
+        glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+        glm::vec3 up = glm::cross(right, forward);
+        float aspectRatio = imageWidth / (float)imageHeight;
+
+        for(unsigned int y = 0; y < imageHeight; ++y) {
+            for(unsigned int x = 0; x < imageWidth; ++x) {
+                float screenX = ((x + 0.5f) / imageWidth - 0.5f) * aspectRatio;
+                float screenY = (y + 0.5f) / imageHeight - 0.5f;
+                rays.origins.push_back(positions[camera]);
+                rays.directions.push_back(glm::normalize(forward + right * screenX + up * screenY));
+            }
+        }
+    }
+    return rays;
+}
\ No newline at end of file
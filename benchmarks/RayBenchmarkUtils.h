@@ -0,0 +1,52 @@
+#pragma once
+#include "OctreeRayCaster.h"
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+// Helpers of the benchmarks that trace rays through generated worlds
+
+// Rolling terrain with spheres floating above it and single voxels scattered through the air, so that rays cross large empty nodes, single
+//  color nodes and chunks with few voxels
+inline std::vector<uint8_t> generateWorld(unsigned int width) {
+    std::vector<uint8_t> world((size_t)width * width * width, 0);
+    for(unsigned int z = 0; z < width; ++z) {
+        for(unsigned int x = 0; x < width; ++x) {
+            float height = width * (0.3f + 0.08f * std::sin(x * 0.05f) * std::cos(z * 0.04f) + 0.03f * std::sin((x + z) * 0.13f));
+            for(unsigned int y = 0; y < width && y < height; ++y) {
+                world[x + (size_t)y * width + (size_t)z * width * width] = (y + 4 < height) ? 3 : (uint8_t)(7 + (x * 3 + z * 5) % 4);
+            }
+        }
+    }
+
+    uint32_t random = 2654435761u;
+    auto nextRandom = [&]() {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        return random;
+    };
+    for(unsigned int sphere = 0; sphere < 6; ++sphere) {
+        // Worlds narrower than 16 voxels get spheres as well, without dividing by zero
+        float centerX = nextRandom() % width, centerY = width * 0.5f + nextRandom() % std::max(width / 4, 1u), centerZ = nextRandom() % width;
+        float radius = width / 20.0f + nextRandom() % std::max(width / 16, 1u);
+        for(unsigned int z = 0; z < width; ++z) {
+            for(unsigned int y = 0; y < width; ++y) {
+                for(unsigned int x = 0; x < width; ++x) {
+                    float distanceSquared = (x - centerX) * (x - centerX) + (y - centerY) * (y - centerY) + (z - centerZ) * (z - centerZ);
+                    if(distanceSquared < radius * radius) world[x + (size_t)y * width + (size_t)z * width * width] = (uint8_t)(30 + sphere);
+                }
+            }
+        }
+    }
+    for(unsigned int i = 0; i < width * width / 4; ++i) {
+        unsigned int x = nextRandom() % width, y = nextRandom() % width, z = nextRandom() % width;
+        world[x + (size_t)y * width + (size_t)z * width * width] = (uint8_t)(40 + nextRandom() % 8);
+    }
+    return world;
+}
+
+inline bool isSameHit(const OctreeRayHit& a, const OctreeRayHit& b) {
+    return a.hit == b.hit && a.paletteIndex == b.paletteIndex && a.distance == b.distance && a.pos == b.pos && a.normal == b.normal;
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "Octree.h"
+#include "OctreeRayCaster.h"
+#include "RaycastBatch.h"
+#include "BenchmarkUtils.h"
+#include "RayBenchmarkUtils.h"
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+
+// Measures how many rays per second RaycastBatch traces for a mix of gameplay queries, with every thread count from one up to the number of
+//  cores, with and without sorting the rays. The queries are line of sight checks between points above the terrain, picking rays from a
+//  camera and short ground probes, shuffled together like the queries of independent systems. Every hit is checked against tracing the ray
+//  alone with OctreeRayCaster::castRay, a mismatch is printed and the benchmark returns -1.
+
+struct GameplayRay {
+    glm::vec3 origin, direction;
+    float maxDistance;
+};
+
+std::vector<GameplayRay> generateGameplayRays(unsigned int worldWidth, unsigned int rayCount);
+
+int main(int argc, char** argv) {
+    unsigned int worldWidth = 512;
+    unsigned int chunkWidth = 16;
+    unsigned int rayCount = 65536;
+    unsigned int repetitions = 5;
+
+    for(int i = 1; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--chunk-width") == 0 && i + 1 < argc) chunkWidth = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--rays") == 0 && i + 1 < argc) rayCount = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) repetitions = std::max(std::atoi(argv[++i]), 1);
+        else if(std::atoi(argv[i]) > 0) worldWidth = std::atoi(argv[i]);
+        else {
+            std::cout << "Usage: RaycastBatchBenchmark [world width] [--chunk-width N] [--rays N] [--repetitions N]" << std::endl;
+            return -1;
+        }
+    }
+
+    unsigned int maxDepth = 0;
+    while((worldWidth >> maxDepth) > chunkWidth) maxDepth++;
+    if((worldWidth >> maxDepth) != chunkWidth) {
+        std::cout << "ERROR: A " << worldWidth << "^3 world can not be split into chunks of width " << chunkWidth << std::endl;
+        return -1;
+    }
+
+    std::vector<uint8_t> world = generateWorld(worldWidth);
+    Octree octree(world.data(), worldWidth, maxDepth);
+    std::vector<GameplayRay> rays = generateGameplayRays(worldWidth, rayCount);
+
+    std::unique_ptr<OctreeRayCaster> rayCaster = OctreeRayCaster::create(octree);
+    if(!rayCaster) {
+        std::cout << "ERROR: There is no ray caster for chunks of width " << chunkWidth << std::endl;
+        return -1;
+    }
+
+    std::cout << rayCount << " rays in a " << worldWidth << "^3 world with chunks of width " << chunkWidth << ", packets are traced "
+        << (OctreeRayCaster::isPacketTracingVectorized() ? "with AVX2" : "one ray at a time") << std::endl;
+    std::printf("%-8s %18s %18s\n", "threads", "sorted (Mray/s)", "unsorted (Mray/s)");
+
+    unsigned int coreCount = std::max(std::thread::hardware_concurrency(), 1u);
+    for(unsigned int threadCount = 1; ; threadCount = std::min(threadCount * 2, coreCount)) {
+        RaycastBatch batch(octree, threadCount);
+        for(const GameplayRay& ray : rays) batch.addRay(ray.origin, ray.direction, ray.maxDistance);
+
+        // Sorting and tracing in packets must not change any hit
+        for(bool sortRays : { true, false }) {
+            batch.trace(sortRays);
+            for(unsigned int i = 0; i < rayCount; ++i) {
+                OctreeRayHit hit = rayCaster->castRay(rays[i].origin, glm::normalize(rays[i].direction), 0.0f, 3u << maxDepth, rays[i].maxDistance);
+                if(!isSameHit(hit, batch.getHits()[i])) {
+                    std::cout << "ERROR: Ray " << i << " hits something else in a batch traced by " << threadCount << " threads" << std::endl;
+                    return -1;
+                }
+            }
+        }
+
+        double sortedTime = medianTime(repetitions, [&]() { batch.trace(true); });
+        double unsortedTime = medianTime(repetitions, [&]() { batch.trace(false); });
+        std::printf("%-8u %18.2f %18.2f\n", threadCount, rayCount / sortedTime / 1000.0, rayCount / unsortedTime / 1000.0);
+
+        if(threadCount == coreCount) break;
+    }
+
+    return 0;
+}
+
+// A third of the rays are line of sight checks between agents standing on or flying above the terrain, a third are picking rays from a
+//  camera and a third are ground probes that look 32 voxels down
+std::vector<GameplayRay> generateGameplayRays(unsigned int worldWidth, unsigned int rayCount) {
+    const float w = (float)worldWidth;
+    uint32_t random = 12345;
+    auto nextRandom = [&]() {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        return (random & 0xFFFFFF) / (float)0x1000000;
+    };
+    auto randomPoint = [&](float minY, float maxY) {
+        return glm::vec3((nextRandom() - 0.5f) * w * 0.9f, minY + nextRandom() * (maxY - minY), (nextRandom() - 0.5f) * w * 0.9f);
+    };
+
+    std::vector<GameplayRay> rays(rayCount);
+    const glm::vec3 cameraPos(w * 0.1f + 0.3f, w * 0.05f + 0.6f, w * 0.2f + 0.4f);
+    for(unsigned int i = 0; i < rayCount; ++i) {
+        if(i % 3 == 0) {
+            glm::vec3 from = randomPoint(-w * 0.2f, w * 0.1f);
+            glm::vec3 to = randomPoint(-w * 0.2f, w * 0.1f);
+            rays[i] = GameplayRay{ from, to - from, glm::length(to - from) };
+        }
+        else if(i % 3 == 1) {
+            glm::vec3 direction(nextRandom() - 0.5f, (nextRandom() - 0.8f) * 0.6f, -1.0f);
+            rays[i] = GameplayRay{ cameraPos, direction, w * 2.0f };
+        }
+        else {
+            rays[i] = GameplayRay{ randomPoint(-w * 0.1f, w * 0.3f), glm::vec3(0.0f, -1.0f, 0.0f), 32.0f };
+        }
+    }
+
+    // The queries of independent systems arrive interleaved
+    for(unsigned int i = rayCount; i > 1; --i) {
+        std::swap(rays[i - 1], rays[(unsigned int)(nextRandom() * i)]);
+    }
+    return rays;
+}
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "VoxelLoader.h"
+#include "Octree.h"
+#include "BenchmarkUtils.h"
+#include "LoaderBenchmarkUtils.h"
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+
+// Times the CPU work that decides the startup time: parsing XRAW files with both axes, building octrees with both build methods and
+//  Octree::isSolidColor. Every benchmark runs on generated worlds of each width and fill rate, and the results are written as JSON so that
+//  runs on different commits can be compared. Before timing, the parsed voxels are checked against the generated world and the two build
+//  methods against each other. A mismatch is printed and the benchmark returns -1.
+
+struct BenchmarkResult {
+    std::string benchmark, variant;
+    unsigned int width;
+    double fillRate, measuredFillRate;
+    BenchmarkTimes times;
+    double voxelsPerSecond;
+};
+
+std::vector<uint8_t> generateXRAWFile(unsigned int width, double fillRate);
+bool isSameVoxel(const std::vector<uint8_t>& file, const VoxelData& voxelData, unsigned int width, VoxelDataAxis axis, size_t voxelIndex);
+bool writeResults(const char* filename, const char* label, unsigned int threadCount, unsigned int repetitions, const std::vector<BenchmarkResult>& results);
+
+const size_t XRAW_HEADER_SIZE = 24;
+// Number of voxels of the parsed worlds that are compared with the generated ones, spread evenly over the world
+const size_t CHECKED_VOXELS = 1 << 20;
+
+int main(int argc, char** argv) {
+    std::vector<unsigned int> widths;
+    std::vector<double> fillRates;
+    unsigned int chunkWidth = 16;
+    unsigned int threadCount = 0;
+    unsigned int repetitions = 3;
+    const char* outputFilename = "VoxelBenchmarks.json";
+    const char* label = "";
+
+    for(int i = 1; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--fill-rate") == 0 && i + 1 < argc) fillRates.push_back(std::min(std::max(std::atof(argv[++i]), 0.0), 1.0));
+        else if(std::strcmp(argv[i], "--chunk-width") == 0 && i + 1 < argc) chunkWidth = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) repetitions = std::max(std::atoi(argv[++i]), 1);
+        else if(std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) outputFilename = argv[++i];
+        else if(std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) label = argv[++i];
+        else if(std::atoi(argv[i]) > 0) widths.push_back(std::atoi(argv[i]));
+        else {
+            std::cout << "Usage: VoxelBenchmarks [world widths...] [--fill-rate F]... [--chunk-width N] [--threads N] [--repetitions N] [--output FILE] [--label TEXT]" << std::endl;
+            return -1;
+        }
+    }
+    if(widths.empty()) widths = { 64, 128, 256, 512, 1024 };
+    if(fillRates.empty()) fillRates = { 0.1, 0.5, 0.9 };
+
+    std::vector<BenchmarkResult> results;
+    std::printf("%-6s %5s  %-28s %12s %12s %14s\n", "width", "fill", "benchmark", "median (ms)", "min (ms)", "Mvoxels/s");
+    for(unsigned int width : widths) {
+        unsigned int maxDepth = 0;
+        while((width >> maxDepth) > chunkWidth) maxDepth++;
+        if((width >> maxDepth) != chunkWidth || width % (2u << maxDepth) != 0) {
+            std::cout << "ERROR: A world width of " << width << " can not be split into chunks of " << chunkWidth << std::endl;
+            return -1;
+        }
+        size_t worldSize = (size_t)width * width * width;
+
+        for(double fillRate : fillRates) {
+            std::vector<uint8_t> file = generateXRAWFile(width, fillRate);
+            // The voxels of the file are in the order of a Y_Up world, so they are used as the world for the octree benchmarks
+            uint8_t* world = file.data() + XRAW_HEADER_SIZE;
+            size_t solidVoxels = worldSize - std::count(world, world + worldSize, 0);
+            double measuredFillRate = (double)solidVoxels / worldSize;
+
+            auto addResult = [&](const char* benchmark, const char* variant, BenchmarkTimes times, double voxels) {
+                results.push_back({ benchmark, variant, width, fillRate, measuredFillRate, times, voxels / (times.median / 1000.0) });
+                std::printf("%-6u %5.2f  %-28s %12.2f %12.2f %14.1f\n", width, measuredFillRate, (std::string(benchmark) + " " + variant).c_str(), times.median, times.min, results.back().voxelsPerSecond / 1e6);
+                std::fflush(stdout);
+            };
+
+            for(VoxelDataAxis axis : { VoxelDataAxis::Y_Up, VoxelDataAxis::Z_Up }) {
+                VoxelData parsed = VoxelLoader::parseXRAWFile(file.data(), file.size(), axis, threadCount);
+                bool identical = parsed.voxelData != nullptr && parsed.sizeX == width && parsed.sizeY == width && parsed.sizeZ == width;
+                for(size_t i = 0; i < CHECKED_VOXELS && identical; ++i) {
+                    identical = isSameVoxel(file, parsed, width, axis, i * worldSize / CHECKED_VOXELS);
+                }
+                freeVoxelData(parsed);
+                if(!identical) {
+                    std::cout << "ERROR: parseXRAWFile returned other voxels than the file has for a " << width << "^3 world" << std::endl;
+                    return -1;
+                }
+
+                BenchmarkTimes times = measureTimes(repetitions, [&]() {
+                    VoxelData voxelData = VoxelLoader::parseXRAWFile(file.data(), file.size(), axis, threadCount);
+                    freeVoxelData(voxelData);
+                });
+                addResult("parseXRAWFile", axis == VoxelDataAxis::Y_Up ? "Y_Up" : "Z_Up", times, worldSize);
+            }
+
+            // The top down build is the reference that the bottom up build must match
+            std::unique_ptr<Octree> octree = std::make_unique<Octree>(world, width, maxDepth, OctreeBuildMethod::BottomUp, threadCount);
+            {
+                Octree reference(world, width, maxDepth, OctreeBuildMethod::TopDown);
+                bool identical = octree->nodes.size() == reference.nodes.size() && octree->chunkData == reference.chunkData
+                    && std::memcmp(octree->nodes.data(), reference.nodes.data(), reference.nodes.size() * sizeof(OctreeNode)) == 0;
+                if(!identical) {
+                    std::cout << "ERROR: The build methods built different octrees for a " << width << "^3 world" << std::endl;
+                    return -1;
+                }
+            }
+
+            BenchmarkTimes bottomUpTimes = measureTimes(repetitions, [&]() { Octree(world, width, maxDepth, OctreeBuildMethod::BottomUp, threadCount); });
+            addResult("Octree", "BottomUp", bottomUpTimes, worldSize);
+            BenchmarkTimes topDownTimes = measureTimes(repetitions, [&]() { Octree(world, width, maxDepth, OctreeBuildMethod::TopDown); });
+            addResult("Octree", "TopDown", topDownTimes, worldSize);
+
+            // Every chunk of the world, which is what the top down build asks for the nodes at the deepest level
+            unsigned int solidChunks = 0;
+            BenchmarkTimes solidColorTimes = measureTimes(repetitions, [&]() {
+                solidChunks = 0;
+                for(unsigned int z = 0; z < width; z += chunkWidth) {
+                    for(unsigned int y = 0; y < width; y += chunkWidth) {
+                        for(unsigned int x = 0; x < width; x += chunkWidth) {
+                            if(octree->isSolidColor(world, chunkWidth, x, y, z)) solidChunks++;
+                        }
+                    }
+                }
+            });
+            addResult("isSolidColor", "chunks", solidColorTimes, worldSize);
+        }
+    }
+
+    if(!writeResults(outputFilename, label, threadCount, repetitions, results)) {
+        std::cout << "ERROR: Could not write " << outputFilename << std::endl;
+        return -1;
+    }
+    std::cout << "Results written to " << outputFilename << std::endl;
+    return 0;
+}
+
+// Returns an XRAW file with 8 bit indices and an 8 bit RGBA palette. The world is terrain whose height varies around 'fillRate' * width, so
+//  about that fraction of the voxels is solid, in bands of 32 layers of one color so that some chunks are a single color.
+std::vector<uint8_t> generateXRAWFile(unsigned int width, double fillRate) {
+    size_t worldSize = (size_t)width * width * width;
+    std::vector<uint8_t> file(XRAW_HEADER_SIZE + worldSize + 256 * 4, 0);
+
+    uint8_t header[XRAW_HEADER_SIZE] = { 'X', 'R', 'A', 'W', 0, 4, 8, 8 };
+    uint32_t sizes[4] = { width, width, width, 256 };
+    std::memcpy(header + 8, sizes, sizeof(sizes));
+    std::memcpy(file.data(), header, sizeof(header));
+
+    // The waves average to zero and are kept inside the world, so the fill rate is kept as well
+    double amplitude = std::min(fillRate, 1.0 - fillRate) * width * 0.5;
+    uint8_t* world = file.data() + XRAW_HEADER_SIZE;
+    for(unsigned int z = 0; z < width; ++z) {
+        for(unsigned int x = 0; x < width; ++x) {
+            double wave = std::sin(x * 6.2831853 * 3.0 / width) * std::cos(z * 6.2831853 * 2.0 / width);
+            unsigned int height = (unsigned int)std::lround(fillRate * width + amplitude * wave);
+            for(unsigned int y = 0; y < std::min(height, width); ++y) {
+                world[x + (size_t)y * width + (size_t)z * width * width] = (uint8_t)(1 + (y / 32) % 255);
+            }
+        }
+    }
+
+    uint8_t* palette = world + worldSize;
+    for(unsigned int i = 0; i < 256 * 4; ++i) palette[i] = (uint8_t)(i * 37);
+    return file;
+}
+
+// The file stores the voxels as x + y * width + z * width^2, a Z_Up world is parsed with y and z swapped
+bool isSameVoxel(const std::vector<uint8_t>& file, const VoxelData& voxelData, unsigned int width, VoxelDataAxis axis, size_t voxelIndex) {
+    size_t x = voxelIndex % width, y = voxelIndex / width % width, z = voxelIndex / ((size_t)width * width);
+    size_t fileIndex = (axis == VoxelDataAxis::Y_Up) ? voxelIndex : x + z * width + y * width * width;
+    return voxelData.voxelData[voxelIndex] == file[XRAW_HEADER_SIZE + fileIndex];
+}
+
+bool writeResults(const char* filename, const char* label, unsigned int threadCount, unsigned int repetitions, const std::vector<BenchmarkResult>& results) {
+    FILE* file = std::fopen(filename, "w");
+    if(file == nullptr) return false;
+
+    // The label is written as it is, so it must not contain quotes or backslashes
+    std::fprintf(file, "{\n  \"label\": \"%s\",\n  \"threads\": %u,\n  \"repetitions\": %u,\n  \"results\": [\n", label, threadCount, repetitions);
+    for(size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        std::fprintf(file, "    { \"benchmark\": \"%s\", \"variant\": \"%s\", \"width\": %u, \"fillRate\": %.2f, \"measuredFillRate\": %.4f, \"medianMs\": %.3f, \"minMs\": %.3f, \"voxelsPerSecond\": %.0f }%s\n",
+            result.benchmark.c_str(), result.variant.c_str(), result.width, result.fillRate, result.measuredFillRate, result.times.median, result.times.min, result.voxelsPerSecond, (i + 1 < results.size()) ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+
+    bool success = std::ferror(file) == 0;
+    std::fclose(file);
+    return success;
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "VoxelLoader.h"
+#include "BenchmarkUtils.h"
+#include "LoaderBenchmarkUtils.h"
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+
+// Compares loading Z_Up XRAW worlds through VoxelLoader with the loader it replaced, which read the file through an ifstream and swapped
+//  the axes one voxel at a time. The worlds are generated, written to a temporary file and loaded 'repetitions' times, the median is printed.
+
+const char* BENCHMARK_FILENAME = "VoxelLoaderBenchmark.xraw";
+
+bool writeWorld(const char* filename, unsigned int width);
+VoxelData loadVoxelDataReference(const char* filename);
+void transposeZUpReference(const uint8_t* source, uint8_t* destination, unsigned int sizeX, unsigned int sizeY, unsigned int sizeZ);
+
+int main(int argc, char** argv) {
+    std::vector<unsigned int> widths;
+    unsigned int threadCount = 0;
+    unsigned int repetitions = 5;
+
+    for(int i = 1; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) repetitions = std::max(std::atoi(argv[++i]), 1);
+        else if(std::atoi(argv[i]) > 0) widths.push_back(std::atoi(argv[i]));
+        else {
+            std::cout << "Usage: VoxelLoaderBenchmark [world widths...] [--threads N] [--repetitions N]" << std::endl;
+            return -1;
+        }
+    }
+    if(widths.empty()) widths = { 256, 512, 1024 };
+
+    std::printf("%-6s %14s %14s %16s %16s\n", "width", "load old (ms)", "load new (ms)", "swap old (ms)", "swap new (ms)");
+    for(unsigned int width : widths) {
+        if(!writeWorld(BENCHMARK_FILENAME, width)) {
+            std::cout << "Could not write " << BENCHMARK_FILENAME << std::endl;
+            return -1;
+        }
+
+        // The new loader must produce exactly what the old one did
+        VoxelData reference = loadVoxelDataReference(BENCHMARK_FILENAME);
+        VoxelData loaded = VoxelLoader::loadVoxelData(BENCHMARK_FILENAME, VoxelDataAxis::Z_Up, threadCount);
+        size_t worldSize = (size_t)width * width * width;
+        bool identical = reference.voxelData != nullptr && loaded.voxelData != nullptr
+            && std::memcmp(reference.voxelData, loaded.voxelData, worldSize) == 0
+            && std::memcmp(reference.paletteData, loaded.paletteData, 256 * 3 * sizeof(float)) == 0;
+        freeVoxelData(reference);
+        freeVoxelData(loaded);
+        if(!identical) {
+            std::cout << "ERROR: The loaders disagree on a " << width << "^3 world" << std::endl;
+            std::remove(BENCHMARK_FILENAME);
+            return -1;
+        }
+
+        double oldLoadTime = medianTime(repetitions, [&]() {
+            VoxelData voxelData = loadVoxelDataReference(BENCHMARK_FILENAME);
+            freeVoxelData(voxelData);
+        });
+        double newLoadTime = medianTime(repetitions, [&]() {
+            VoxelData voxelData = VoxelLoader::loadVoxelData(BENCHMARK_FILENAME, VoxelDataAxis::Z_Up, threadCount);
+            freeVoxelData(voxelData);
+        });
+
+        // The axis swap alone, from memory to memory
+        std::vector<uint8_t> source(worldSize), destination(worldSize);
+        for(size_t i = 0; i < worldSize; ++i) source[i] = (uint8_t)(i * 2654435761u >> 24);
+        double oldSwapTime = medianTime(repetitions, [&]() { transposeZUpReference(source.data(), destination.data(), width, width, width); });
+        double newSwapTime = medianTime(repetitions, [&]() { VoxelLoader::transposeZUp(source.data(), destination.data(), width, width, width, threadCount); });
+
+        std::printf("%-6u %14.1f %14.1f %16.1f %16.1f\n", width, oldLoadTime, newLoadTime, oldSwapTime, newSwapTime);
+    }
+
+    std::remove(BENCHMARK_FILENAME);
+    return 0;
+}
+
+// Writes a width^3 XRAW world with 8 bit indices and an 8 bit RGBA palette
+bool writeWorld(const char* filename, unsigned int width) {
+    std::ofstream file(filename, std::ios::binary | std::ios::out | std::ios::trunc);
+    if(!file.is_open()) return false;
+
+    uint8_t header[24] = { 'X', 'R', 'A', 'W', 0, 4, 8, 8 };
+    uint32_t sizes[4] = { width, width, width, 256 };
+    std::memcpy(header + 8, sizes, sizeof(sizes));
+    file.write((const char*)header, sizeof(header));
+
+    // Terrain with a height that varies along x and z, so that the layers differ from each other
+    std::vector<uint8_t> layer((size_t)width * width);
+    for(unsigned int layerIndex = 0; layerIndex < width; ++layerIndex) {
+        for(unsigned int row = 0; row < width; ++row) {
+            for(unsigned int x = 0; x < width; ++x) {
+                unsigned int height = (x * 7 + row * 3) % width;
+                layer[x + row * width] = (layerIndex < height) ? (uint8_t)(1 + (x ^ row ^ layerIndex) % 255) : 0;
+            }
+        }
+        file.write((const char*)layer.data(), layer.size());
+    }
+
+    uint8_t palette[256 * 4];
+    for(unsigned int i = 0; i < sizeof(palette); ++i) palette[i] = (uint8_t)(i * 37);
+    file.write((const char*)palette, sizeof(palette));
+    return file.good();
+}
+
+// The loader as it was before it mapped the file, only the parts of it that Z_Up XRAW worlds with an 8 bit palette use
+VoxelData loadVoxelDataReference(const char* filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::in | std::ios::ate);
+    if(!file.is_open()) return {nullptr, 0, 0, 0, nullptr};
+
+    std::streampos fileSize = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    uint8_t* fileBuffer = new uint8_t[fileSize];
+    file.read((char*)fileBuffer, fileSize);
+    file.close();
+
+    uint32_t sizes[3];
+    std::memcpy(sizes, fileBuffer + 8, sizeof(sizes));
+    uint8_t* voxelDataBuffer = new uint8_t[(size_t)sizes[0] * sizes[1] * sizes[2]];
+    transposeZUpReference(fileBuffer + 24, voxelDataBuffer, sizes[0], sizes[1], sizes[2]);
+
+    const uint8_t* paletteBuffer = fileBuffer + 24 + (size_t)sizes[0] * sizes[1] * sizes[2];
+    float* paletteData = new float[256 * 3];
+    for(unsigned int colorIndex = 0; colorIndex < 256; ++colorIndex) {
+        for(unsigned int channelIndex = 0; channelIndex < 3; ++channelIndex) {
+            paletteData[colorIndex * 3 + channelIndex] = paletteBuffer[colorIndex * 4 + channelIndex] / 255.0;
+        }
+    }
+
+    delete[] fileBuffer;
+    return {voxelDataBuffer, sizes[0], sizes[1], sizes[2], paletteData};
+}
+
+void transposeZUpReference(const uint8_t* source, uint8_t* destination, unsigned int sizeX, unsigned int sizeY, unsigned int sizeZ) {
+    for(size_t z = 0; z < sizeZ; ++z) {
+        for(size_t y = 0; y < sizeY; ++y) {
+            for(size_t x = 0; x < sizeX; ++x) {
+                destination[x + y * sizeX + z * sizeX * sizeY] = source[x + z * sizeX + y * sizeX * sizeZ];
+            }
+        }
+    }
+}
\ No newline at end of file
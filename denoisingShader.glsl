@@ -20,11 +20,11 @@ uniform sampler2D u_frameTexture;
 uniform sampler2D u_albedoTexture;
 uniform sampler2D u_normalTexture;
 uniform sampler2D u_posTexture;
+uniform usampler2D u_visibilityTexture;
+
+#include "frameData.glsl"
+#include "gBuffer.glsl"
 
-uniform vec2 u_windowSize;
-uniform float u_colorWeightScaler;
-uniform float u_normalWeightScaler;
-uniform float u_posWeightScaler;
 uniform float u_scale;
 
 float kernel[3][3] = {
@@ -36,35 +36,35 @@ float kernel[3][3] = {
 void main() {
     vec2 pixelSize = 1.0 / u_windowSize;
 
+    // The frame is at the window resolution and the g buffer at the render resolution
     vec3 c0 = texture(u_frameTexture, fragPos).rgb;
-    vec3 albedo = texture(u_albedoTexture, fragPos).rgb;
-    vec3 normal = texture(u_normalTexture, fragPos).xyz;
-    vec3 pos = texture(u_posTexture, fragPos).xyz;
+    gBufferData gbd = readGBuffer(u_albedoTexture, u_normalTexture, u_posTexture, u_visibilityTexture, getGBufferPixel(fragPos));
+    vec3 albedo = gbd.albedo;
+    vec3 normal = gbd.normal;
+    vec3 pos = gbd.pos;
 
-    float colorWeightScaler = u_colorWeightScaler;
-    float normalWeightScaler = u_normalWeightScaler;
-    float posWeightScaler = u_posWeightScaler;
+    float colorWeightScaler = u_denoisingColorWeightScaler;
+    float normalWeightScaler = u_denoisingNormalWeightScaler;
+    float posWeightScaler = u_denoisingPosWeightScaler;
 
     vec3 c1 = vec3(0.0);
     float k = 0.0;
     for(int dy = 0; dy < 3; ++dy) {
         for(int dx = 0; dx < 3; ++dx) {
             vec2 screenPos = fragPos + vec2(dx - 1.0, dy - 1.0) * pixelSize * u_scale;
+            gBufferData other = readGBuffer(u_albedoTexture, u_normalTexture, u_posTexture, u_visibilityTexture, getGBufferPixel(screenPos));
 
             float h = float(kernel[dy][dx]);
 
-            vec3 otherAlbedo = texture(u_albedoTexture, screenPos).rgb;
-            vec3 albedoDiff = albedo - otherAlbedo;
+            vec3 albedoDiff = albedo - other.albedo;
             float albedoDistSqr = dot(albedoDiff, albedoDiff);
             float weightAlbedo = min(exp(-albedoDistSqr / colorWeightScaler), 1.0);
 
-            vec3 otherNormal = texture(u_normalTexture, screenPos).xyz;
-            vec3 normalDiff = normal - otherNormal;
+            vec3 normalDiff = normal - other.normal;
             float normalDistSqr = dot(normalDiff, normalDiff);
             float weightNormal = min(exp(-normalDistSqr / normalWeightScaler), 1.0);
 
-            vec3 otherPos = texture(u_posTexture, screenPos).xyz;
-            vec3 posDiff = pos - otherPos;
+            vec3 posDiff = pos - other.pos;
             float posDistSqr = dot(posDiff, posDiff);
             float weightPos = min(exp(-posDistSqr / posWeightScaler), 1.0);
 
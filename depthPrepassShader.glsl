@@ -0,0 +1,160 @@
+#section compute
+#version 430 core
+
+// Finds a distance for every DEPTH_PREPASS_TILE_WIDTH x DEPTH_PREPASS_TILE_WIDTH tile of the screen that none of the tile's primary rays can
+//  hit a voxel before. All rays of a tile start at the camera and stay inside a cone around the ray through the tile's center: at distance
+//  't' they are closer than 't * coneSpread' to the center ray. The center ray is marched through empty octree nodes and every step is
+//  only taken if the box around the cone over that step contains no voxels, so the distance is conservative for every ray in the tile.
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (r32f, binding = 0) uniform writeonly image2D u_depthPrepass;
+
+#include "frameData.glsl"
+
+#include "octreeTraversal.glsl"
+
+const int MAX_PREPASS_ITERATIONS = 64;
+const int MAX_STEP_HALVINGS = 6;
+const int REGION_STACK_SIZE = 64;
+const int MAX_REGION_SUB_BLOCKS = 64;
+
+// Returns true if none of the sub-blocks of the chunk that overlap the box are occupied. 'chunkMin' is the corner of the chunk.
+bool isChunkRegionEmpty(uint chunkDataIndex, vec3 chunkMin, vec3 boxMin, vec3 boxMax) {
+    ivec3 lastSubBlock = ivec3(subBlocksPerRow - 1u);
+    ivec3 minSubBlock = clamp(ivec3(floor((boxMin - chunkMin) / float(SUB_BLOCK_WIDTH))), ivec3(0), lastSubBlock);
+    ivec3 maxSubBlock = clamp(ivec3(floor((boxMax - chunkMin) / float(SUB_BLOCK_WIDTH))), ivec3(0), lastSubBlock);
+
+    // Too many sub-blocks to check, assume that the box is not empty
+    ivec3 subBlockCount = maxSubBlock - minSubBlock + ivec3(1);
+    if(subBlockCount.x * subBlockCount.y * subBlockCount.z > MAX_REGION_SUB_BLOCKS) return false;
+
+    for(int z = minSubBlock.z; z <= maxSubBlock.z; ++z) {
+        for(int y = minSubBlock.y; y <= maxSubBlock.y; ++y) {
+            for(int x = minSubBlock.x; x <= maxSubBlock.x; ++x) {
+                if(isSubBlockOccupied(chunkDataIndex, ivec3(x, y, z))) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Returns true if no voxel is inside the box given in world coordinates. Voxels are only resolved down to the occupancy of the sub-blocks
+//  of chunks, and the box may reach outside the world.
+bool isRegionEmpty(vec3 boxMin, vec3 boxMax) {
+    uint nodeStack[REGION_STACK_SIZE];
+    vec4 nodeBoundsStack[REGION_STACK_SIZE]; // Center and half width of the node
+    nodeStack[0] = 0u;
+    nodeBoundsStack[0] = vec4(0.0, 0.0, 0.0, u_worldWidth * 0.5);
+    int stackSize = 1;
+
+    while(stackSize > 0) {
+        stackSize--;
+        OctreeNode node = octreeNodes[nodeStack[stackSize]];
+        vec4 nodeBounds = nodeBoundsStack[stackSize];
+
+        if(node.childMasks == 0u) {
+            if((node.data & CHUNK_FLAG) != 0u) {
+                if(!isChunkRegionEmpty(node.data & ~CHUNK_FLAG, nodeBounds.xyz - vec3(nodeBounds.w), boxMin, boxMax)) return false;
+            }
+            else if(node.data != 0u) return false;
+            continue;
+        }
+
+        float qWidth = nodeBounds.w * 0.5;
+        for(uint childIndex = 0u; childIndex < 8u; ++childIndex) {
+            uint childBit = 1u << childIndex;
+            if((node.childMasks & childBit) == 0u) continue;
+
+            vec3 childCenter = nodeBounds.xyz + vec3(((childIndex & 1u) != 0u) ? qWidth : -qWidth, ((childIndex & 2u) != 0u) ? qWidth : -qWidth, ((childIndex & 4u) != 0u) ? qWidth : -qWidth);
+            if(any(greaterThan(childCenter - vec3(qWidth), boxMax)) || any(lessThan(childCenter + vec3(qWidth), boxMin))) continue;
+
+            // Too many nodes to check, assume that the box is not empty
+            if(stackSize == REGION_STACK_SIZE) return false;
+            nodeStack[stackSize] = node.data + bitCount(node.childMasks & (childBit - 1u));
+            nodeBoundsStack[stackSize] = vec4(childCenter, qWidth);
+            stackSize++;
+        }
+    }
+    return true;
+}
+
+// The rays of the g buffer are offset by the jitter, so the tiles are as well
+vec2 getScreenSpaceCoordinates(vec2 pixelPos) {
+    return (pixelPos + u_jitter) / u_renderSize - vec2(0.5, 0.5);
+}
+
+void main() {
+    ivec2 tile = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 tileCount = (ivec2(u_renderSize) + ivec2(DEPTH_PREPASS_TILE_WIDTH - 1u)) / int(DEPTH_PREPASS_TILE_WIDTH);
+    if(tile.x >= tileCount.x || tile.y >= tileCount.y) return;
+
+    vec3 cameraPos = vec3(u_cameraPos);
+    float aspectRatio = u_windowSize.x / float(u_windowSize.y);
+    float hWorldWidth = u_worldWidth / 2.0;
+
+    // The primary rays are not traced at all when the camera is outside the world
+    if(any(lessThanEqual(cameraPos, vec3(-hWorldWidth))) || any(greaterThanEqual(cameraPos, vec3(hWorldWidth)))) {
+        imageStore(u_depthPrepass, tile, vec4(0.0));
+        return;
+    }
+
+    vec2 tileMin = vec2(tile * int(DEPTH_PREPASS_TILE_WIDTH));
+    vec2 tileMax = min(tileMin + vec2(DEPTH_PREPASS_TILE_WIDTH), u_renderSize);
+    vec3 rayDir = getCameraRayDir(getScreenSpaceCoordinates((tileMin + tileMax) * 0.5), u_cameraRotMatrix, aspectRatio, u_fov);
+    vec3 invRayDir = 1.0 / rayDir;
+
+    // The ray with the largest angle to the center ray goes through one of the tile's corners. The spread is increased slightly so that
+    //  rounding can not make the cone too narrow.
+    float coneSpread = 0.0;
+    for(int corner = 0; corner < 4; ++corner) {
+        vec2 cornerPos = vec2(((corner & 1) != 0) ? tileMax.x : tileMin.x, ((corner & 2) != 0) ? tileMax.y : tileMin.y);
+        vec3 cornerRayDir = getCameraRayDir(getScreenSpaceCoordinates(cornerPos), u_cameraRotMatrix, aspectRatio, u_fov);
+        coneSpread = max(coneSpread, length(cornerRayDir - rayDir));
+    }
+    coneSpread *= 1.01;
+
+    float rayLength = 0.0;
+    for(int iteration = 0; iteration < MAX_PREPASS_ITERATIONS; ++iteration) {
+        vec3 pos = cameraPos + rayDir * rayLength;
+
+        // The node is looked up slightly ahead so that a position on the boundary of the previous node finds the next one
+        uint depth = 0u;
+        vec3 localNodePos = cameraPos + rayDir * (rayLength + 0.05);
+        if(any(lessThanEqual(localNodePos, vec3(-hWorldWidth))) || any(greaterThanEqual(localNodePos, vec3(hWorldWidth)))) break;
+        vec3 nodeCenterPos = localNodePos;
+        uint leafData = getOctreeNode(depth, localNodePos);
+        nodeCenterPos -= localNodePos;
+        float nodeWidth = u_worldWidth / pow(2, depth);
+
+        // Inside a chunk the steps go from sub-block to sub-block, whether they are empty is left to the region check
+        if((leafData & CHUNK_FLAG) != 0u) {
+            vec3 chunkMin = nodeCenterPos - vec3(nodeWidth * 0.5);
+            vec3 subBlockMin = chunkMin + floor((localNodePos + vec3(nodeWidth * 0.5)) / float(SUB_BLOCK_WIDTH)) * float(SUB_BLOCK_WIDTH);
+            nodeWidth = float(SUB_BLOCK_WIDTH);
+            nodeCenterPos = subBlockMin + vec3(nodeWidth * 0.5);
+        }
+        else if(leafData != 0u) break;
+
+        // Distance to where the center ray leaves the empty node or sub-block
+        vec3 exitPlanes = nodeCenterPos + vec3((rayDir.x >= 0) ? nodeWidth : -nodeWidth, (rayDir.y >= 0) ? nodeWidth : -nodeWidth, (rayDir.z >= 0) ? nodeWidth : -nodeWidth) * 0.5;
+        vec3 exitDistances = (exitPlanes - cameraPos) * invRayDir;
+        float stepLength = min(min(exitDistances.x, exitDistances.y), exitDistances.z) - rayLength;
+
+        // The box around a long diagonal step is much larger than the cone, so steps that fail are retried with half the length
+        bool stepTaken = false;
+        for(int halving = 0; halving < MAX_STEP_HALVINGS && !stepTaken; ++halving) {
+            float nextRayLength = rayLength + stepLength;
+            vec3 nextPos = cameraPos + rayDir * nextRayLength;
+            vec3 coneRadius = vec3(nextRayLength * coneSpread);
+            if(isRegionEmpty(min(pos, nextPos) - coneRadius, max(pos, nextPos) + coneRadius)) {
+                rayLength = nextRayLength;
+                stepTaken = true;
+            }
+            stepLength *= 0.5;
+        }
+        if(!stepTaken) break;
+    }
+
+    // One voxel is left as margin so that the start position is never rounded into a voxel
+    imageStore(u_depthPrepass, tile, vec4(max(rayLength - 1.0, 0.0)));
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+// Constants shared by every pass of a frame, filled from the FrameData struct in FrameData.h
+layout(std140, binding = 0) uniform FrameData {
+    mat3 u_cameraRotMatrix;
+    mat3 u_prevCameraRotMatrix;
+    vec3 u_cameraPos;
+    float u_fov;
+    vec3 u_prevCameraPos;
+    float u_frame;
+    vec2 u_windowSize;
+    vec2 u_noiseTextureScale;
+    vec2 u_renderSize; // The g buffer, ambient occlusion and lighting passes only fill the bottom left u_renderSize of their textures
+    vec2 u_prevRenderSize;
+    vec2 u_jitter; // Offset of the primary rays from the pixel centers in pixels, zero when the resolution is not dynamic
+    vec2 u_prevJitter;
+    float u_taaAlpha;
+    float u_taaDistWeightScaler;
+    float u_taaNormalWeightScaler;
+    float u_taaColorWeightScaler;
+    float u_denoisingColorWeightScaler;
+    float u_denoisingNormalWeightScaler;
+    float u_denoisingPosWeightScaler;
+    uint u_depthPrepassEnabled;
+    uint u_reprojectionEnabled;
+    uint u_octreeRopesEnabled;
+    uint u_aoResolutionScale; // 1, 2 or 4, the ambient occlusion is traced for one pixel in every u_aoResolutionScale^2
+    uint u_visibilityBufferEnabled; // The g buffer is packed into the visibility texture, see gBuffer.glsl
+};
\ No newline at end of file
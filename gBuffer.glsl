@@ -0,0 +1,100 @@
+// The g buffer of the primary rays, shared by the shaders that write and read it. The including shader includes frameData.glsl first.
+//  Normally the g buffer is three textures with the albedo, normal and position of every pixel, 32 bytes per pixel. When
+//  u_visibilityBufferEnabled is set it is one RG32UI texture instead. It holds the distance to the hit in the first channel, and the palette
+//  index in bits 0-7 and the face in bits 8-10 of the second. The rest is rebuilt from the camera that the pixel was rendered with.
+
+uniform vec3 u_palette[256];
+
+struct gBufferData {
+    vec3 albedo;
+    vec3 normal;
+    vec3 pos;
+    uint voxelID;
+    float distance; // Distance along the ray from its origin to the hit, or -1 if nothing was hit
+};
+
+vec3 getCameraRayDir(vec2 screenSpaceCoordinates, mat3 cameraRotMatrix, float aspectRatio, float fov) {
+    vec3 rayDirCamera;
+    rayDirCamera.x = screenSpaceCoordinates.x * tan(fov) * aspectRatio;
+    rayDirCamera.y = screenSpaceCoordinates.y * tan(fov);
+    rayDirCamera.z = -1.0;
+    rayDirCamera = normalize(rayDirCamera);
+
+    return cameraRotMatrix * rayDirCamera;
+}
+
+// Returns the g buffer pixel whose ray is closest to a position on the screen, from 0 to 1
+ivec2 getGBufferPixel(vec2 screenPos) {
+    return ivec2(clamp(floor(screenPos * u_renderSize - u_jitter), vec2(0.0), u_renderSize - vec2(1.0)));
+}
+
+// The face is the axis of the normal times two, plus one if the normal points in the positive direction. A ray that starts inside a voxel
+//  has no normal, which is face 6. Rays that hit nothing have the palette index zero.
+uvec2 packGBufferData(gBufferData gbd) {
+    if(gbd.voxelID == 0u) return uvec2(0u);
+
+    vec3 absNormal = abs(gbd.normal);
+    uint face = 6u;
+    if(max(absNormal.x, max(absNormal.y, absNormal.z)) > 0.5) {
+        uint axis = (absNormal.x > 0.5) ? 0u : ((absNormal.y > 0.5) ? 1u : 2u);
+        face = axis * 2u + ((gbd.normal[axis] > 0.0) ? 1u : 0u);
+    }
+    return uvec2(floatBitsToUint(gbd.distance), gbd.voxelID | (face << 8u));
+}
+
+// The ray is rebuilt the same way as in shader.glsl and gBufferComputeShader.glsl, so the position is the same as the one they found
+gBufferData unpackGBufferData(uvec2 visibility, ivec2 pixel, vec3 cameraPos, mat3 cameraRotMatrix, vec2 jitter, vec2 renderSize) {
+    gBufferData result;
+    result.voxelID = visibility.y & 0xFFu;
+    if(result.voxelID == 0u) {
+        result.albedo = vec3(-1.0, -1.0, -1.0);
+        result.normal = vec3(0.0, 0.0, 0.0);
+        result.pos = vec3(0.0, 0.0, 0.0);
+        result.distance = -1.0;
+        return result;
+    }
+
+    float aspectRatio = u_windowSize.x / float(u_windowSize.y);
+    vec2 screenSpaceCoordinates = (vec2(pixel) + vec2(0.5) + jitter) / renderSize - vec2(0.5, 0.5);
+    vec3 rayDir = getCameraRayDir(screenSpaceCoordinates, cameraRotMatrix, aspectRatio, u_fov);
+
+    uint face = (visibility.y >> 8u) & 7u;
+    result.distance = uintBitsToFloat(visibility.x);
+    result.albedo = u_palette[result.voxelID];
+    result.normal = vec3(0.0);
+    if(face < 6u) result.normal[face / 2u] = ((face & 1u) != 0u) ? 1.0 : -1.0;
+    result.pos = cameraPos + result.distance * rayDir;
+    return result;
+}
+
+// Returns the normal and position of a pixel of this frame's g buffer, for the shaders that have no albedo texture bound. The albedo is
+//  only set when u_visibilityBufferEnabled is set.
+gBufferData readGBufferGeometry(sampler2D normalTexture, sampler2D posTexture, usampler2D visibilityTexture, ivec2 pixel) {
+    if(u_visibilityBufferEnabled != 0u) {
+        return unpackGBufferData(texelFetch(visibilityTexture, pixel, 0).rg, pixel, u_cameraPos, u_cameraRotMatrix, u_jitter, u_renderSize);
+    }
+
+    gBufferData result;
+    result.normal = texelFetch(normalTexture, pixel, 0).xyz;
+    result.pos = texelFetch(posTexture, pixel, 0).xyz;
+    return result;
+}
+
+// Returns the albedo, normal and position of a pixel of this frame's g buffer
+gBufferData readGBuffer(sampler2D albedoTexture, sampler2D normalTexture, sampler2D posTexture, usampler2D visibilityTexture, ivec2 pixel) {
+    gBufferData result = readGBufferGeometry(normalTexture, posTexture, visibilityTexture, pixel);
+    if(u_visibilityBufferEnabled == 0u) result.albedo = texelFetch(albedoTexture, pixel, 0).rgb;
+    return result;
+}
+
+// Returns the normal and position of a pixel of the previous frame's g buffer, there is no history of the albedo
+gBufferData readPrevGBuffer(sampler2D normalTexture, sampler2D posTexture, usampler2D visibilityTexture, ivec2 pixel) {
+    if(u_visibilityBufferEnabled != 0u) {
+        return unpackGBufferData(texelFetch(visibilityTexture, pixel, 0).rg, pixel, u_prevCameraPos, u_prevCameraRotMatrix, u_prevJitter, u_prevRenderSize);
+    }
+
+    gBufferData result;
+    result.normal = texelFetch(normalTexture, pixel, 0).xyz;
+    result.pos = texelFetch(posTexture, pixel, 0).xyz;
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#section compute
+#version 430 core
+
+// Every work group traces one TILE_WIDTH x TILE_WIDTH tile of the screen. The invocations of a group are mapped to the pixels of the tile in
+//  Morton order, so invocations that run together trace neighbouring rays which mostly visit the same nodes and chunks. The local size has
+//  to be TILE_WIDTH * TILE_WIDTH, and main.cpp dispatches one group per tile.
+const uint TILE_WIDTH = 8u;
+layout (local_size_x = 64) in;
+
+layout (rgba16f, binding = 0) uniform writeonly image2D u_gAlbedo;
+layout (rgba16f, binding = 1) uniform writeonly image2D u_gNormal;
+layout (rgba32f, binding = 2) uniform writeonly image2D u_gPos;
+layout (rg32ui, binding = 3) uniform writeonly uimage2D u_gVisibility;
+
+#include "frameData.glsl"
+
+// Distance that the rays of each tile can start at, written by the depth prepass
+uniform sampler2D u_depthPrepass;
+// Distances to the hits of the previous frame reprojected into this frame, written by reprojectionShader.glsl
+uniform usampler2D u_reprojectedDistance;
+
+#include "octreeTraversal.glsl"
+
+// Returns the even bits of 'x' packed together, which turns a Morton code into its x coordinate (and 'x >> 1' into its y coordinate)
+uint compactBits(uint x) {
+    x &= 0x55555555u;
+    x = (x | (x >> 1)) & 0x33333333u;
+    x = (x | (x >> 2)) & 0x0F0F0F0Fu;
+    x = (x | (x >> 4)) & 0x00FF00FFu;
+    x = (x | (x >> 8)) & 0x0000FFFFu;
+    return x;
+}
+
+void main() {
+    uint mortonIndex = gl_LocalInvocationIndex;
+    ivec2 pixel = ivec2(gl_WorkGroupID.xy * TILE_WIDTH + uvec2(compactBits(mortonIndex), compactBits(mortonIndex >> 1)));
+    if(pixel.x >= int(u_renderSize.x) || pixel.y >= int(u_renderSize.y)) return;
+
+    vec3 pos = vec3(u_cameraPos);
+
+    // The ray goes through the center of the pixel, the same as gl_FragCoord in the fragment shader
+    float aspectRatio = u_windowSize.x / float(u_windowSize.y);
+    vec2 screenSpaceCoordinates = (vec2(pixel) + vec2(0.5) + u_jitter) / u_renderSize - vec2(0.5, 0.5);
+
+    vec3 rayDir = getCameraRayDir(screenSpaceCoordinates, u_cameraRotMatrix, aspectRatio, u_fov);
+
+    float startDistance = (u_depthPrepassEnabled != 0u) ? texelFetch(u_depthPrepass, pixel / int(DEPTH_PREPASS_TILE_WIDTH), 0).r : 0.0;
+    float reprojectedStartDistance = (u_reprojectionEnabled != 0u) ? getReprojectedStartDistance(u_reprojectedDistance, pixel) : 0.0;
+
+    gBufferData gbd = getGBufferData(pos, rayDir, max(startDistance, reprojectedStartDistance), 100);
+
+    // If the ray hit the voxel it started in, the reprojected start was inside geometry that the previous frame did not see, so the ray is
+    //  traced again from the start that does not depend on the previous frame
+    if(reprojectedStartDistance > startDistance && gbd.distance == reprojectedStartDistance) {
+        gbd = getGBufferData(pos, rayDir, startDistance, 100);
+    }
+    if(u_visibilityBufferEnabled != 0u) {
+        imageStore(u_gVisibility, pixel, uvec4(packGBufferData(gbd), 0u, 0u));
+    }
+    else {
+        imageStore(u_gAlbedo, pixel, vec4(gbd.albedo, 1.0));
+        imageStore(u_gNormal, pixel, vec4(gbd.normal, 1.0));
+        imageStore(u_gPos, pixel, vec4(gbd.pos, 1.0));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,308 @@
+// Octree traversal shared by the G-buffer shaders, the depth prepass and the lighting shader. The including shader includes frameData.glsl and declares its
+//  outputs, the include is resolved by Shader before the source is compiled.
+
+#include "gBuffer.glsl"
+
+// Bits 0-7 of 'childMasks' are set for the children that are not empty and bits 8-15 for the children that are leaves. Only the children that
+//  are not empty are stored, next to each other starting at index 'data'. For a leaf 'childMasks' is zero and 'data' is the palette index of
+//  its color, or the index of its chunk in chunkData with CHUNK_FLAG set. When the octree has been converted to a DAG a node can be shared by
+//  several parents, so the ropes are only used for trees and otherwise the traversal descends from the root.
+struct OctreeNode {
+    uint childMasks;
+    uint data;
+};
+
+const uint CHUNK_FLAG = 0x80000000u;
+
+layout(std430, binding = 0) buffer OctreeSSBO {
+    OctreeNode octreeNodes[];
+};
+
+layout(std430, binding = 1) buffer ChunkDataSSBO {
+    uint chunkData[];
+};
+
+// Six ropes per node in the order -x, +x, -y, +y, -z, +z, built by Octree::buildRopes. A rope holds the index of the deepest node that
+//  contains the region of the same size on the other side of the face, with the depth of that node in the bits above ROPE_DEPTH_SHIFT, or
+//  NO_ROPE on the edge of the world. Only read when u_octreeRopesEnabled is set.
+layout(std430, binding = 2) buffer OctreeRopesSSBO {
+    uint octreeRopes[];
+};
+
+const uint ROPE_DEPTH_SHIFT = 27u;
+const uint NO_ROPE = 0xFFFFFFFFu;
+
+uniform uint u_worldWidth;
+uniform uint u_maxOctreeDepth;
+uniform uint u_chunkWidth;
+
+
+uint chunkWidthSquared = u_chunkWidth * u_chunkWidth;
+
+// Every chunk has an occupancy mask with one bit per sub-block of SUB_BLOCK_WIDTH^3 voxels, set if any voxel in the sub-block is not empty
+const uint SUB_BLOCK_WIDTH = 4u;
+uint subBlocksPerRow = (u_chunkWidth + SUB_BLOCK_WIDTH - 1u) / SUB_BLOCK_WIDTH;
+uint occupancyWords = (subBlocksPerRow * subBlocksPerRow * subBlocksPerRow + 31u) >> 5;
+
+// Returns true if any voxel in the sub-block at 'iSubBlockPos' is not empty.
+bool isSubBlockOccupied(uint chunkDataIndex, ivec3 iSubBlockPos) {
+    uint subBlockID = iSubBlockPos.x + (iSubBlockPos.y + iSubBlockPos.z * subBlocksPerRow) * subBlocksPerRow;
+    return (chunkData[(chunkDataIndex >> 2) + 1u + (subBlockID >> 5)] & (1u << (subBlockID & 31u))) != 0u;
+}
+
+// Returns the palette index of a voxel in a chunk. 'chunkDataIndex' is the byte index of the chunk, which starts with a header word holding the
+//  bits per voxel index and the size of the chunk's local palette, followed by the occupancy mask, the local palette (one byte per color,
+//  padded to a whole word) and the voxel indices packed from the lowest bit of each word. A chunk without a local palette stores the palette
+//  indices directly.
+uint getVoxelByte(uint chunkDataIndex, ivec3 iLocalPos) {
+    uint localVoxelID = iLocalPos.x + iLocalPos.y * u_chunkWidth + iLocalPos.z * chunkWidthSquared;
+
+    uint chunkWordIndex = chunkDataIndex >> 2;
+    uint header = chunkData[chunkWordIndex];
+    uint bitsPerIndex = header & 0xFFu;
+    uint paletteSize = header >> 8;
+
+    // The indices never cross a word since the bits per index is 1, 2, 4 or 8
+    uint bitIndex = localVoxelID * bitsPerIndex;
+    uint paletteWordIndex = chunkWordIndex + 1u + occupancyWords;
+    uint indicesWordIndex = paletteWordIndex + ((paletteSize + 3u) >> 2);
+    uint index = (chunkData[indicesWordIndex + (bitIndex >> 5)] >> (bitIndex & 31u)) & ((1u << bitsPerIndex) - 1u);
+    if(paletteSize == 0u) return index;
+
+    // Each palette color is one byte but we index it as a uint, so the index is divided by 4 and the appropriate byte is returned.
+    uint paletteWord = chunkData[paletteWordIndex + (index >> 2)];
+    return (paletteWord >> ((index % 4u) << 3)) & uint(0x000000FF);
+}
+
+// Finds the leaf containing the given position, starting from the root, and returns its data (zero if the leaf is empty).
+//  'depth' must be zero. The depth of the leaf in the octree is returned in this variable.
+//  'pos' must be in global coordinates. The provided position in local space of the leaf, (0,0) being its center, is returned in this variable.
+uint getOctreeNode(inout uint depth, inout vec3 pos) {
+    OctreeNode node = octreeNodes[0];
+    while(node.childMasks != 0u) {
+        int childIndex = ((pos.x >= 0) ? 1 : 0) + ((pos.y >= 0) ? 1 : 0) * 2 + ((pos.z >= 0) ? 1 : 0) * 4;
+
+        float qWidth = u_worldWidth / pow(2, depth + 2);
+        pos.x += qWidth * ((pos.x >= 0) ? -1 : 1);
+        pos.y += qWidth * ((pos.y >= 0) ? -1 : 1);
+        pos.z += qWidth * ((pos.z >= 0) ? -1 : 1);
+
+        depth++;
+        uint childBit = 1u << childIndex;
+        if((node.childMasks & childBit) == 0u) return 0u;
+
+        // The children are packed, so the child index is the number of non empty children before it
+        node = octreeNodes[node.data + bitCount(node.childMasks & (childBit - 1u))];
+    }
+    return node.data;
+}
+
+// The deepest node that contained the last position found with getOctreeNodeFromCursor, where the next search starts
+struct OctreeCursor {
+    uint nodeIndex;
+    uint depth;
+    vec3 center;
+};
+
+const OctreeCursor ROOT_CURSOR = OctreeCursor(0u, 0u, vec3(0.0));
+
+// Does the same as getOctreeNode, but starts from the node of 'cursor' instead of the root. A position that has left the node through one of
+//  its faces is found from the node that the rope of that face points to, and one that left across an edge or corner from the root. The
+//  cursor is moved to the deepest node containing 'pos', so that the next position along a ray is usually found in a few steps.
+uint getOctreeNodeFromCursor(inout OctreeCursor cursor, out uint depth, inout vec3 pos) {
+    vec3 offset = pos - cursor.center;
+    bvec3 outside = greaterThan(abs(offset), vec3(float(u_worldWidth >> cursor.depth) * 0.5));
+    if(any(outside)) {
+        uint rope = NO_ROPE;
+        if(int(outside.x) + int(outside.y) + int(outside.z) == 1) {
+            uint axis = outside.x ? 0u : (outside.y ? 1u : 2u);
+            rope = octreeRopes[cursor.nodeIndex * 6u + axis * 2u + ((offset[axis] > 0.0) ? 1u : 0u)];
+        }
+
+        cursor = ROOT_CURSOR;
+        if(rope != NO_ROPE) {
+            cursor.nodeIndex = rope & ((1u << ROPE_DEPTH_SHIFT) - 1u);
+            cursor.depth = rope >> ROPE_DEPTH_SHIFT;
+            float width = float(u_worldWidth >> cursor.depth);
+            if(cursor.depth != 0u) cursor.center = floor(pos / width) * width + vec3(width * 0.5);
+        }
+    }
+
+    depth = cursor.depth;
+    pos -= cursor.center;
+    OctreeNode node = octreeNodes[cursor.nodeIndex];
+    while(node.childMasks != 0u) {
+        int childIndex = ((pos.x >= 0) ? 1 : 0) + ((pos.y >= 0) ? 1 : 0) * 2 + ((pos.z >= 0) ? 1 : 0) * 4;
+
+        float qWidth = u_worldWidth / pow(2, depth + 2);
+        vec3 childOffset = vec3((pos.x >= 0) ? qWidth : -qWidth, (pos.y >= 0) ? qWidth : -qWidth, (pos.z >= 0) ? qWidth : -qWidth);
+        pos -= childOffset;
+
+        depth++;
+        uint childBit = 1u << childIndex;
+        if((node.childMasks & childBit) == 0u) return 0u;
+
+        cursor.nodeIndex = node.data + bitCount(node.childMasks & (childBit - 1u));
+        cursor.depth = depth;
+        cursor.center += childOffset;
+        node = octreeNodes[cursor.nodeIndex];
+    }
+    return node.data;
+}
+
+// Calculates the center of the next voxel and the normal by traversing a ray starting on 'cameraPos' with direction 'rayDir'. 
+vec3 getNextVoxel(vec3 cubeCenterPos, inout vec3 normal, inout float rayLength, vec3 cameraPos, float cubeWidth, vec3 rayDir, vec3 invRayDir) {
+    // cameraPos + rayDir * dRay = cubeCenterPos +- width/2 <=> dRay = (cubeCenterPos +- width/2 - cameraPos) / rayDir
+    vec3 dPos = cubeCenterPos + vec3(((rayDir.x >= 0) ? cubeWidth : -cubeWidth), ((rayDir.y >= 0) ? cubeWidth : -cubeWidth), ((rayDir.z >= 0) ? cubeWidth : -cubeWidth)) * 0.5 - cameraPos;
+    vec3 dRay = dPos * invRayDir;
+
+    if(dRay.x < dRay.y && dRay.x < dRay.z) {
+        normal = vec3(-sign(rayDir.x), 0.0, 0.0);
+        rayLength = dRay.x;
+    }
+    else if(dRay.y < dRay.z) {
+        normal = vec3(0.0, -sign(rayDir.y), 0.0);
+        rayLength = dRay.y;
+    }
+    else {
+        normal = vec3(0.0, 0.0, -sign(rayDir.z));
+        rayLength = dRay.z;
+    }
+    cubeCenterPos = cameraPos + rayLength * rayDir - normal * 0.5;
+
+    return floor(cubeCenterPos) + vec3(0.5, 0.5, 0.5);
+}
+
+// Raymarches through a chunk and returns the paletteIndex of the first voxel hit, or zero if no voxels were hit. If a voxel was hit its local position, specified
+//  in chunk space, and the normal where the ray hit the voxel are returned in the arguments 'localVoxelPos' and 'normal'.
+//  localVoxelPos should always be the position of the center of a voxel. Empty sub-blocks are crossed in one step.
+uint getVoxelData(uint chunkDataIndex, inout vec3 localVoxelPos, inout vec3 normal, inout float rayLength, vec3 localCameraPos, vec3 rayDir, vec3 invRayDir) {
+    // A ray can not visit more than 3 * u_chunkWidth voxels before leaving the chunk
+    for(uint iteration = 0; iteration < 3u * u_chunkWidth; ++iteration) {
+        if(localVoxelPos.x < 0 || localVoxelPos.x >= u_chunkWidth || localVoxelPos.y < 0.0 || localVoxelPos.y >= u_chunkWidth || localVoxelPos.z < 0.0 || localVoxelPos.z >= u_chunkWidth) {
+            break;
+        }
+
+        ivec3 iLocalPos = ivec3(floor(localVoxelPos));
+        ivec3 iSubBlockPos = iLocalPos / int(SUB_BLOCK_WIDTH);
+        if(!isSubBlockOccupied(chunkDataIndex, iSubBlockPos)) {
+            vec3 subBlockPos = vec3(iSubBlockPos * int(SUB_BLOCK_WIDTH)) + vec3(SUB_BLOCK_WIDTH * 0.5); // position of the center of the sub-block
+            localVoxelPos = getNextVoxel(subBlockPos, normal, rayLength, localCameraPos, float(SUB_BLOCK_WIDTH), rayDir, invRayDir);
+            continue;
+        }
+
+        uint voxelByte = getVoxelByte(chunkDataIndex, iLocalPos);
+        if(voxelByte != 0) {
+            return voxelByte;
+        }
+
+        localVoxelPos = getNextVoxel(localVoxelPos, normal, rayLength, localCameraPos, 1.0, rayDir, invRayDir);        
+    }
+
+    return 0;
+}
+
+// Calculates the gBuffer data by raymarching through an octree. The march starts 'startDistance' along the ray, which must be known to be
+//  empty up to there. Distances are still measured from 'pos', so the result is the same as when starting at zero.
+gBufferData getGBufferData(vec3 pos, vec3 rayDir, float startDistance, uint maxIterations) {
+    gBufferData result;
+    
+    vec3 cameraPos = pos;
+    vec3 voxelPos = floor(pos + rayDir * startDistance) + vec3(0.5, 0.5, 0.5); // voxelPos is always in the center of a voxel
+    vec3 normal = vec3(1.0, 0.0, 0.0);
+    float rayLength = startDistance;
+
+    vec3 invRayDir = 1.0 / rayDir;
+    float hWorldWidth = u_worldWidth / 2.0;
+    OctreeCursor cursor = ROOT_CURSOR;
+
+    int iteration;
+    for(iteration = 0; iteration < maxIterations; ++iteration) {
+        if(voxelPos.x <= -hWorldWidth || voxelPos.x >= hWorldWidth || voxelPos.y <= -hWorldWidth || voxelPos.y >= hWorldWidth || voxelPos.z <= -hWorldWidth || voxelPos.z >= hWorldWidth) {
+            break;
+        }
+
+        uint currentDepth = 0;
+        vec3 localOctreeNodeVoxelPos = voxelPos;
+        uint leafData;
+        if(u_octreeRopesEnabled != 0u) leafData = getOctreeNodeFromCursor(cursor, currentDepth, localOctreeNodeVoxelPos);
+        else leafData = getOctreeNode(currentDepth, localOctreeNodeVoxelPos);
+
+        if((leafData & CHUNK_FLAG) != 0u) { // Search for voxel in current chunk
+            // localOctreeNodeVoxelPos is in the range [-width/2, width/2], we want to transform it into the range [0, width]
+            vec3 localVoxelPos = floor(localOctreeNodeVoxelPos + vec3(u_chunkWidth * 0.5)) + vec3(0.5);
+            uint voxelPaletteIndex = getVoxelData(leafData & ~CHUNK_FLAG, localVoxelPos, normal, rayLength, cameraPos + (localVoxelPos - voxelPos), rayDir, invRayDir);
+            if(voxelPaletteIndex != 0) {
+                result.albedo = u_palette[voxelPaletteIndex];
+                result.normal = normal;
+                result.pos = cameraPos + rayLength * rayDir;
+                result.voxelID = voxelPaletteIndex;
+                result.distance = rayLength;
+                return result;
+            }
+        }
+        else if(leafData != 0u) { // Every voxel in the current octree node is the same color
+            float octreeNodeWidth = u_worldWidth / pow(2, currentDepth);
+            vec3 localChunkPos = vec3(localOctreeNodeVoxelPos) + vec3(octreeNodeWidth) * 0.5;
+
+            result.albedo = u_palette[leafData];
+            result.pos = cameraPos + rayLength * rayDir;
+            result.normal = normal;
+            result.voxelID = leafData;
+            result.distance = rayLength;
+            return result;
+        }
+
+        float width = u_worldWidth / pow(2, currentDepth);
+        vec3 octreeNodePos = floor(voxelPos / width) * width + vec3(width * 0.5);  // position of the center of the current octreeNode
+
+        voxelPos = getNextVoxel(octreeNodePos, normal, rayLength, cameraPos, width, rayDir, invRayDir);
+    }
+
+    result.albedo = vec3(-1.0, -1.0, -1.0);
+    result.normal = vec3(0.0, 0.0, 0.0);
+    result.pos = vec3(0.0, 0.0, 0.0);
+    result.voxelID = 0;
+    result.distance = -1.0;
+    return result;
+}
+
+// Width in pixels of the screen tiles that the depth prepass finds a start distance for
+const uint DEPTH_PREPASS_TILE_WIDTH = 8u;
+
+// Value of the texels in the reprojected distance texture that no hit of the previous frame was reprojected to
+const uint NO_REPROJECTED_DISTANCE = 0xFFFFFFFFu;
+
+// Radius in pixels of the neighbourhood that a reprojected start distance is taken from, and the width of the screen border where the rays
+//  are always traced from the start since new geometry comes into view there
+const int REPROJECTION_RADIUS = 2;
+const int REPROJECTION_BORDER = 2;
+
+// Returns the distance that the ray of 'pixel' can start at, found from the hits of the previous frame that reprojectionShader.glsl has
+//  scattered into 'reprojectedDistance'. The closest hit in the neighbourhood is used, so that a surface which moved a pixel or is seen
+//  more from the side is not skipped. Zero is returned where the surface may not have been visible in the previous frame: near the edges of
+//  the screen, where a pixel in the neighbourhood got no hit, and at depth discontinuities where a closer object can have uncovered a face
+//  that the previous frame did not see.
+float getReprojectedStartDistance(usampler2D reprojectedDistance, ivec2 pixel) {
+    // Every frame one pixel in each 4x4 block is traced from the start, so that thin geometry which fell between the rays of the previous
+    //  frame is found within 16 frames even though its neighbours keep reprojecting the surface behind it
+    if((pixel.x & 3) + (pixel.y & 3) * 4 == (int(u_frame) & 15)) return 0.0;
+
+    ivec2 size = ivec2(u_renderSize);
+    if(any(lessThan(pixel, ivec2(REPROJECTION_BORDER))) || any(greaterThanEqual(pixel, size - ivec2(REPROJECTION_BORDER)))) return 0.0;
+
+    float minDistance = 3.402823e38;
+    float maxDistance = 0.0;
+    for(int y = -REPROJECTION_RADIUS; y <= REPROJECTION_RADIUS; ++y) {
+        for(int x = -REPROJECTION_RADIUS; x <= REPROJECTION_RADIUS; ++x) {
+            uint distanceBits = texelFetch(reprojectedDistance, pixel + ivec2(x, y), 0).r;
+            if(distanceBits == NO_REPROJECTED_DISTANCE) return 0.0;
+            minDistance = min(minDistance, uintBitsToFloat(distanceBits));
+            maxDistance = max(maxDistance, uintBitsToFloat(distanceBits));
+        }
+    }
+    if(maxDistance > minDistance * 1.1 + 2.0) return 0.0;
+
+    // The hits are on the faces of voxels, so the ray starts a bit more than a voxel in front of the closest one
+    return max(minDistance * 0.99 - 1.5, 0.0);
+}
\ No newline at end of file
@@ -16,9 +16,25 @@ void main() {
 out vec4 FragColor;
 
 uniform sampler2D u_frameTexture;
+uniform sampler2D u_gAlbedo;
+uniform sampler2D u_gNormal;
+uniform sampler2D u_gPos;
+uniform usampler2D u_gVisibility;
+// 0 shows the frame, 1 the albedo and 2 the normals of the g buffer, which is at the render resolution
+uniform int u_outputImage;
+
+#include "frameData.glsl"
+#include "gBuffer.glsl"
 
 in vec2 fragPos;
 
 void main() {
-    FragColor = texture(u_frameTexture, fragPos);
+    if(u_outputImage == 0) {
+        // The alpha channel of the TAA output is the weight of its history
+        FragColor = vec4(texture(u_frameTexture, fragPos).rgb, 1.0);
+        return;
+    }
+
+    gBufferData gbd = readGBuffer(u_gAlbedo, u_gNormal, u_gPos, u_gVisibility, getGBufferPixel(fragPos));
+    FragColor = vec4((u_outputImage == 1) ? gbd.albedo : gbd.normal, 1.0);
 }
\ No newline at end of file
@@ -38,6 +38,10 @@ project "VoxelRenderer"
 
 	defines "GLEW_STATIC"
 
+	-- The only file with AVX2 instructions, they are only run after checking that the CPU supports them
+	filter "files:src/OctreeRayCasterAVX2.cpp"
+		vectorextensions "AVX2"
+
 	filter "system:windows"
 		links "opengl32.lib"
 
@@ -52,4 +56,134 @@ project "VoxelRenderer"
 	filter "configurations:Release"
 		defines "VOXEL_RENDERER_RELEASE"
 		optimize "On"
-		runtime "Release"
\ No newline at end of file
+		runtime "Release"
+
+-- The command line tools, tests and benchmarks share these settings and only add their own files and include directories
+function consoleProject(name)
+	project(name)
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "c++17"
+	systemversion "latest"
+
+	targetdir "bin/%{cfg.buildcfg}"
+	objdir "bin-int/%{cfg.buildcfg}/%{prj.name}"
+
+	filter "system:linux"
+		linkoptions { "-lpthread" }
+
+	filter "configurations:Debug"
+		symbols "On"
+		runtime "Debug"
+
+	filter "configurations:Release"
+		optimize "On"
+		runtime "Release"
+
+	filter {}
+end
+
+-- The CPU ray caster and what it needs, with AVX2 enabled for the one file that uses it
+function useOctreeRayCaster()
+	files {
+		"src/Octree.h",
+		"src/Octree.cpp",
+		"src/OctreeRayCaster.h",
+		"src/OctreeRayCaster.cpp",
+		"src/OctreeRayCasterAVX2.cpp",
+		"src/ThreadPool.h",
+		"src/ThreadPool.cpp"
+	}
+
+	includedirs {
+		"src",
+		"vendor/GLM/glm/"
+	}
+
+	filter "files:src/OctreeRayCasterAVX2.cpp"
+		vectorextensions "AVX2"
+
+	filter {}
+end
+
+consoleProject "OctreeConverter"
+	files {
+		"tools/OctreeConverter.cpp",
+		"src/FileMapping.h",
+		"src/FileMapping.cpp",
+		"src/Octree.h",
+		"src/Octree.cpp",
+		"src/OctreeCache.h",
+		"src/OctreeCache.cpp",
+		"src/ThreadPool.h",
+		"src/ThreadPool.cpp",
+		"src/VoxelLoader.h",
+		"src/VoxelLoader.cpp"
+	}
+
+	includedirs {
+		"src"
+	}
+
+-- The benchmarks stay separate programs: each has its own command line and output, and VoxelBenchmarks writes JSON for comparing commits
+--  while the others print a table
+consoleProject "VoxelLoaderBenchmark"
+	files {
+		"benchmarks/BenchmarkUtils.h",
+		"benchmarks/LoaderBenchmarkUtils.h",
+		"benchmarks/VoxelLoaderBenchmark.cpp",
+		"src/FileMapping.h",
+		"src/FileMapping.cpp",
+		"src/ThreadPool.h",
+		"src/ThreadPool.cpp",
+		"src/VoxelLoader.h",
+		"src/VoxelLoader.cpp"
+	}
+
+	includedirs {
+		"src"
+	}
+
+consoleProject "OctreeRayCasterBenchmark"
+	useOctreeRayCaster()
+	files {
+		"benchmarks/BenchmarkUtils.h",
+		"benchmarks/RayBenchmarkUtils.h",
+		"benchmarks/OctreeRayCasterBenchmark.cpp"
+	}
+
+-- Checks the CPU ray caster against golden hits, returns a non-zero exit code if one of them is wrong
+consoleProject "OctreeRayCasterTest"
+	useOctreeRayCaster()
+	files {
+		"tests/OctreeRayCasterTest.cpp"
+	}
+
+consoleProject "RaycastBatchBenchmark"
+	useOctreeRayCaster()
+	files {
+		"benchmarks/BenchmarkUtils.h",
+		"benchmarks/RayBenchmarkUtils.h",
+		"benchmarks/RaycastBatchBenchmark.cpp",
+		"src/RaycastBatch.h",
+		"src/RaycastBatch.cpp"
+	}
+
+consoleProject "VoxelBenchmarks"
+	files {
+		"benchmarks/BenchmarkUtils.h",
+		"benchmarks/LoaderBenchmarkUtils.h",
+		"benchmarks/VoxelBenchmarks.cpp",
+		"src/FileMapping.h",
+		"src/FileMapping.cpp",
+		"src/Octree.h",
+		"src/Octree.cpp",
+		"src/ThreadPool.h",
+		"src/ThreadPool.cpp",
+		"src/VoxelLoader.h",
+		"src/VoxelLoader.cpp"
+	}
+
+	includedirs {
+		"src"
+	}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#section compute
+#version 430 core
+
+// Reprojects the hits of the previous frame into the current view. Every invocation takes one pixel of the previous frame and writes the
+//  distance from the current camera to its hit into the pixel that the hit lands on. When several hits land on the same pixel the closest
+//  one is kept. The G-buffer shaders start their rays a bit in front of these distances, see getReprojectedStartDistance.
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// Cleared to NO_REPROJECTED_DISTANCE before the dispatch. The distances are positive floats stored as uints, which sort the same way, so
+//  imageAtomicMin can be used to keep the closest one.
+layout (r32ui, binding = 0) uniform uimage2D u_reprojectedDistance;
+
+uniform sampler2D u_prevNormalTexture;
+uniform sampler2D u_prevPosTexture;
+uniform usampler2D u_prevVisibilityTexture;
+
+#include "frameData.glsl"
+#include "gBuffer.glsl"
+
+void main() {
+    ivec2 prevPixel = ivec2(gl_GlobalInvocationID.xy);
+    if(prevPixel.x >= int(u_prevRenderSize.x) || prevPixel.y >= int(u_prevRenderSize.y)) return;
+
+    // The normal is zero where the ray of the previous frame did not hit anything
+    gBufferData prevGbd = readPrevGBuffer(u_prevNormalTexture, u_prevPosTexture, u_prevVisibilityTexture, prevPixel);
+    if(prevGbd.normal == vec3(0.0)) return;
+    vec3 hitPos = prevGbd.pos;
+
+    // Inverse of getCameraRayDir in gBuffer.glsl
+    vec3 hitDirCamera = transpose(u_cameraRotMatrix) * (hitPos - u_cameraPos);
+    if(hitDirCamera.z >= 0.0) return; // The hit is behind the camera
+
+    float aspectRatio = u_windowSize.x / u_windowSize.y;
+    vec2 screenSpaceCoordinates;
+    screenSpaceCoordinates.x = hitDirCamera.x / (-hitDirCamera.z * tan(u_fov) * aspectRatio);
+    screenSpaceCoordinates.y = hitDirCamera.y / (-hitDirCamera.z * tan(u_fov));
+
+    vec2 pixel = floor((screenSpaceCoordinates + vec2(0.5)) * u_renderSize - u_jitter);
+    if(pixel.x < 0.0 || pixel.y < 0.0 || pixel.x >= u_renderSize.x || pixel.y >= u_renderSize.y) return;
+
+    imageAtomicMin(u_reprojectedDistance, ivec2(pixel), floatBitsToUint(distance(hitPos, u_cameraPos)));
+}
\ No newline at end of file
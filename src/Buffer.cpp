@@ -1,15 +1,26 @@
 #include "Buffer.h"
 #include <GL/glew.h>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
 
-Buffer::Buffer() {
+Buffer::Buffer() : m_dataSize(0), m_mappedData(nullptr), m_partitionStride(0), m_partitionCount(1), m_partitionIndex(0) {
     glGenBuffers(1, &m_bufferID);
 }
 
 Buffer::~Buffer() {
+    for(void* fence : m_partitionFences) {
+        if(fence != nullptr) glDeleteSync((GLsync)fence);
+    }
     glDeleteBuffers(1, &m_bufferID);
 }
 
-void Buffer::setData(void* data, unsigned int dataSize, BufferDataUsage usageType) {
+void Buffer::setData(const void* data, unsigned int dataSize, BufferDataUsage usageType) {
+    if(m_mappedData != nullptr) {
+        std::cout << "ERROR: A buffer with persistent storage can not be given new data" << std::endl;
+        return;
+    }
+
     bind();
 
     GLenum glUsage = GL_STATIC_DRAW;
@@ -26,6 +37,75 @@ void Buffer::setData(void* data, unsigned int dataSize, BufferDataUsage usageTyp
     }
 
     glBufferData(getBufferType(), dataSize, data, glUsage);
+    m_dataSize = dataSize;
+}
+
+void Buffer::setPersistentStorage(unsigned int partitionSize, unsigned int partitionCount) {
+    if(m_mappedData != nullptr) {
+        std::cout << "ERROR: A buffer can only be given persistent storage once" << std::endl;
+        return;
+    }
+    if(!GLEW_ARB_buffer_storage) {
+        setData(nullptr, partitionSize, BufferDataUsage::STREAM_DRAW);
+        return;
+    }
+
+    // Every partition starts at an offset that can be bound as a uniform or shader storage buffer range
+    GLint uniformAlignment = 1, storageAlignment = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+    unsigned int alignment = std::max(std::max(uniformAlignment, storageAlignment), 1);
+
+    m_dataSize = partitionSize;
+    m_partitionStride = (partitionSize + alignment - 1) / alignment * alignment;
+    m_partitionCount = std::max(partitionCount, 1u);
+    m_partitionIndex = 0;
+    m_partitionFences.assign(m_partitionCount, nullptr);
+
+    bind();
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(getBufferType(), m_partitionStride * m_partitionCount, nullptr, flags);
+    m_mappedData = glMapBufferRange(getBufferType(), 0, m_partitionStride * m_partitionCount, flags);
+    if(m_mappedData == nullptr) {
+        std::cout << "ERROR: Could not map the persistent storage of a buffer, falling back to glBufferSubData" << std::endl;
+
+        // The storage is immutable now, so the fallback needs a new buffer
+        glDeleteBuffers(1, &m_bufferID);
+        glGenBuffers(1, &m_bufferID);
+        m_partitionStride = 0;
+        m_partitionCount = 1;
+        m_partitionFences.clear();
+        setData(nullptr, partitionSize, BufferDataUsage::STREAM_DRAW);
+    }
+    bindPartition();
+}
+
+void Buffer::updateRange(const void* data, unsigned int offset, unsigned int dataSize) {
+    if(m_mappedData != nullptr) {
+        std::memcpy((char*)m_mappedData + getPartitionOffset() + offset, data, dataSize);
+        return;
+    }
+
+    bind();
+    glBufferSubData(getBufferType(), offset, dataSize, data);
+}
+
+void Buffer::nextPartition() {
+    if(m_mappedData == nullptr) return;
+
+    m_partitionFences[m_partitionIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_partitionIndex = (m_partitionIndex + 1) % m_partitionCount;
+
+    // The next partition was last read 'partitionCount - 1' frames ago, which the GPU has usually finished long ago
+    GLsync fence = (GLsync)m_partitionFences[m_partitionIndex];
+    if(fence != nullptr) {
+        GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while(waitResult == GL_TIMEOUT_EXPIRED) waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        glDeleteSync(fence);
+        m_partitionFences[m_partitionIndex] = nullptr;
+    }
+
+    bindPartition();
 }
 
 void Buffer::bind() {
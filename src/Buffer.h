@@ -1,4 +1,5 @@
 #pragma once
+#include <vector>
 
 enum class BufferDataUsage {
     STREAM_DRAW, STREAM_READ, STREAM_COPY, STATIC_DRAW, STATIC_READ, STATIC_COPY, DYNAMIC_DRAW, DYNAMIC_READ, DYNAMIC_COPY
@@ -9,16 +10,39 @@ public:
     Buffer();
     ~Buffer();
 
-    virtual void setData(void* data, unsigned int dataSize, BufferDataUsage usageType);
+    virtual void setData(const void* data, unsigned int dataSize, BufferDataUsage usageType);
+    // Gives the buffer immutable storage for 'partitionCount' partitions of 'partitionSize' bytes that stays mapped. Every frame writes to its
+    //  own partition with updateRange, and nextPartition fences the partition once the frame's commands are issued, so the CPU only waits if
+    //  it gets 'partitionCount' frames ahead of the GPU. Falls back to setData when immutable storage is not supported or can not be mapped.
+    void setPersistentStorage(unsigned int partitionSize, unsigned int partitionCount = 3);
+    // Replaces 'dataSize' bytes at 'offset'. With persistent storage the bytes are written to the current partition, otherwise they are
+    //  uploaded with glBufferSubData. The range has to be inside the size given to setData or setPersistentStorage.
+    void updateRange(const void* data, unsigned int offset, unsigned int dataSize);
+    // Call after the commands that read the current partition have been issued
+    void nextPartition();
 
     virtual void bind();
     virtual void unbind();
 
     unsigned int getBufferID() const { return m_bufferID; }
+    unsigned int getDataSize() const { return m_dataSize; }
+    // Offset of the current partition in the buffer, zero unless the buffer has persistent storage
+    unsigned int getPartitionOffset() const { return m_partitionIndex * m_partitionStride; }
+
+protected:
+    // Called when the current partition changes, so that buffers bound to an index can bind the new partition
+    virtual void bindPartition() {}
 
 private:
     virtual int getBufferType() = 0;
 
 private:
     unsigned int m_bufferID;
+    unsigned int m_dataSize;
+
+    void* m_mappedData;
+    unsigned int m_partitionStride;
+    unsigned int m_partitionCount;
+    unsigned int m_partitionIndex;
+    std::vector<void*> m_partitionFences;
 };
\ No newline at end of file
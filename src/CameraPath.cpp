@@ -0,0 +1,68 @@
+#include "CameraPath.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+bool CameraPath::loadFromFile(const char* filename) {
+    std::ifstream file(filename);
+    if(!file.is_open()) {
+        std::cout << "ERROR: Could not open camera path " << filename << std::endl;
+        return false;
+    }
+
+    m_keyframes.clear();
+    std::string line;
+    for(unsigned int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        size_t firstCharacter = line.find_first_not_of(" \t\r");
+        if(firstCharacter == std::string::npos || line[firstCharacter] == '#') continue;
+
+        CameraPathKeyframe keyframe;
+        std::istringstream lineStream(line);
+        if(!(lineStream >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >> keyframe.angle)) {
+            std::cout << "ERROR: Could not parse line " << lineNumber << " of camera path " << filename << std::endl;
+            return false;
+        }
+        if(!m_keyframes.empty() && keyframe.time <= m_keyframes.back().time) {
+            std::cout << "ERROR: The time on line " << lineNumber << " of camera path " << filename << " is not after the previous keyframe" << std::endl;
+            return false;
+        }
+
+        m_keyframes.push_back(keyframe);
+    }
+
+    if(m_keyframes.empty()) {
+        std::cout << "ERROR: Camera path " << filename << " has no keyframes" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+CameraPathKeyframe CameraPath::getKeyframe(double time) const {
+    if(m_keyframes.empty()) return { time, glm::vec3(0.0), 0.0 };
+    if(time <= m_keyframes.front().time) return m_keyframes.front();
+    if(time >= m_keyframes.back().time) return m_keyframes.back();
+
+    // The first keyframe after 'time', the one before it exists since 'time' is after the first keyframe
+    auto next = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time, [](double t, const CameraPathKeyframe& keyframe) { return t < keyframe.time; });
+    const CameraPathKeyframe& a = *(next - 1);
+    const CameraPathKeyframe& b = *next;
+
+    double t = (time - a.time) / (b.time - a.time);
+    CameraPathKeyframe res;
+    res.time = time;
+    res.position = glm::mix(a.position, b.position, (float)t);
+    res.angle = a.angle + (b.angle - a.angle) * t;
+    return res;
+}
+
+double CameraPath::getStartTime() const {
+    if(m_keyframes.empty()) return 0.0;
+    return m_keyframes.front().time;
+}
+
+double CameraPath::getDuration() const {
+    if(m_keyframes.empty()) return 0.0;
+    return m_keyframes.back().time - m_keyframes.front().time;
+}
\ No newline at end of file
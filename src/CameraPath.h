@@ -0,0 +1,26 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+struct CameraPathKeyframe {
+    double time; // Seconds from the start of the path
+    glm::vec3 position;
+    double angle; // Rotation around the y axis, the same as the camera angle in main
+};
+
+// A camera path that the renderer follows instead of the keyboard and mouse, so that the same frames are rendered every time it runs.
+//  The file has one keyframe per line as "time x y z angle", lines starting with # are comments. The times must be increasing.
+class CameraPath {
+public:
+    bool loadFromFile(const char* filename);
+
+    // Interpolates linearly between the keyframes around 'time', times outside of the path are clamped to its first and last keyframe
+    CameraPathKeyframe getKeyframe(double time) const;
+
+    double getStartTime() const;
+    double getDuration() const;
+    bool isEmpty() const { return m_keyframes.empty(); }
+
+private:
+    std::vector<CameraPathKeyframe> m_keyframes;
+};
\ No newline at end of file
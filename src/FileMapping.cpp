@@ -0,0 +1,62 @@
+#include "FileMapping.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace FileMapping {
+
+#ifdef _WIN32
+    void* mapFile(const char* filename, size_t& fileSize) {
+        HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if(file == INVALID_HANDLE_VALUE) return nullptr;
+
+        LARGE_INTEGER size;
+        if(!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            return nullptr;
+        }
+        fileSize = size.QuadPart;
+
+        // The view keeps the file mapped after both handles are closed
+        HANDLE fileMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        void* mapping = (fileMapping != NULL) ? MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if(fileMapping != NULL) CloseHandle(fileMapping);
+        CloseHandle(file);
+        return mapping;
+    }
+
+    void unmapFile(void* mapping, size_t fileSize) {
+        UnmapViewOfFile(mapping);
+    }
+#else
+    void* mapFile(const char* filename, size_t& fileSize) {
+        int file = open(filename, O_RDONLY);
+        if(file == -1) return nullptr;
+
+        struct stat fileStat;
+        if(fstat(file, &fileStat) != 0 || fileStat.st_size == 0) {
+            close(file);
+            return nullptr;
+        }
+        fileSize = fileStat.st_size;
+
+        // The mapping stays valid after the file is closed
+        void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        return (mapping != MAP_FAILED) ? mapping : nullptr;
+    }
+
+    void unmapFile(void* mapping, size_t fileSize) {
+        munmap(mapping, fileSize);
+    }
+#endif
+
+}
\ No newline at end of file
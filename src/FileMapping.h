@@ -0,0 +1,11 @@
+#pragma once
+#include <cstddef>
+
+// Read-only memory mappings of whole files
+namespace FileMapping {
+
+    // Returns nullptr if the file could not be opened or is empty
+    void* mapFile(const char* filename, size_t& fileSize);
+    void unmapFile(void* mapping, size_t fileSize);
+
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// Binding point of the FrameData uniform block in frameData.glsl
+const unsigned int FRAME_DATA_BINDING = 0;
+
+// Constants shared by every pass of a frame. The layout matches the std140 FrameData block in frameData.glsl, so mat3 columns are
+//  padded to vec4 and every vec3 is followed by a float.
+struct FrameData {
+    glm::vec4 cameraRotMatrix[3];
+    glm::vec4 prevCameraRotMatrix[3];
+    glm::vec3 cameraPos;
+    float fov;
+    glm::vec3 prevCameraPos;
+    float frame;
+    glm::vec2 windowSize;
+    glm::vec2 noiseTextureScale;
+    glm::vec2 renderSize;
+    glm::vec2 prevRenderSize;
+    glm::vec2 jitter;
+    glm::vec2 prevJitter;
+    float taaAlpha;
+    float taaDistWeightScaler;
+    float taaNormalWeightScaler;
+    float taaColorWeightScaler;
+    float denoisingColorWeightScaler;
+    float denoisingNormalWeightScaler;
+    float denoisingPosWeightScaler;
+    unsigned int depthPrepassEnabled;
+    unsigned int reprojectionEnabled;
+    unsigned int octreeRopesEnabled;
+    unsigned int aoResolutionScale;
+    unsigned int visibilityBufferEnabled;
+};
+
+static_assert(sizeof(FrameData) == 224, "FrameData has to match the std140 layout of the FrameData uniform block");
+
+inline void setFrameDataMatrix(glm::vec4* columns, const glm::mat3& matrix) {
+    for(int i = 0; i < 3; ++i) columns[i] = glm::vec4(matrix[i], 0.0f);
+}
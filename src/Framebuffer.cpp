@@ -24,6 +24,15 @@ void Framebuffer::setDrawBuffers() {
     glDrawBuffers(m_colorAttachments.size(), m_colorAttachments.data());
 }
 
+void Framebuffer::setDrawBuffers(const std::vector<unsigned int>& attachments) {
+    bind();
+
+    unsigned int count = attachments.empty() ? 0 : *std::max_element(attachments.begin(), attachments.end()) + 1;
+    std::vector<unsigned int> drawBuffers(count, GL_NONE);
+    for(unsigned int attachment : attachments) drawBuffers[attachment] = GL_COLOR_ATTACHMENT0 + attachment;
+    glDrawBuffers(drawBuffers.size(), drawBuffers.data());
+}
+
 void Framebuffer::attachTexture(Texture* texture, unsigned int attachment) {
     bind();
     
@@ -12,6 +12,8 @@ public:
     void unbind();
 
     void setDrawBuffers();
+    // Only draws to the given color attachments, the output at location i is drawn to attachment i
+    void setDrawBuffers(const std::vector<unsigned int>& attachments);
     void attachTexture(Texture* texture, unsigned int attachment);
 
     unsigned int getFramebufferID() const { return m_framebufferID; }
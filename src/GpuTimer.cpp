@@ -0,0 +1,93 @@
+#include "GpuTimer.h"
+#include <GL/glew.h>
+#include <algorithm>
+
+GpuTimer::GpuTimer(unsigned int queryCount, unsigned int historySize)
+    : m_queries(queryCount > 0 ? queryCount : 1), m_queryFrames(m_queries.size(), 0), m_queryIndex(0), m_pendingQueries(0), m_time(0.0), m_averageTime(0.0), m_hasTime(false),
+      m_historySize(historySize > 0 ? historySize : 1), m_historyIndex(0), m_keepFinishedResults(false) {
+
+    glGenQueries(m_queries.size(), m_queries.data());
+}
+
+GpuTimer::~GpuTimer() {
+    glDeleteQueries(m_queries.size(), m_queries.data());
+}
+
+void GpuTimer::begin(unsigned int frame) {
+    // Every query is still in flight, the oldest one has to finish before it can be reused
+    readFinishedQueries(m_pendingQueries == m_queries.size());
+
+    m_queryFrames[m_queryIndex] = frame;
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[m_queryIndex]);
+}
+
+void GpuTimer::end() {
+    glEndQuery(GL_TIME_ELAPSED);
+
+    m_queryIndex = (m_queryIndex + 1) % m_queries.size();
+    m_pendingQueries++;
+}
+
+double GpuTimer::getTime() {
+    readFinishedQueries(false);
+    return m_time;
+}
+
+double GpuTimer::getAverageTime() {
+    readFinishedQueries(false);
+    return m_averageTime;
+}
+
+GpuTimerStatistics GpuTimer::getStatistics() {
+    readFinishedQueries(false);
+    if(m_history.empty()) return { 0.0, 0.0, 0.0 };
+
+    std::vector<double> sortedTimes = m_history;
+    std::sort(sortedTimes.begin(), sortedTimes.end());
+
+    double sum = 0.0;
+    for(double time : sortedTimes) sum += time;
+
+    return { sortedTimes.front(), sum / sortedTimes.size(), sortedTimes[(sortedTimes.size() - 1) * 99 / 100] };
+}
+
+void GpuTimer::setKeepFinishedResults(bool keepFinishedResults) {
+    m_keepFinishedResults = keepFinishedResults;
+    if(!keepFinishedResults) m_finishedResults.clear();
+}
+
+std::vector<GpuTimerResult> GpuTimer::takeFinishedResults() {
+    readFinishedQueries(false);
+    std::vector<GpuTimerResult> results;
+    std::swap(results, m_finishedResults);
+    return results;
+}
+
+// Reads the results of the queries in the order they were issued, stopping at the first one that has not finished unless 'waitForOldest'
+void GpuTimer::readFinishedQueries(bool waitForOldest) {
+    while(m_pendingQueries > 0) {
+        unsigned int oldestQueryIndex = (m_queryIndex + m_queries.size() - m_pendingQueries) % m_queries.size();
+        unsigned int query = m_queries[oldestQueryIndex];
+
+        if(!waitForOldest) {
+            GLint available = 0;
+            glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available) return;
+        }
+        waitForOldest = false;
+
+        GLuint64 elapsedTime = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedTime);
+        m_pendingQueries--;
+
+        m_time = elapsedTime / 1000000.0;
+        m_averageTime = m_hasTime ? m_averageTime * 0.95 + m_time * 0.05 : m_time;
+        m_hasTime = true;
+
+        if(m_history.size() < m_historySize) m_history.push_back(m_time);
+        else m_history[m_historyIndex] = m_time;
+        m_historyIndex = (m_historyIndex + 1) % m_historySize;
+
+        if(m_keepFinishedResults) m_finishedResults.push_back({ m_queryFrames[oldestQueryIndex], m_time });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+
+struct GpuTimerStatistics {
+    double min;
+    double average;
+    double p99;
+};
+
+struct GpuTimerResult {
+    unsigned int frame; // The frame that was passed to begin
+    double time;
+};
+
+// Measures the GPU time of the commands issued between begin and end with GL_TIME_ELAPSED queries. The results are read without stalling
+//  the pipeline, so they lag a few frames behind. Only one timer can be running at a time.
+class GpuTimer {
+public:
+    // The statistics cover the latest 'historySize' finished measurements
+    GpuTimer(unsigned int queryCount = 4, unsigned int historySize = 256);
+    ~GpuTimer();
+
+    void begin(unsigned int frame = 0);
+    void end();
+
+    // Time of the latest finished measurement in milliseconds
+    double getTime();
+    // Exponential moving average of the finished measurements in milliseconds
+    double getAverageTime();
+    // Min, average and 99th percentile of the measurements in the history in milliseconds, all zero if there are none
+    GpuTimerStatistics getStatistics();
+
+    // While enabled, every finished measurement is kept together with its frame until it is taken with takeFinishedResults
+    void setKeepFinishedResults(bool keepFinishedResults);
+    std::vector<GpuTimerResult> takeFinishedResults();
+
+private:
+    void readFinishedQueries(bool waitForOldest);
+
+private:
+    std::vector<unsigned int> m_queries;
+    std::vector<unsigned int> m_queryFrames;
+    unsigned int m_queryIndex;
+    unsigned int m_pendingQueries;
+
+    double m_time;
+    double m_averageTime;
+    bool m_hasTime;
+
+    std::vector<double> m_history;
+    unsigned int m_historySize;
+    unsigned int m_historyIndex;
+
+    bool m_keepFinishedResults;
+    std::vector<GpuTimerResult> m_finishedResults;
+};
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "GpuTimerLog.h"
+#include <iostream>
+#include <limits>
+
+GpuTimerLog::GpuTimerLog(const std::vector<std::pair<std::string, GpuTimer*>>& timers)
+    : m_timers(timers), m_nextFrame(0) {
+
+}
+
+GpuTimerLog::~GpuTimerLog() {
+    close();
+}
+
+bool GpuTimerLog::open(const char* filename) {
+    close();
+
+    m_file.open(filename);
+    if(!m_file.is_open()) {
+        std::cout << "ERROR: Could not open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    m_file << "frame";
+    for(auto& timer : m_timers) {
+        m_file << "," << timer.first << "Ms";
+        // Times that were measured before the log was opened are not logged
+        timer.second->takeFinishedResults();
+        timer.second->setKeepFinishedResults(true);
+    }
+    m_file << "\n";
+
+    m_pendingRows.clear();
+    m_nextFrame = 0;
+    return true;
+}
+
+void GpuTimerLog::close() {
+    if(!m_file.is_open()) return;
+
+    update(std::numeric_limits<unsigned int>::max());
+    for(auto& timer : m_timers) {
+        timer.second->setKeepFinishedResults(false);
+    }
+    m_file.close();
+}
+
+void GpuTimerLog::update(unsigned int frame) {
+    if(!m_file.is_open()) return;
+
+    for(unsigned int i = 0; i < m_timers.size(); ++i) {
+        for(const GpuTimerResult& result : m_timers[i].second->takeFinishedResults()) {
+            if(result.frame < m_nextFrame) continue;
+
+            std::vector<double>& row = m_pendingRows[result.frame];
+            if(row.empty()) row.resize(m_timers.size(), -1.0);
+            row[i] = result.time;
+        }
+    }
+
+    writeRows(frame >= ROW_DELAY ? frame - ROW_DELAY + 1 : 0);
+}
+
+// Writes the rows of the frames before 'endFrame'
+void GpuTimerLog::writeRows(unsigned int endFrame) {
+    while(!m_pendingRows.empty() && m_pendingRows.begin()->first < endFrame) {
+        auto row = m_pendingRows.begin();
+        m_file << row->first;
+        for(double time : row->second) {
+            m_file << ",";
+            if(time >= 0.0) m_file << time;
+        }
+        m_file << "\n";
+
+        m_nextFrame = row->first + 1;
+        m_pendingRows.erase(row);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+#include "GpuTimer.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+
+// Streams the times of a set of GpuTimers to a CSV file with one row per frame and one column per timer. The times of a frame are read a
+//  few frames after it, so its row is written once it is ROW_DELAY frames old. Timers that did not run in a frame leave their column empty.
+class GpuTimerLog {
+public:
+    GpuTimerLog(const std::vector<std::pair<std::string, GpuTimer*>>& timers);
+    ~GpuTimerLog();
+
+    bool open(const char* filename);
+    // Writes the rows of every frame that has times and closes the file
+    void close();
+    bool isOpen() const { return m_file.is_open(); }
+
+    // Collects the finished times and writes the rows of the frames that are at least ROW_DELAY frames older than 'frame'. Must be called
+    //  every frame while the log is open, the times that arrive after their row was written are dropped.
+    void update(unsigned int frame);
+
+private:
+    void writeRows(unsigned int endFrame);
+
+private:
+    static const unsigned int ROW_DELAY = 8;
+
+    std::vector<std::pair<std::string, GpuTimer*>> m_timers;
+    std::ofstream m_file;
+    // Times of the frames that have not been written yet, negative for the timers that did not run
+    std::map<unsigned int, std::vector<double>> m_pendingRows;
+    unsigned int m_nextFrame;
+};
\ No newline at end of file
@@ -1,45 +1,143 @@
 #include "Octree.h"
+#include "ThreadPool.h"
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <memory>
+#include <thread>
+#include <unordered_map>
 
-Octree::Octree(uint8_t* world, unsigned int worldWidth, unsigned int maxDepth)
-    : worldWidth(worldWidth), maxDepth(maxDepth) {
+// Value stored in the levels built by initLevels for nodes that are not a single color. Solid nodes store their palette index (0-255).
+const uint16_t MIXED_COLOR = 0xFFFF;
 
-    nodes.push_back(OctreeNode(0));
+uint16_t getLevelColor(const std::vector<std::vector<uint16_t>>& levels, unsigned int depth, unsigned int x, unsigned int y, unsigned int z);
+void reduceLevels(std::vector<std::vector<uint16_t>>& levels, unsigned int deepestDepth);
+uint16_t mergeChildColors(const uint16_t* childColors);
+uint32_t getChildMasksFromColors(const uint16_t* childColors, bool childrenAtMaxDepth);
+uint32_t getChildMasks(const std::vector<std::vector<uint16_t>>& levels, unsigned int maxDepth, unsigned int depth, unsigned int x, unsigned int y, unsigned int z);
+unsigned int getChildCount(uint32_t childMasks);
+uint64_t getMortonCode(unsigned int x, unsigned int y, unsigned int z);
+uint16_t getSparseLevelColor(const std::vector<std::unordered_map<uint64_t, uint16_t>>& levels, unsigned int depth, uint64_t mortonCode);
+void reduceSparseLevels(std::vector<std::unordered_map<uint64_t, uint16_t>>& levels);
+uint32_t getSparseChildMasks(const std::vector<std::unordered_map<uint64_t, uint16_t>>& levels, unsigned int maxDepth, unsigned int depth, uint64_t mortonCode);
+void encodeChunk(const uint8_t* voxels, unsigned int chunkWidth, std::vector<uint8_t>& chunkData);
+void decodeChunk(const uint8_t* chunk, unsigned int chunkWidth, uint8_t* voxels);
+unsigned int getEncodedChunkSize(const uint8_t* chunk, unsigned int chunkWidth);
+unsigned int getOccupancyWordCount(unsigned int chunkWidth);
+std::vector<OctreeDirtyRange> mergeDirtyRanges(std::vector<OctreeDirtyRange>& ranges);
+uint32_t getChildRope(const OctreeNode* nodes, const std::vector<uint32_t>& ropes, unsigned int nodeIndex, unsigned int depth, unsigned int child, unsigned int face);
+void initChildRopes(const OctreeNode* nodes, std::vector<uint32_t>& ropes, unsigned int nodeIndex, unsigned int depth);
+bool isNodeInRanges(const std::vector<OctreeDirtyRange>& nodeRanges, unsigned int nodeIndex);
+void updateChildRopes(const OctreeNode* nodes, std::vector<uint32_t>& ropes, const std::vector<OctreeDirtyRange>& dirtyNodeRanges, unsigned int nodeIndex, unsigned int depth, std::vector<OctreeDirtyRange>& dirtyRopeRanges);
+
+Octree::Octree(uint8_t* world, unsigned int worldWidth, unsigned int maxDepth, OctreeBuildMethod buildMethod, unsigned int threadCount)
+    : worldWidth(worldWidth), maxDepth(maxDepth), isDAG(false) {
+
+    nodes.push_back(OctreeNode());
+
+    if(maxDepth > 0 && (worldWidth % (unsigned int)std::pow(2, maxDepth + 1) != 0)) {
+        std::cout << "World width is not divisible by 2^(maxDepth + 1)" << std::endl;
+    }
+    else if(buildMethod == OctreeBuildMethod::TopDown) {
+        if(isSolidColor(world, worldWidth, 0, 0, 0)) nodes[0].data = world[0];
+        else if(maxDepth == 0) initData(world, nodes[0], worldWidth, 0, 0, 0);
+        else initOctree(world, 0, 0, 0, 0, 0);
+    }
+    else {
+        initOctreeBottomUp(world, threadCount);
+    }
+}
+
+Octree::Octree(const VoxelSlabReader& readSlab, unsigned int worldWidth, unsigned int maxDepth, size_t slabMemoryBudget, unsigned int threadCount)
+    : worldWidth(worldWidth), maxDepth(maxDepth), isDAG(false) {
+
+    nodes.push_back(OctreeNode());
+
+    if(maxDepth > 0 && (worldWidth % (unsigned int)std::pow(2, maxDepth + 1) != 0)) {
+        std::cout << "World width is not divisible by 2^(maxDepth + 1)" << std::endl;
+    }
+    else {
+        initOctreeFromSlabs(readSlab, slabMemoryBudget, threadCount);
+    }
+}
+
+Octree::Octree(const std::vector<SparseVoxel>& voxels, unsigned int worldWidth, unsigned int maxDepth)
+    : worldWidth(worldWidth), maxDepth(maxDepth), isDAG(false) {
+
+    nodes.push_back(OctreeNode());
+
+    if(maxDepth > 0 && (worldWidth % (unsigned int)std::pow(2, maxDepth + 1) != 0)) {
+        std::cout << "World width is not divisible by 2^(maxDepth + 1)" << std::endl;
+    }
+    else {
+        initOctreeFromVoxels(voxels);
+    }
+}
+
+Octree::Octree(const VoxelRegionClassifier& classifyRegion, const VoxelRegionReader& readRegion, unsigned int worldWidth, unsigned int maxDepth)
+    : worldWidth(worldWidth), maxDepth(maxDepth), isDAG(false) {
+
+    nodes.push_back(OctreeNode());
 
     if(maxDepth > 0 && (worldWidth % (unsigned int)std::pow(2, maxDepth + 1) != 0)) {
         std::cout << "World width is not divisible by 2^(maxDepth + 1)" << std::endl;
-        nodes[0].isSolidColor = 1;
     }
     else {
-        initOctree(world, 0, 0, 0, 0, 0);
+        unsigned int chunkWidth = worldWidth >> maxDepth;
+        std::vector<SparseLevel> levels(maxDepth + 1);
+        std::unordered_map<uint64_t, uint32_t> chunkOffsets;
+        std::vector<uint8_t> chunk((size_t)chunkWidth * chunkWidth * chunkWidth);
+        initSparseLevelsFromRegions(classifyRegion, readRegion, levels, chunkOffsets, chunk, 0, 0, 0, 0);
+        initOctreeFromSparseLevels(levels, chunkOffsets);
     }
 }
 
+Octree::Octree(const OctreeNode* nodes, unsigned int nodeCount, const uint8_t* chunkData, size_t chunkDataSize, unsigned int worldWidth, unsigned int maxDepth, bool isDAG)
+    : worldWidth(worldWidth), maxDepth(maxDepth), isDAG(isDAG), chunkData(chunkData, chunkData + chunkDataSize), nodes(nodes, nodes + nodeCount) {
+}
+
+// Creates the children of a node that is not a single color. The children are placed next to each other at the end of 'nodes' and the
+//  children that are not leaves then create their own children, one after another.
 void Octree::initOctree(uint8_t* world, unsigned int currentIndex, int depth, int startx, int starty, int startz) {
-    int width = worldWidth / std::pow(2, depth);
-    int hWidth = width / 2;
+    int hWidth = worldWidth / std::pow(2, depth + 1);
     
-    if(!isSolidColor(world, width, startx, starty, startz)) {
-        nodes[currentIndex].isSolidColor = 0;
-        if(depth >= maxDepth) {
-            initData(world, nodes[currentIndex], width, startx, starty, startz);
+    bool childIsSolidColor[8];
+    uint32_t childMasks = 0;
+    for(int i = 0; i < 8; ++i) {
+        int cStartx = startx + ((i % 2 == 0) ? 0 : hWidth);
+        int cStarty = starty + ((i % 4 <  2) ? 0 : hWidth);
+        int cStartz = startz + ((i % 8 <  4) ? 0 : hWidth);
+        childIsSolidColor[i] = isSolidColor(world, hWidth, cStartx, cStarty, cStartz);
+
+        if(!childIsSolidColor[i] || world[cStartx + cStarty * worldWidth + cStartz * worldWidth * worldWidth] != 0) childMasks |= 1 << i;
+        if(childIsSolidColor[i] || depth + 1 >= (int)maxDepth) childMasks |= 1 << (i + 8);
+    }
+
+    unsigned int firstChildIndex = nodes.size();
+    nodes[currentIndex] = OctreeNode(childMasks, firstChildIndex);
+    nodes.resize(firstChildIndex + getChildCount(childMasks));
+
+    unsigned int childIndex = firstChildIndex;
+    for(int i = 0; i < 8; ++i) {
+        if((childMasks & (1 << i)) == 0) continue;
+
+        int cStartx = startx + ((i % 2 == 0) ? 0 : hWidth);
+        int cStarty = starty + ((i % 4 <  2) ? 0 : hWidth);
+        int cStartz = startz + ((i % 8 <  4) ? 0 : hWidth);
+        if(childIsSolidColor[i]) {
+            nodes[childIndex].data = world[cStartx + cStarty * worldWidth + cStartz * worldWidth * worldWidth];
+        }
+        else if(depth + 1 >= (int)maxDepth) {
+            initData(world, nodes[childIndex], hWidth, cStartx, cStarty, cStartz);
         }
         else {
-            for(int i = 0; i < 8; ++i) {
-                nodes[currentIndex].childrenIndices[i] = nodes.size();
-                nodes.push_back(OctreeNode(currentIndex));
-
-                int cStartx = startx + ((i % 2 == 0) ? 0 : hWidth);
-                int cStarty = starty + ((i % 4 <  2) ? 0 : hWidth);
-                int cStartz = startz + ((i % 8 <  4) ? 0 : hWidth);
-                initOctree(world, nodes[currentIndex].childrenIndices[i], depth + 1, cStartx, cStarty, cStartz);
-            }
+            initOctree(world, childIndex, depth + 1, cStartx, cStarty, cStartz);
         }
-    }
-    else {
-        nodes[currentIndex].dataIndex = world[startx + starty * worldWidth + startz * worldWidth * worldWidth];
+        childIndex++;
     }
 }
 
@@ -62,12 +160,1257 @@ void Octree::initData(uint8_t* world, OctreeNode& node, int width, int startx, i
     int endx = startx + width;
     int endy = starty + width;
     int endz = startz + width;
-    node.dataIndex = chunkData.size();
+    std::vector<uint8_t> voxels;
+    voxels.reserve(width * width * width);
     for(int z = startz; z < endz; z++) {
         for(int y = starty; y < endy; y++) {
             for(int x = startx; x < endx; x++) {
-                chunkData.push_back(world[x + y * worldWidth + z * worldWidth * worldWidth]);
+                voxels.push_back(world[x + y * worldWidth + z * worldWidth * worldWidth]);
+            }
+        }
+    }
+
+    node.data = chunkData.size() | OctreeNode::CHUNK_FLAG;
+    encodeChunk(voxels.data(), width, chunkData);
+}
+
+// Builds the same nodes and chunkData as initOctree, but every voxel is only read once to find the solid chunks and once more to copy the
+//  mixed chunks into chunkData. Whether a node above the chunks is solid is decided from its eight children instead of rescanning the world.
+//  The descendants of the nodes at 'splitDepth' are built in parallel, each into its own node and chunk arrays, and then stitched together in
+//  the same order as initOctree creates them.
+void Octree::initOctreeBottomUp(uint8_t* world, unsigned int threadCount) {
+    ThreadPool threadPool(threadCount);
+
+    std::vector<std::vector<uint16_t>> levels(maxDepth + 1);
+    initLevels(world, levels, threadPool);
+
+    uint16_t rootColor = levels[0][0];
+    if(rootColor != MIXED_COLOR) {
+        nodes[0].data = rootColor;
+        return;
+    }
+
+    if(maxDepth == 0) {
+        copyChunk(world, 0, 0, 0, chunkData);
+        nodes[0].data = OctreeNode::CHUNK_FLAG;
+        return;
+    }
+
+    // Count the nodes so that they can be allocated once
+    unsigned int nodeCount = 1;
+    countSubtree(levels, 0, 0, 0, 0, nodeCount);
+
+    // Split deep enough to give every thread several subtrees to work on, work stealing evens out the rest
+    unsigned int splitDepth = 0;
+    while(splitDepth + 1 < maxDepth && (1u << (3 * splitDepth)) < threadPool.getThreadCount() * 16) splitDepth++;
+    if(threadPool.getThreadCount() == 1) splitDepth = 0;
+
+    std::vector<OctreeNode> spineNodes;
+    std::vector<OctreeSubtree> subtrees;
+    unsigned int nodeIndex = 1;
+    spineNodes.push_back(OctreeNode(getChildMasks(levels, maxDepth, 0, 0, 0, 0), 0));
+    if(splitDepth == 0) {
+        OctreeSubtree subtree;
+        subtree.depth = subtree.x = subtree.y = subtree.z = 0;
+        subtree.nodeIndex = nodeIndex;
+        subtree.spineNodesBefore = 1;
+        subtrees.push_back(std::move(subtree));
+        spineNodes[0].data = nodeIndex;
+    }
+    else {
+        spineNodes[0].data = initSpineChildren(levels, splitDepth, 0, 0, 0, 0, nodeIndex, spineNodes, subtrees);
+    }
+
+    for(OctreeSubtree& subtree : subtrees) {
+        threadPool.submit([this, world, &levels, &subtree]() {
+            initChildrenFromLevels(world, levels, subtree, subtree.depth, subtree.x, subtree.y, subtree.z);
+        });
+    }
+    threadPool.wait();
+
+    nodes.clear();
+    nodes.reserve(nodeCount);
+    unsigned int spineNodeIndex = 0;
+    for(OctreeSubtree& subtree : subtrees) {
+        nodes.insert(nodes.end(), spineNodes.begin() + spineNodeIndex, spineNodes.begin() + subtree.spineNodesBefore);
+        spineNodeIndex = subtree.spineNodesBefore;
+
+        // The chunks of a subtree are indexed from the start of its own chunk array
+        unsigned int chunkDataIndex = chunkData.size();
+        for(OctreeNode& node : subtree.nodes) {
+            if(node.childMasks == 0 && (node.data & OctreeNode::CHUNK_FLAG) != 0) node.data += chunkDataIndex;
+        }
+        nodes.insert(nodes.end(), subtree.nodes.begin(), subtree.nodes.end());
+        chunkData.insert(chunkData.end(), subtree.chunkData.begin(), subtree.chunkData.end());
+    }
+    nodes.insert(nodes.end(), spineNodes.begin() + spineNodeIndex, spineNodes.end());
+}
+
+// Fills 'levels' with one entry per node for every depth, indexed as x + y * levelWidth + z * levelWidth^2. An entry is the palette index of the
+//  node if it is a single color and MIXED_COLOR otherwise. The deepest level is found by scanning the world once, row by row, and every level
+//  above it is reduced from the level below.
+void Octree::initLevels(uint8_t* world, std::vector<std::vector<uint16_t>>& levels, ThreadPool& threadPool) {
+    unsigned int chunkWidth = worldWidth >> maxDepth;
+    unsigned int levelWidth = 1 << maxDepth;
+    std::vector<uint16_t>& chunkLevel = levels[maxDepth];
+    chunkLevel.resize((size_t)levelWidth * levelWidth * levelWidth);
+
+    // Every task scans one layer of chunks
+    for(unsigned int cz = 0; cz < levelWidth; ++cz) {
+        threadPool.submit([this, world, &chunkLevel, chunkWidth, levelWidth, cz]() {
+            uint16_t* chunkLayer = chunkLevel.data() + (size_t)cz * levelWidth * levelWidth;
+            for(unsigned int cy = 0; cy < levelWidth; ++cy) {
+                for(unsigned int cx = 0; cx < levelWidth; ++cx) {
+                    size_t worldIndex = cx * chunkWidth + (size_t)cy * chunkWidth * worldWidth + (size_t)cz * chunkWidth * worldWidth * worldWidth;
+                    chunkLayer[cx + cy * levelWidth] = world[worldIndex];
+                }
+            }
+
+            for(unsigned int z = cz * chunkWidth; z < (cz + 1) * chunkWidth; ++z) {
+                for(unsigned int y = 0; y < worldWidth; ++y) {
+                    uint8_t* row = world + (size_t)y * worldWidth + (size_t)z * worldWidth * worldWidth;
+                    uint16_t* chunkRow = chunkLayer + (y / chunkWidth) * levelWidth;
+                    for(unsigned int cx = 0; cx < levelWidth; ++cx) {
+                        if(chunkRow[cx] == MIXED_COLOR) continue;
+
+                        // No early exit so that the comparison can be vectorized
+                        uint8_t color = chunkRow[cx];
+                        uint8_t difference = 0;
+                        uint8_t* chunkRowStart = row + cx * chunkWidth;
+                        for(unsigned int x = 0; x < chunkWidth; ++x) {
+                            difference |= chunkRowStart[x] ^ color;
+                        }
+                        if(difference != 0) chunkRow[cx] = MIXED_COLOR;
+                    }
+                }
+            }
+        });
+    }
+    threadPool.wait();
+
+    reduceLevels(levels, maxDepth);
+}
+
+// Creates the children of a mixed node above 'splitDepth' in 'spineNodes', and a subtree for the descendants of every mixed node at 'splitDepth'.
+//  'nodeIndex' is where the next node will be placed in the final octree. Returns the index of the first child.
+unsigned int Octree::initSpineChildren(const std::vector<std::vector<uint16_t>>& levels, unsigned int splitDepth, unsigned int depth, unsigned int x, unsigned int y, unsigned int z, unsigned int& nodeIndex, std::vector<OctreeNode>& spineNodes, std::vector<OctreeSubtree>& subtrees) {
+    uint32_t childMasks = getChildMasks(levels, maxDepth, depth, x, y, z);
+    unsigned int firstChildIndex = nodeIndex;
+    unsigned int spineIndex = spineNodes.size();
+    nodeIndex += getChildCount(childMasks);
+    spineNodes.resize(spineIndex + getChildCount(childMasks));
+
+    for(int i = 0; i < 8; ++i) {
+        if((childMasks & (1 << i)) == 0) continue;
+
+        unsigned int cx = x * 2 + ((i % 2 == 0) ? 0 : 1);
+        unsigned int cy = y * 2 + ((i % 4 <  2) ? 0 : 1);
+        unsigned int cz = z * 2 + ((i % 8 <  4) ? 0 : 1);
+        uint16_t color = getLevelColor(levels, depth + 1, cx, cy, cz);
+
+        // The split depth is above the chunks, so every mixed child here has children of its own
+        if(color != MIXED_COLOR) {
+            spineNodes[spineIndex].data = color;
+        }
+        else if(depth + 1 == splitDepth) {
+            OctreeSubtree subtree;
+            subtree.depth = depth + 1;
+            subtree.x = cx;
+            subtree.y = cy;
+            subtree.z = cz;
+            subtree.nodeIndex = nodeIndex;
+            subtree.spineNodesBefore = spineNodes.size();
+
+            unsigned int subtreeNodes = 0;
+            countSubtree(levels, depth + 1, cx, cy, cz, subtreeNodes);
+            subtree.nodes.reserve(subtreeNodes);
+            nodeIndex += subtreeNodes;
+
+            spineNodes[spineIndex] = OctreeNode(getChildMasks(levels, maxDepth, depth + 1, cx, cy, cz), subtree.nodeIndex);
+            subtrees.push_back(std::move(subtree));
+        }
+        else {
+            uint32_t grandChildMasks = getChildMasks(levels, maxDepth, depth + 1, cx, cy, cz);
+            unsigned int firstGrandChildIndex = initSpineChildren(levels, splitDepth, depth + 1, cx, cy, cz, nodeIndex, spineNodes, subtrees);
+            spineNodes[spineIndex] = OctreeNode(grandChildMasks, firstGrandChildIndex);
+        }
+        spineIndex++;
+    }
+
+    return firstChildIndex;
+}
+
+// Adds the number of descendants of the given mixed node to 'nodeCount'.
+void Octree::countSubtree(const std::vector<std::vector<uint16_t>>& levels, unsigned int depth, unsigned int x, unsigned int y, unsigned int z, unsigned int& nodeCount) {
+    for(int i = 0; i < 8; ++i) {
+        unsigned int cx = x * 2 + ((i % 2 == 0) ? 0 : 1);
+        unsigned int cy = y * 2 + ((i % 4 <  2) ? 0 : 1);
+        unsigned int cz = z * 2 + ((i % 8 <  4) ? 0 : 1);
+        uint16_t color = getLevelColor(levels, depth + 1, cx, cy, cz);
+
+        if(color == 0) continue;
+        nodeCount++;
+
+        if(color == MIXED_COLOR && depth + 1 < maxDepth) countSubtree(levels, depth + 1, cx, cy, cz, nodeCount);
+    }
+}
+
+// Creates the children of a mixed node in the same order as initOctree, looking up whether a node is solid in 'levels' instead of scanning the
+//  world. 'x', 'y' and 'z' are the position of the node in its level. The node indices are the indices the nodes will have once the subtree is
+//  stitched into 'nodes', while the chunks are indexed from the start of the subtree's own chunkData. Returns the index of the first child.
+unsigned int Octree::initChildrenFromLevels(uint8_t* world, const std::vector<std::vector<uint16_t>>& levels, OctreeSubtree& subtree, unsigned int depth, unsigned int x, unsigned int y, unsigned int z) {
+    uint32_t childMasks = getChildMasks(levels, maxDepth, depth, x, y, z);
+    unsigned int localIndex = subtree.nodes.size();
+    unsigned int firstChildIndex = subtree.nodeIndex + localIndex;
+    subtree.nodes.resize(localIndex + getChildCount(childMasks));
+
+    for(int i = 0; i < 8; ++i) {
+        if((childMasks & (1 << i)) == 0) continue;
+
+        unsigned int cx = x * 2 + ((i % 2 == 0) ? 0 : 1);
+        unsigned int cy = y * 2 + ((i % 4 <  2) ? 0 : 1);
+        unsigned int cz = z * 2 + ((i % 8 <  4) ? 0 : 1);
+        uint16_t color = getLevelColor(levels, depth + 1, cx, cy, cz);
+
+        if(color != MIXED_COLOR) {
+            subtree.nodes[localIndex].data = color;
+        }
+        else if(depth + 1 >= maxDepth) {
+            subtree.nodes[localIndex].data = subtree.chunkData.size() | OctreeNode::CHUNK_FLAG;
+            copyChunk(world, cx, cy, cz, subtree.chunkData);
+        }
+        else {
+            uint32_t grandChildMasks = getChildMasks(levels, maxDepth, depth + 1, cx, cy, cz);
+            unsigned int firstGrandChildIndex = initChildrenFromLevels(world, levels, subtree, depth + 1, cx, cy, cz);
+            subtree.nodes[localIndex] = OctreeNode(grandChildMasks, firstGrandChildIndex);
+        }
+        localIndex++;
+    }
+
+    return firstChildIndex;
+}
+
+// Encodes the chunk at position 'x', 'y', 'z' in the deepest level and appends it to 'destination'.
+void Octree::copyChunk(uint8_t* world, unsigned int x, unsigned int y, unsigned int z, std::vector<uint8_t>& destination) {
+    unsigned int chunkWidth = worldWidth >> maxDepth;
+    std::vector<uint8_t> voxels(chunkWidth * chunkWidth * chunkWidth);
+    unsigned int voxelIndex = 0;
+    for(unsigned int cz = 0; cz < chunkWidth; ++cz) {
+        for(unsigned int cy = 0; cy < chunkWidth; ++cy) {
+            size_t worldIndex = x * chunkWidth + (size_t)(y * chunkWidth + cy) * worldWidth + (size_t)(z * chunkWidth + cz) * worldWidth * worldWidth;
+            std::memcpy(voxels.data() + voxelIndex, world + worldIndex, chunkWidth);
+            voxelIndex += chunkWidth;
+        }
+    }
+    encodeChunk(voxels.data(), chunkWidth, destination);
+}
+
+// Builds the same nodes and chunkData as initOctreeBottomUp without having the whole world in memory. The world is read in slabs that are as
+//  thick as a node at 'slabDepth', and every node in a slab is built as an octree of its own while the next slab is read. The nodes above
+//  'slabDepth' are then created from the roots of these octrees, and their descendants are moved into 'nodes' in the same order as
+//  initOctree creates them.
+void Octree::initOctreeFromSlabs(const VoxelSlabReader& readSlab, size_t slabMemoryBudget, unsigned int threadCount) {
+    // A world that fits in the budget is read as one slab and built like any other world
+    size_t worldSize = (size_t)worldWidth * worldWidth * worldWidth;
+    if(worldSize <= slabMemoryBudget || maxDepth == 0) {
+        std::vector<uint8_t> world(worldSize);
+        if(!readSlab(0, worldWidth, world.data())) {
+            std::cout << "ERROR: Could not read the world" << std::endl;
+            return;
+        }
+        initOctreeBottomUp(world.data(), threadCount);
+        return;
+    }
+
+    // Otherwise two slabs are in memory at once, the one being built and the one being read
+    unsigned int slabDepth = 1;
+    while(slabDepth < maxDepth && 2 * (size_t)worldWidth * worldWidth * (worldWidth >> slabDepth) > slabMemoryBudget) slabDepth++;
+    unsigned int slabWidth = worldWidth >> slabDepth;
+    size_t slabSize = (size_t)worldWidth * worldWidth * slabWidth;
+    if(2 * slabSize > slabMemoryBudget) {
+        std::cout << "Slab memory budget is too small for slabs one chunk thick, using " << 2 * slabSize << " bytes" << std::endl;
+    }
+
+    unsigned int levelWidth = 1 << slabDepth;
+    std::vector<std::unique_ptr<Octree>> slabSubtrees((size_t)levelWidth * levelWidth * levelWidth);
+    {
+        ThreadPool threadPool(threadCount);
+        std::vector<uint8_t> slabs[2] = { std::vector<uint8_t>(slabSize), std::vector<uint8_t>(slabSize) };
+
+        bool readSucceeded = readSlab(0, slabWidth, slabs[0].data());
+        for(unsigned int slabZ = 0; slabZ < levelWidth && readSucceeded; ++slabZ) {
+            bool nextReadSucceeded = true;
+            std::thread reader;
+            if(slabZ + 1 < levelWidth) {
+                uint8_t* nextSlab = slabs[(slabZ + 1) % 2].data();
+                reader = std::thread([&readSlab, &nextReadSucceeded, nextSlab, slabWidth, slabZ]() {
+                    nextReadSucceeded = readSlab((slabZ + 1) * slabWidth, slabWidth, nextSlab);
+                });
+            }
+
+            // Every node in the slab is copied out of the slab and built by its own task
+            const uint8_t* slab = slabs[slabZ % 2].data();
+            for(unsigned int y = 0; y < levelWidth; ++y) {
+                for(unsigned int x = 0; x < levelWidth; ++x) {
+                    threadPool.submit([this, slab, &slabSubtrees, slabDepth, slabWidth, levelWidth, x, y, slabZ]() {
+                        std::vector<uint8_t> subtreeWorld((size_t)slabWidth * slabWidth * slabWidth);
+                        for(unsigned int z = 0; z < slabWidth; ++z) {
+                            for(unsigned int sy = 0; sy < slabWidth; ++sy) {
+                                size_t slabIndex = x * slabWidth + (size_t)(y * slabWidth + sy) * worldWidth + (size_t)z * worldWidth * worldWidth;
+                                std::memcpy(subtreeWorld.data() + (size_t)sy * slabWidth + (size_t)z * slabWidth * slabWidth, slab + slabIndex, slabWidth);
+                            }
+                        }
+
+                        std::unique_ptr<Octree>& subtree = slabSubtrees[x + y * levelWidth + (size_t)slabZ * levelWidth * levelWidth];
+                        subtree = std::make_unique<Octree>(subtreeWorld.data(), slabWidth, maxDepth - slabDepth, OctreeBuildMethod::BottomUp, 1);
+                    });
+                }
+            }
+            threadPool.wait();
+
+            if(reader.joinable()) reader.join();
+            readSucceeded = nextReadSucceeded;
+        }
+
+        if(!readSucceeded) {
+            std::cout << "ERROR: Could not read the world" << std::endl;
+            return;
+        }
+    }
+
+    // A slab subtree is a single color if its root is a leaf without a chunk
+    std::vector<std::vector<uint16_t>> levels(slabDepth + 1);
+    levels[slabDepth].resize(slabSubtrees.size());
+    size_t nodeCount = 1;
+    size_t chunkDataSize = 0;
+    for(size_t i = 0; i < slabSubtrees.size(); ++i) {
+        const OctreeNode& root = slabSubtrees[i]->nodes[0];
+        bool isSolidColor = root.childMasks == 0 && (root.data & OctreeNode::CHUNK_FLAG) == 0;
+        levels[slabDepth][i] = isSolidColor ? root.data : MIXED_COLOR;
+        nodeCount += slabSubtrees[i]->nodes.size();
+        chunkDataSize += slabSubtrees[i]->chunkData.size();
+    }
+    reduceLevels(levels, slabDepth);
+
+    uint16_t rootColor = levels[0][0];
+    if(rootColor != MIXED_COLOR) {
+        nodes[0].data = rootColor;
+        return;
+    }
+    nodes.reserve(nodeCount);
+    chunkData.reserve(chunkDataSize);
+    uint32_t rootChildMasks = getChildMasks(levels, maxDepth, 0, 0, 0, 0);
+    unsigned int firstChildIndex = initChildrenFromSlabSubtrees(levels, slabSubtrees, slabDepth, 0, 0, 0, 0);
+    nodes[0] = OctreeNode(rootChildMasks, firstChildIndex);
+}
+
+// Creates the children of a mixed node above 'slabDepth' at the end of 'nodes'. The mixed children at 'slabDepth' are the roots of their slab
+//  subtrees, and the descendants of the roots are moved into 'nodes' after them. Returns the index of the first child.
+unsigned int Octree::initChildrenFromSlabSubtrees(const std::vector<std::vector<uint16_t>>& levels, std::vector<std::unique_ptr<Octree>>& slabSubtrees, unsigned int slabDepth, unsigned int depth, unsigned int x, unsigned int y, unsigned int z) {
+    uint32_t childMasks = getChildMasks(levels, maxDepth, depth, x, y, z);
+    unsigned int firstChildIndex = nodes.size();
+    nodes.resize(firstChildIndex + getChildCount(childMasks));
+
+    unsigned int childIndex = firstChildIndex;
+    for(int i = 0; i < 8; ++i) {
+        if((childMasks & (1 << i)) == 0) continue;
+
+        unsigned int cx = x * 2 + ((i % 2 == 0) ? 0 : 1);
+        unsigned int cy = y * 2 + ((i % 4 <  2) ? 0 : 1);
+        unsigned int cz = z * 2 + ((i % 8 <  4) ? 0 : 1);
+        uint16_t color = getLevelColor(levels, depth + 1, cx, cy, cz);
+
+        if(color != MIXED_COLOR) {
+            nodes[childIndex].data = color;
+        }
+        else if(depth + 1 == slabDepth) {
+            unsigned int levelWidth = 1 << slabDepth;
+            std::unique_ptr<Octree>& subtree = slabSubtrees[cx + cy * levelWidth + (size_t)cz * levelWidth * levelWidth];
+
+            // The root has index 0 in the subtree but its descendants are placed from the end of 'nodes', so every index moves by one less
+            unsigned int nodeOffset = nodes.size() - 1;
+            unsigned int chunkDataOffset = chunkData.size();
+            for(OctreeNode& node : subtree->nodes) {
+                if(node.childMasks != 0) node.data += nodeOffset;
+                else if((node.data & OctreeNode::CHUNK_FLAG) != 0) node.data += chunkDataOffset;
+            }
+            nodes[childIndex] = subtree->nodes[0];
+            nodes.insert(nodes.end(), subtree->nodes.begin() + 1, subtree->nodes.end());
+            chunkData.insert(chunkData.end(), subtree->chunkData.begin(), subtree->chunkData.end());
+            subtree.reset();
+        }
+        else {
+            uint32_t grandChildMasks = getChildMasks(levels, maxDepth, depth + 1, cx, cy, cz);
+            unsigned int firstGrandChildIndex = initChildrenFromSlabSubtrees(levels, slabSubtrees, slabDepth, depth + 1, cx, cy, cz);
+            nodes[childIndex] = OctreeNode(grandChildMasks, firstGrandChildIndex);
+        }
+        childIndex++;
+    }
+
+    return firstChildIndex;
+}
+
+// Builds the octree from sparse levels that only hold the nodes that are not empty. The voxels are visited in the order of the Morton code of
+//  their chunk, which is the order initOctree visits the chunks in, so every chunk is filled from one run of voxels and encoded straight into
+//  chunkData.
+void Octree::initOctreeFromVoxels(const std::vector<SparseVoxel>& voxels) {
+    // The Morton code of the chunk of every voxel in the world and the index of the voxel, the index keeps voxels in the same chunk in order
+    unsigned int chunkWidth = worldWidth >> maxDepth;
+    std::vector<std::pair<uint64_t, size_t>> voxelOrder;
+    voxelOrder.reserve(voxels.size());
+    for(size_t i = 0; i < voxels.size(); ++i) {
+        const SparseVoxel& voxel = voxels[i];
+        if(voxel.x >= worldWidth || voxel.y >= worldWidth || voxel.z >= worldWidth) continue;
+        voxelOrder.push_back({ getMortonCode(voxel.x / chunkWidth, voxel.y / chunkWidth, voxel.z / chunkWidth), i });
+    }
+    std::sort(voxelOrder.begin(), voxelOrder.end());
+
+    std::vector<SparseLevel> levels(maxDepth + 1);
+    std::unordered_map<uint64_t, uint32_t> chunkOffsets;
+    std::vector<uint8_t> chunk((size_t)chunkWidth * chunkWidth * chunkWidth);
+    size_t orderIndex = 0;
+    while(orderIndex < voxelOrder.size()) {
+        uint64_t mortonCode = voxelOrder[orderIndex].first;
+        const SparseVoxel& firstVoxel = voxels[voxelOrder[orderIndex].second];
+        unsigned int chunkX = firstVoxel.x / chunkWidth;
+        unsigned int chunkY = firstVoxel.y / chunkWidth;
+        unsigned int chunkZ = firstVoxel.z / chunkWidth;
+
+        std::fill(chunk.begin(), chunk.end(), 0);
+        for(; orderIndex < voxelOrder.size() && voxelOrder[orderIndex].first == mortonCode; ++orderIndex) {
+            const SparseVoxel& voxel = voxels[voxelOrder[orderIndex].second];
+            chunk[(voxel.x - chunkX * chunkWidth) + (voxel.y - chunkY * chunkWidth) * chunkWidth + (size_t)(voxel.z - chunkZ * chunkWidth) * chunkWidth * chunkWidth] = voxel.paletteIndex;
+        }
+
+        addSparseChunk(chunk.data(), levels, chunkOffsets, mortonCode);
+    }
+
+    initOctreeFromSparseLevels(levels, chunkOffsets);
+}
+
+// Classifies the region of the node at position 'x', 'y', 'z' in level 'depth' and adds it to 'levels' unless it is empty. Mixed regions
+//  above the chunks are split into their children, which are visited in the order initOctree visits them, so the chunks are encoded straight
+//  into chunkData.
+void Octree::initSparseLevelsFromRegions(const VoxelRegionClassifier& classifyRegion, const VoxelRegionReader& readRegion, std::vector<SparseLevel>& levels, std::unordered_map<uint64_t, uint32_t>& chunkOffsets, std::vector<uint8_t>& chunk, unsigned int depth, unsigned int x, unsigned int y, unsigned int z) {
+    unsigned int width = worldWidth >> depth;
+    int color = classifyRegion(x * width, y * width, z * width, width);
+    if(color != MIXED_REGION) {
+        if(color != 0) levels[depth][getMortonCode(x, y, z)] = color;
+        return;
+    }
+
+    if(depth == maxDepth) {
+        readRegion(x * width, y * width, z * width, width, chunk.data());
+        addSparseChunk(chunk.data(), levels, chunkOffsets, getMortonCode(x, y, z));
+        return;
+    }
+
+    levels[depth][getMortonCode(x, y, z)] = MIXED_COLOR;
+    for(int i = 0; i < 8; ++i) {
+        unsigned int cx = x * 2 + ((i % 2 == 0) ? 0 : 1);
+        unsigned int cy = y * 2 + ((i % 4 <  2) ? 0 : 1);
+        unsigned int cz = z * 2 + ((i % 8 <  4) ? 0 : 1);
+        initSparseLevelsFromRegions(classifyRegion, readRegion, levels, chunkOffsets, chunk, depth + 1, cx, cy, cz);
+    }
+}
+
+// Adds a chunk to the deepest level, and its ancestors as mixed nodes. Chunks that are not a single color are encoded at the end of chunkData.
+void Octree::addSparseChunk(const uint8_t* chunk, std::vector<SparseLevel>& levels, std::unordered_map<uint64_t, uint32_t>& chunkOffsets, uint64_t mortonCode) {
+    unsigned int chunkWidth = worldWidth >> maxDepth;
+    size_t chunkSize = (size_t)chunkWidth * chunkWidth * chunkWidth;
+    uint16_t color = chunk[0];
+    for(size_t i = 1; i < chunkSize && color != MIXED_COLOR; ++i) {
+        if(chunk[i] != color) color = MIXED_COLOR;
+    }
+    if(color == 0) return;
+
+    levels[maxDepth][mortonCode] = color;
+    if(color == MIXED_COLOR) {
+        chunkOffsets[mortonCode] = chunkData.size();
+        encodeChunk(chunk, chunkWidth, chunkData);
+    }
+
+    for(int depth = (int)maxDepth - 1; depth >= 0; --depth) {
+        mortonCode >>= 3;
+        if(!levels[depth].emplace(mortonCode, MIXED_COLOR).second) break;
+    }
+}
+
+// Turns sparse levels, where every node that is not empty is a mixed node until its children say otherwise, into nodes
+void Octree::initOctreeFromSparseLevels(std::vector<SparseLevel>& levels, const std::unordered_map<uint64_t, uint32_t>& chunkOffsets) {
+    reduceSparseLevels(levels);
+
+    uint16_t rootColor = getSparseLevelColor(levels, 0, 0);
+    if(rootColor != MIXED_COLOR) {
+        nodes[0].data = rootColor;
+        return;
+    }
+
+    if(maxDepth == 0) {
+        nodes[0].data = chunkOffsets.at(0) | OctreeNode::CHUNK_FLAG;
+        return;
+    }
+
+    uint32_t rootChildMasks = getSparseChildMasks(levels, maxDepth, 0, 0);
+    unsigned int firstChildIndex = initChildrenFromSparseLevels(levels, chunkOffsets, 0, 0);
+    nodes[0] = OctreeNode(rootChildMasks, firstChildIndex);
+}
+
+// Creates the children of a mixed node at the end of 'nodes' in the same order as initOctree. Returns the index of the first child.
+unsigned int Octree::initChildrenFromSparseLevels(const std::vector<SparseLevel>& levels, const std::unordered_map<uint64_t, uint32_t>& chunkOffsets, unsigned int depth, uint64_t mortonCode) {
+    uint32_t childMasks = getSparseChildMasks(levels, maxDepth, depth, mortonCode);
+    unsigned int firstChildIndex = nodes.size();
+    nodes.resize(firstChildIndex + getChildCount(childMasks));
+
+    unsigned int childIndex = firstChildIndex;
+    for(int i = 0; i < 8; ++i) {
+        if((childMasks & (1 << i)) == 0) continue;
+
+        uint64_t childMortonCode = (mortonCode << 3) | i;
+        uint16_t color = getSparseLevelColor(levels, depth + 1, childMortonCode);
+
+        if(color != MIXED_COLOR) {
+            nodes[childIndex].data = color;
+        }
+        else if(depth + 1 >= maxDepth) {
+            nodes[childIndex].data = chunkOffsets.at(childMortonCode) | OctreeNode::CHUNK_FLAG;
+        }
+        else {
+            uint32_t grandChildMasks = getSparseChildMasks(levels, maxDepth, depth + 1, childMortonCode);
+            unsigned int firstGrandChildIndex = initChildrenFromSparseLevels(levels, chunkOffsets, depth + 1, childMortonCode);
+            nodes[childIndex] = OctreeNode(grandChildMasks, firstGrandChildIndex);
+        }
+        childIndex++;
+    }
+
+    return firstChildIndex;
+}
+
+bool Octree::fillBox(unsigned int minX, unsigned int minY, unsigned int minZ, unsigned int maxX, unsigned int maxY, unsigned int maxZ, uint8_t paletteIndex) {
+    if(isDAG) {
+        std::cout << "ERROR: A DAG can not be edited" << std::endl;
+        return false;
+    }
+
+    EditBox box = { { minX, minY, minZ }, { std::min(maxX, worldWidth), std::min(maxY, worldWidth), std::min(maxZ, worldWidth) } };
+    if(box.min[0] >= box.max[0] || box.min[1] >= box.max[1] || box.min[2] >= box.max[2]) return true;
+    m_isEdited = true;
+
+    OctreeNode root = fillNode(nodes[0], 0, 0, 0, 0, box, paletteIndex);
+    if(root.childMasks != nodes[0].childMasks || root.data != nodes[0].data) {
+        nodes[0] = root;
+        m_dirtyNodeRanges.push_back({ 0, sizeof(OctreeNode) });
+        m_ropeDirtyNodeRanges.push_back({ 0, sizeof(OctreeNode) });
+    }
+    return true;
+}
+
+std::vector<OctreeDirtyRange> Octree::takeDirtyNodeRanges() {
+    return mergeDirtyRanges(m_dirtyNodeRanges);
+}
+
+std::vector<OctreeDirtyRange> Octree::takeDirtyChunkDataRanges() {
+    return mergeDirtyRanges(m_dirtyChunkDataRanges);
+}
+
+std::vector<OctreeDirtyRange> Octree::updateRopes(std::vector<uint32_t>& ropes) {
+    std::vector<OctreeDirtyRange> dirtyNodeRanges = mergeDirtyRanges(m_ropeDirtyNodeRanges);
+    if(dirtyNodeRanges.empty()) return {};
+    if(nodes.size() >= (1u << ROPE_DEPTH_SHIFT)) {
+        std::cout << "ERROR: The octree has too many nodes for ropes" << std::endl;
+        ropes.clear();
+        return {};
+    }
+
+    size_t oldRopeCount = ropes.size();
+    ropes.resize(nodes.size() * 6, (uint32_t)NO_ROPE);
+
+    std::vector<OctreeDirtyRange> dirtyRopeRanges;
+    if(ropes.size() > oldRopeCount) dirtyRopeRanges.push_back({ oldRopeCount * sizeof(uint32_t), (ropes.size() - oldRopeCount) * sizeof(uint32_t) });
+    updateChildRopes(nodes.data(), ropes, dirtyNodeRanges, 0, 0, dirtyRopeRanges);
+    return mergeDirtyRanges(dirtyRopeRanges);
+}
+
+// Returns the node that replaces 'node', the node at 'x', 'y', 'z' in voxels and 'depth' in the octree, once the part of it inside 'box' has
+//  been filled. A single color node that is partly inside the box is split into eight children of its color, which are filled in turn, and
+//  children that all end up with the same color are merged back into one node. A block of children is rewritten where it is if the number of
+//  children stays the same, and is moved to a new block otherwise.
+OctreeNode Octree::fillNode(OctreeNode node, unsigned int depth, unsigned int x, unsigned int y, unsigned int z, const EditBox& box, uint8_t paletteIndex) {
+    unsigned int width = worldWidth >> depth;
+    unsigned int position[3] = { x, y, z };
+    bool isCovered = true;
+    for(int axis = 0; axis < 3; ++axis) {
+        if(box.max[axis] <= position[axis] || box.min[axis] >= position[axis] + width) return node;
+        if(box.min[axis] > position[axis] || box.max[axis] < position[axis] + width) isCovered = false;
+    }
+
+    bool isChunk = node.childMasks == 0 && (node.data & OctreeNode::CHUNK_FLAG) != 0;
+    if(node.childMasks == 0 && !isChunk && node.data == paletteIndex) return node;
+
+    if(isCovered) {
+        freeDescendants(node);
+        return OctreeNode(0, paletteIndex);
+    }
+
+    if(depth == maxDepth) return fillChunk(node, x, y, z, box, paletteIndex);
+
+    OctreeNode children[8];
+    unsigned int childCount = getChildCount(node.childMasks);
+    unsigned int childIndex = node.data;
+    for(int i = 0; i < 8; ++i) {
+        if(node.childMasks == 0) children[i] = OctreeNode(0, node.data);
+        else if((node.childMasks & (1 << i)) != 0) children[i] = nodes[childIndex++];
+    }
+
+    unsigned int halfWidth = width / 2;
+    uint32_t childMasks = 0;
+    bool isSolidColor = true;
+    for(int i = 0; i < 8; ++i) {
+        unsigned int cx = x + ((i % 2 == 0) ? 0 : halfWidth);
+        unsigned int cy = y + ((i % 4 <  2) ? 0 : halfWidth);
+        unsigned int cz = z + ((i % 8 <  4) ? 0 : halfWidth);
+        children[i] = fillNode(children[i], depth + 1, cx, cy, cz, box, paletteIndex);
+
+        if(children[i].childMasks != 0 || children[i].data != 0) childMasks |= 1 << i;
+        if(children[i].childMasks == 0) childMasks |= 1 << (i + 8);
+        if(children[i].childMasks != 0 || (children[i].data & OctreeNode::CHUNK_FLAG) != 0 || children[i].data != children[0].data) isSolidColor = false;
+    }
+
+    if(isSolidColor) {
+        if(childCount > 0) m_freeNodeBlocks[childCount].push_back(node.data);
+        return OctreeNode(0, children[0].data);
+    }
+
+    unsigned int newChildCount = getChildCount(childMasks);
+    unsigned int firstChildIndex = node.data;
+    if(newChildCount != childCount) {
+        if(childCount > 0) m_freeNodeBlocks[childCount].push_back(node.data);
+        firstChildIndex = allocateNodeBlock(newChildCount);
+    }
+
+    childIndex = firstChildIndex;
+    for(int i = 0; i < 8; ++i) {
+        if((childMasks & (1 << i)) != 0) nodes[childIndex++] = children[i];
+    }
+    m_dirtyNodeRanges.push_back({ firstChildIndex * sizeof(OctreeNode), newChildCount * sizeof(OctreeNode) });
+    m_ropeDirtyNodeRanges.push_back({ firstChildIndex * sizeof(OctreeNode), newChildCount * sizeof(OctreeNode) });
+
+    return OctreeNode(childMasks, firstChildIndex);
+}
+
+// Fills the part of a chunk level node inside 'box' and encodes the result again. The chunk stays in its slot if its encoded size does not
+//  change, which is the common case for small edits.
+OctreeNode Octree::fillChunk(OctreeNode node, unsigned int x, unsigned int y, unsigned int z, const EditBox& box, uint8_t paletteIndex) {
+    unsigned int chunkWidth = worldWidth >> maxDepth;
+    std::vector<uint8_t> voxels(chunkWidth * chunkWidth * chunkWidth);
+
+    bool isChunk = (node.data & OctreeNode::CHUNK_FLAG) != 0;
+    unsigned int chunkOffset = node.data & ~OctreeNode::CHUNK_FLAG;
+    unsigned int chunkSize = 0;
+    if(isChunk) {
+        decodeChunk(chunkData.data() + chunkOffset, chunkWidth, voxels.data());
+        chunkSize = getEncodedChunkSize(chunkData.data() + chunkOffset, chunkWidth);
+    }
+    else {
+        std::fill(voxels.begin(), voxels.end(), node.data);
+    }
+
+    unsigned int startX = std::max(box.min[0], x) - x, endX = std::min(box.max[0], x + chunkWidth) - x;
+    unsigned int startY = std::max(box.min[1], y) - y, endY = std::min(box.max[1], y + chunkWidth) - y;
+    unsigned int startZ = std::max(box.min[2], z) - z, endZ = std::min(box.max[2], z + chunkWidth) - z;
+    for(unsigned int cz = startZ; cz < endZ; ++cz) {
+        for(unsigned int cy = startY; cy < endY; ++cy) {
+            std::memset(voxels.data() + startX + cy * chunkWidth + cz * chunkWidth * chunkWidth, paletteIndex, endX - startX);
+        }
+    }
+
+    if(std::all_of(voxels.begin(), voxels.end(), [&voxels](uint8_t voxel) { return voxel == voxels[0]; })) {
+        if(isChunk) freeChunkSlot(chunkOffset, chunkSize);
+        return OctreeNode(0, voxels[0]);
+    }
+
+    std::vector<uint8_t> encodedChunk;
+    encodeChunk(voxels.data(), chunkWidth, encodedChunk);
+    if(!isChunk || encodedChunk.size() != chunkSize) {
+        if(isChunk) freeChunkSlot(chunkOffset, chunkSize);
+        chunkOffset = allocateChunkSlot(encodedChunk.size());
+    }
+    std::memcpy(chunkData.data() + chunkOffset, encodedChunk.data(), encodedChunk.size());
+    m_dirtyChunkDataRanges.push_back({ chunkOffset, encodedChunk.size() });
+
+    return OctreeNode(0, chunkOffset | OctreeNode::CHUNK_FLAG);
+}
+
+// Frees the blocks of children and the chunks below a node
+void Octree::freeDescendants(const OctreeNode& node) {
+    if(node.childMasks == 0) {
+        if((node.data & OctreeNode::CHUNK_FLAG) != 0) {
+            unsigned int chunkOffset = node.data & ~OctreeNode::CHUNK_FLAG;
+            freeChunkSlot(chunkOffset, getEncodedChunkSize(chunkData.data() + chunkOffset, worldWidth >> maxDepth));
+        }
+        return;
+    }
+
+    unsigned int childCount = getChildCount(node.childMasks);
+    for(unsigned int i = 0; i < childCount; ++i) freeDescendants(nodes[node.data + i]);
+    m_freeNodeBlocks[childCount].push_back(node.data);
+}
+
+// Returns the index of a block of 'nodeCount' nodes, taken from the smallest free block that is large enough or from the end of 'nodes'
+unsigned int Octree::allocateNodeBlock(unsigned int nodeCount) {
+    for(unsigned int blockSize = nodeCount; blockSize < m_freeNodeBlocks.size(); ++blockSize) {
+        std::vector<unsigned int>& freeBlocks = m_freeNodeBlocks[blockSize];
+        if(freeBlocks.empty()) continue;
+
+        unsigned int blockIndex = freeBlocks.back();
+        freeBlocks.pop_back();
+        if(blockSize > nodeCount) m_freeNodeBlocks[blockSize - nodeCount].push_back(blockIndex + nodeCount);
+        return blockIndex;
+    }
+
+    unsigned int blockIndex = nodes.size();
+    nodes.resize(blockIndex + nodeCount);
+    return blockIndex;
+}
+
+// Returns the offset of 'size' bytes in chunkData, taken from the smallest free slot that is large enough or from the end of chunkData
+unsigned int Octree::allocateChunkSlot(unsigned int size) {
+    auto slot = m_freeChunkSlots.lower_bound(size);
+    if(slot != m_freeChunkSlots.end()) {
+        unsigned int slotSize = slot->first;
+        unsigned int offset = slot->second;
+        m_freeChunkSlots.erase(slot);
+        if(slotSize > size) m_freeChunkSlots.insert({ slotSize - size, offset + size });
+        return offset;
+    }
+
+    unsigned int offset = chunkData.size();
+    chunkData.resize(offset + size);
+    return offset;
+}
+
+void Octree::freeChunkSlot(unsigned int offset, unsigned int size) {
+    m_freeChunkSlots.insert({ size, offset });
+}
+
+void Octree::repack() {
+    std::vector<OctreeNode> oldNodes;
+    std::vector<uint8_t> oldChunkData;
+    std::swap(nodes, oldNodes);
+    std::swap(chunkData, oldChunkData);
+
+    nodes.push_back(oldNodes[0]);
+    if(oldNodes[0].childMasks != 0) {
+        nodes[0].data = repackChildren(oldNodes, oldChunkData, 0);
+    }
+    else if((oldNodes[0].data & OctreeNode::CHUNK_FLAG) != 0) {
+        const uint8_t* chunk = oldChunkData.data() + (oldNodes[0].data & ~OctreeNode::CHUNK_FLAG);
+        chunkData.assign(chunk, chunk + getEncodedChunkSize(chunk, worldWidth >> maxDepth));
+        nodes[0].data = OctreeNode::CHUNK_FLAG;
+    }
+
+    for(std::vector<unsigned int>& freeBlocks : m_freeNodeBlocks) freeBlocks.clear();
+    m_freeChunkSlots.clear();
+    m_dirtyNodeRanges.assign(1, { 0, nodes.size() * sizeof(OctreeNode) });
+    m_ropeDirtyNodeRanges.assign(1, { 0, nodes.size() * sizeof(OctreeNode) });
+    m_dirtyChunkDataRanges.assign(1, { 0, chunkData.size() });
+    m_isEdited = false;
+}
+
+// Copies the children of the node at 'oldIndex' in 'oldNodes' to the end of 'nodes', and then their descendants one child after another like
+//  initOctree. Returns the index of the first child.
+unsigned int Octree::repackChildren(const std::vector<OctreeNode>& oldNodes, const std::vector<uint8_t>& oldChunkData, unsigned int oldIndex) {
+    const OctreeNode& oldNode = oldNodes[oldIndex];
+    unsigned int childCount = getChildCount(oldNode.childMasks);
+    unsigned int firstChildIndex = nodes.size();
+    nodes.resize(firstChildIndex + childCount);
+
+    for(unsigned int i = 0; i < childCount; ++i) {
+        OctreeNode child = oldNodes[oldNode.data + i];
+        if(child.childMasks != 0) {
+            child.data = repackChildren(oldNodes, oldChunkData, oldNode.data + i);
+        }
+        else if((child.data & OctreeNode::CHUNK_FLAG) != 0) {
+            const uint8_t* chunk = oldChunkData.data() + (child.data & ~OctreeNode::CHUNK_FLAG);
+            child.data = chunkData.size() | OctreeNode::CHUNK_FLAG;
+            chunkData.insert(chunkData.end(), chunk, chunk + getEncodedChunkSize(chunk, worldWidth >> maxDepth));
+        }
+        nodes[firstChildIndex + i] = child;
+    }
+
+    return firstChildIndex;
+}
+
+uint16_t getLevelColor(const std::vector<std::vector<uint16_t>>& levels, unsigned int depth, unsigned int x, unsigned int y, unsigned int z) {
+    unsigned int levelWidth = 1 << depth;
+    return levels[depth][x + y * levelWidth + (size_t)z * levelWidth * levelWidth];
+}
+
+// Fills every level above 'deepestDepth' from the level below it. A node is a single color if all of its children are that color.
+void reduceLevels(std::vector<std::vector<uint16_t>>& levels, unsigned int deepestDepth) {
+    for(int depth = (int)deepestDepth - 1; depth >= 0; --depth) {
+        unsigned int width = 1 << depth;
+        std::vector<uint16_t>& level = levels[depth];
+        level.resize((size_t)width * width * width);
+
+        for(unsigned int z = 0; z < width; ++z) {
+            for(unsigned int y = 0; y < width; ++y) {
+                for(unsigned int x = 0; x < width; ++x) {
+                    uint16_t childColors[8];
+                    for(int i = 0; i < 8; ++i) {
+                        unsigned int cx = x * 2 + ((i % 2 == 0) ? 0 : 1);
+                        unsigned int cy = y * 2 + ((i % 4 <  2) ? 0 : 1);
+                        unsigned int cz = z * 2 + ((i % 8 <  4) ? 0 : 1);
+                        childColors[i] = getLevelColor(levels, depth + 1, cx, cy, cz);
+                    }
+                    level[x + y * width + (size_t)z * width * width] = mergeChildColors(childColors);
+                }
+            }
+        }
+    }
+}
+
+// Returns the color of a node from the colors of its eight children, MIXED_COLOR unless they are all the same. Shared by the dense and
+//  sparse levels.
+uint16_t mergeChildColors(const uint16_t* childColors) {
+    for(int i = 1; i < 8; ++i) {
+        if(childColors[i] != childColors[0]) return MIXED_COLOR;
+    }
+    return childColors[0];
+}
+
+// Returns the child masks of a mixed node from the colors of its eight children. Children at the deepest level are chunks, so they are
+//  leaves even if they are mixed.
+uint32_t getChildMasksFromColors(const uint16_t* childColors, bool childrenAtMaxDepth) {
+    uint32_t childMasks = 0;
+    for(int i = 0; i < 8; ++i) {
+        if(childColors[i] != 0) childMasks |= 1 << i;
+        if(childColors[i] != MIXED_COLOR || childrenAtMaxDepth) childMasks |= 1 << (i + 8);
+    }
+    return childMasks;
+}
+
+// Returns the child masks of the mixed node at position 'x', 'y', 'z' in level 'depth'
+uint32_t getChildMasks(const std::vector<std::vector<uint16_t>>& levels, unsigned int maxDepth, unsigned int depth, unsigned int x, unsigned int y, unsigned int z) {
+    uint16_t childColors[8];
+    for(int i = 0; i < 8; ++i) {
+        unsigned int cx = x * 2 + ((i % 2 == 0) ? 0 : 1);
+        unsigned int cy = y * 2 + ((i % 4 <  2) ? 0 : 1);
+        unsigned int cz = z * 2 + ((i % 8 <  4) ? 0 : 1);
+        childColors[i] = getLevelColor(levels, depth + 1, cx, cy, cz);
+    }
+    return getChildMasksFromColors(childColors, depth + 1 >= maxDepth);
+}
+
+// Interleaves the bits of the coordinates as zyxzyx...zyx, so that the code of child 'i' is the code of its parent shifted up by three with 'i'
+//  in the lowest bits. Every coordinate can have up to 21 bits.
+uint64_t getMortonCode(unsigned int x, unsigned int y, unsigned int z) {
+    auto spreadBits = [](uint64_t value) {
+        value &= 0x1FFFFF;
+        value = (value | (value << 32)) & 0x1F00000000FFFFull;
+        value = (value | (value << 16)) & 0x1F0000FF0000FFull;
+        value = (value | (value << 8)) & 0x100F00F00F00F00Full;
+        value = (value | (value << 4)) & 0x10C30C30C30C30C3ull;
+        value = (value | (value << 2)) & 0x1249249249249249ull;
+        return value;
+    };
+    return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+}
+
+uint16_t getSparseLevelColor(const std::vector<std::unordered_map<uint64_t, uint16_t>>& levels, unsigned int depth, uint64_t mortonCode) {
+    auto it = levels[depth].find(mortonCode);
+    return (it != levels[depth].end()) ? it->second : 0;
+}
+
+// Resolves the mixed nodes of sparse levels from the deepest level up. A mixed node whose children are all the same color becomes that color
+//  and its children are removed, and a mixed node without children is removed.
+void reduceSparseLevels(std::vector<std::unordered_map<uint64_t, uint16_t>>& levels) {
+    for(int depth = (int)levels.size() - 2; depth >= 0; --depth) {
+        std::unordered_map<uint64_t, uint16_t>& level = levels[depth];
+        std::unordered_map<uint64_t, uint16_t>& childLevel = levels[depth + 1];
+
+        for(auto it = level.begin(); it != level.end();) {
+            if(it->second != MIXED_COLOR) {
+                ++it;
+                continue;
+            }
+
+            uint16_t childColors[8];
+            for(int i = 0; i < 8; ++i) childColors[i] = getSparseLevelColor(levels, depth + 1, (it->first << 3) | i);
+            uint16_t color = mergeChildColors(childColors);
+
+            if(color == MIXED_COLOR) {
+                ++it;
+                continue;
+            }
+            for(int i = 0; i < 8; ++i) childLevel.erase((it->first << 3) | i);
+            if(color == 0) {
+                it = level.erase(it);
+            }
+            else {
+                it->second = color;
+                ++it;
+            }
+        }
+    }
+}
+
+// Returns the child masks of the mixed node with 'mortonCode' in level 'depth' of sparse levels
+uint32_t getSparseChildMasks(const std::vector<std::unordered_map<uint64_t, uint16_t>>& levels, unsigned int maxDepth, unsigned int depth, uint64_t mortonCode) {
+    uint16_t childColors[8];
+    for(int i = 0; i < 8; ++i) childColors[i] = getSparseLevelColor(levels, depth + 1, (mortonCode << 3) | i);
+    return getChildMasksFromColors(childColors, depth + 1 >= maxDepth);
+}
+
+unsigned int getChildCount(uint32_t childMasks) {
+    return std::bitset<8>(childMasks & 0xFF).count();
+}
+
+// Appends the voxels of a chunk to 'chunkData' as a local palette and one index into it per voxel, using the fewest bits per index (1, 2, 4
+//  or 8) that fit the number of colors in the chunk. The encoded chunk is laid out in 32-bit words so that the shaders can read it directly:
+//      word 0: bits per index in bits 0-7 and the local palette size in bits 8-16,
+//      then the occupancy mask, one bit per sub-block of SUB_BLOCK_WIDTH^3 voxels that is set if any voxel in it is not empty,
+//      then the local palette, one byte per color, padded to a whole word,
+//      then the indices, packed from the lowest bit of each word upwards, in the same voxel order as the world.
+//  An index never crosses a word. Chunks with more than 16 colors store their palette indices as 8-bit indices and an empty local palette.
+void encodeChunk(const uint8_t* voxels, unsigned int chunkWidth, std::vector<uint8_t>& chunkData) {
+    unsigned int chunkSize = chunkWidth * chunkWidth * chunkWidth;
+    bool usedColors[256] = {};
+    for(unsigned int i = 0; i < chunkSize; ++i) usedColors[voxels[i]] = true;
+
+    uint8_t localIndices[256];
+    uint8_t localPalette[256];
+    unsigned int paletteSize = 0;
+    for(unsigned int color = 0; color < 256; ++color) {
+        if(!usedColors[color]) continue;
+        localIndices[color] = paletteSize;
+        localPalette[paletteSize++] = color;
+    }
+
+    unsigned int bitsPerIndex = 8;
+    if(paletteSize <= 2) bitsPerIndex = 1;
+    else if(paletteSize <= 4) bitsPerIndex = 2;
+    else if(paletteSize <= 16) bitsPerIndex = 4;
+    else paletteSize = 0;
+
+    size_t start = chunkData.size();
+    unsigned int occupancyBytes = getOccupancyWordCount(chunkWidth) * 4;
+    unsigned int paletteBytes = (paletteSize + 3) & ~3u;
+    unsigned int indexWords = (chunkSize * bitsPerIndex + 31) / 32;
+    chunkData.resize(start + 4 + occupancyBytes + paletteBytes + indexWords * 4, 0);
+
+    uint8_t* chunk = chunkData.data() + start;
+    uint32_t header = bitsPerIndex | (paletteSize << 8);
+    std::memcpy(chunk, &header, 4);
+
+    // Sub-blocks on the far sides of the chunk are cut off when the chunk width is not a multiple of SUB_BLOCK_WIDTH
+    uint8_t* occupancy = chunk + 4;
+    unsigned int subBlocksPerRow = (chunkWidth + Octree::SUB_BLOCK_WIDTH - 1) / Octree::SUB_BLOCK_WIDTH;
+    for(unsigned int z = 0; z < chunkWidth; ++z) {
+        for(unsigned int y = 0; y < chunkWidth; ++y) {
+            const uint8_t* row = voxels + y * chunkWidth + z * chunkWidth * chunkWidth;
+            unsigned int subBlockRow = (y / Octree::SUB_BLOCK_WIDTH) * subBlocksPerRow + (z / Octree::SUB_BLOCK_WIDTH) * subBlocksPerRow * subBlocksPerRow;
+            for(unsigned int x = 0; x < chunkWidth; ++x) {
+                if(row[x] == 0) continue;
+                unsigned int subBlock = subBlockRow + x / Octree::SUB_BLOCK_WIDTH;
+                occupancy[subBlock / 8] |= 1 << (subBlock % 8);
+            }
+        }
+    }
+
+    std::memcpy(chunk + 4 + occupancyBytes, localPalette, paletteSize);
+
+    uint8_t* indices = chunk + 4 + occupancyBytes + paletteBytes;
+    if(bitsPerIndex == 8) {
+        std::memcpy(indices, voxels, chunkSize);
+        return;
+    }
+
+    unsigned int indicesPerWord = 32 / bitsPerIndex;
+    for(unsigned int word = 0; word < indexWords; ++word) {
+        uint32_t packedIndices = 0;
+        unsigned int first = word * indicesPerWord;
+        unsigned int count = std::min(indicesPerWord, chunkSize - first);
+        for(unsigned int i = 0; i < count; ++i) {
+            packedIndices |= (uint32_t)localIndices[voxels[first + i]] << (i * bitsPerIndex);
+        }
+        std::memcpy(indices + word * 4, &packedIndices, 4);
+    }
+}
+
+// Returns the number of bytes of an encoded chunk
+unsigned int getEncodedChunkSize(const uint8_t* chunk, unsigned int chunkWidth) {
+    uint32_t header;
+    std::memcpy(&header, chunk, 4);
+    unsigned int bitsPerIndex = header & 0xFF;
+    unsigned int paletteSize = header >> 8;
+    unsigned int chunkSize = chunkWidth * chunkWidth * chunkWidth;
+    return 4 + getOccupancyWordCount(chunkWidth) * 4 + ((paletteSize + 3) & ~3u) + ((chunkSize * bitsPerIndex + 31) / 32) * 4;
+}
+
+// Writes the palette index of every voxel of an encoded chunk to 'voxels', in the order encodeChunk reads them
+void decodeChunk(const uint8_t* chunk, unsigned int chunkWidth, uint8_t* voxels) {
+    uint32_t header;
+    std::memcpy(&header, chunk, 4);
+    unsigned int bitsPerIndex = header & 0xFF;
+    unsigned int paletteSize = header >> 8;
+    unsigned int chunkSize = chunkWidth * chunkWidth * chunkWidth;
+
+    const uint8_t* localPalette = chunk + 4 + getOccupancyWordCount(chunkWidth) * 4;
+    const uint8_t* indices = localPalette + ((paletteSize + 3) & ~3u);
+    if(bitsPerIndex == 8) {
+        std::memcpy(voxels, indices, chunkSize);
+        return;
+    }
+
+    unsigned int indicesPerWord = 32 / bitsPerIndex;
+    uint32_t indexMask = (1u << bitsPerIndex) - 1;
+    for(unsigned int first = 0; first < chunkSize; first += indicesPerWord) {
+        uint32_t packedIndices;
+        std::memcpy(&packedIndices, indices + first / indicesPerWord * 4, 4);
+        unsigned int count = std::min(indicesPerWord, chunkSize - first);
+        for(unsigned int i = 0; i < count; ++i) {
+            voxels[first + i] = localPalette[(packedIndices >> (i * bitsPerIndex)) & indexMask];
+        }
+    }
+}
+
+unsigned int getOccupancyWordCount(unsigned int chunkWidth) {
+    unsigned int subBlocksPerRow = (chunkWidth + Octree::SUB_BLOCK_WIDTH - 1) / Octree::SUB_BLOCK_WIDTH;
+    return (subBlocksPerRow * subBlocksPerRow * subBlocksPerRow + 31) / 32;
+}
+
+// Sorts the ranges and merges the ones that overlap or touch. 'ranges' is cleared.
+std::vector<OctreeDirtyRange> mergeDirtyRanges(std::vector<OctreeDirtyRange>& ranges) {
+    std::sort(ranges.begin(), ranges.end(), [](const OctreeDirtyRange& a, const OctreeDirtyRange& b) { return a.offset < b.offset; });
+
+    std::vector<OctreeDirtyRange> mergedRanges;
+    for(const OctreeDirtyRange& range : ranges) {
+        if(!mergedRanges.empty() && range.offset <= mergedRanges.back().offset + mergedRanges.back().size) {
+            OctreeDirtyRange& lastRange = mergedRanges.back();
+            lastRange.size = std::max(lastRange.offset + lastRange.size, range.offset + range.size) - lastRange.offset;
+        }
+        else {
+            mergedRanges.push_back(range);
+        }
+    }
+    ranges.clear();
+    return mergedRanges;
+}
+
+// Nodes are identical if they have the same child masks and the same solid color, the same chunk or children that are identical
+typedef std::array<unsigned int, 10> OctreeNodeKey;
+
+struct OctreeNodeKeyHash {
+    size_t operator()(const OctreeNodeKey& key) const {
+        uint64_t hash = 14695981039346656037ull;
+        for(unsigned int value : key) {
+            hash = (hash ^ value) * 1099511628211ull;
+        }
+        return hash;
+    }
+};
+
+uint64_t hashChunk(const uint8_t* chunk, unsigned int chunkSize) {
+    uint64_t hash = 14695981039346656037ull;
+    for(unsigned int i = 0; i < chunkSize; ++i) {
+        hash = (hash ^ chunk[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void Octree::convertToDAG() {
+    if(isDAG) return;
+
+    // Edits leave freed nodes behind and put children before their parents
+    if(m_isEdited) repack();
+
+    unsigned int chunkWidth = worldWidth >> maxDepth;
+
+    // Children always come after their parent, so going backwards every child is given its unique node before its parent is hashed
+    std::vector<unsigned int> uniqueNodes(nodes.size());
+    std::unordered_map<uint64_t, std::vector<unsigned int>> uniqueChunkNodes;
+    std::unordered_map<OctreeNodeKey, unsigned int, OctreeNodeKeyHash> uniqueOtherNodes;
+    for(int i = nodes.size() - 1; i >= 0; --i) {
+        const OctreeNode& node = nodes[i];
+        OctreeNodeKey key = {};
+        key[0] = node.childMasks;
+
+        if(node.childMasks == 0 && (node.data & OctreeNode::CHUNK_FLAG) != 0) {
+            const uint8_t* chunk = chunkData.data() + (node.data & ~OctreeNode::CHUNK_FLAG);
+            unsigned int encodedChunkSize = getEncodedChunkSize(chunk, chunkWidth);
+            std::vector<unsigned int>& sameHashNodes = uniqueChunkNodes[hashChunk(chunk, encodedChunkSize)];
+
+            uniqueNodes[i] = i;
+            for(unsigned int otherIndex : sameHashNodes) {
+                const uint8_t* otherChunk = chunkData.data() + (nodes[otherIndex].data & ~OctreeNode::CHUNK_FLAG);
+                if(getEncodedChunkSize(otherChunk, chunkWidth) == encodedChunkSize && std::memcmp(chunk, otherChunk, encodedChunkSize) == 0) {
+                    uniqueNodes[i] = otherIndex;
+                    break;
+                }
+            }
+            if(uniqueNodes[i] == (unsigned int)i) sameHashNodes.push_back(i);
+            continue;
+        }
+        else if(node.childMasks == 0) {
+            key[1] = node.data;
+        }
+        else {
+            for(unsigned int c = 0; c < getChildCount(node.childMasks); ++c) key[c + 2] = uniqueNodes[node.data + c];
+        }
+
+        auto inserted = uniqueOtherNodes.insert({key, i});
+        uniqueNodes[i] = inserted.first->second;
+    }
+
+    std::vector<OctreeNode> treeNodes;
+    std::vector<uint8_t> treeChunkData;
+    std::swap(nodes, treeNodes);
+    std::swap(chunkData, treeChunkData);
+
+    // Maps every unique node to the index of its first child in the DAG, or for chunks to their index in chunkData
+    std::vector<unsigned int> dagIndices(treeNodes.size(), UINT32_MAX);
+    nodes.push_back(treeNodes[0]);
+    if(treeNodes[0].childMasks != 0) {
+        nodes[0].data = copyDAGChildren(treeNodes, treeChunkData, uniqueNodes, dagIndices, 0);
+    }
+    else if((treeNodes[0].data & OctreeNode::CHUNK_FLAG) != 0) {
+        chunkData = treeChunkData;
+    }
+
+    isDAG = true;
+}
+
+// Copies the children of the unique node of 'treeIndex' into the DAG, in the same order as initOctree, unless they have already been copied.
+//  Returns the index of the first child in the DAG.
+unsigned int Octree::copyDAGChildren(const std::vector<OctreeNode>& treeNodes, const std::vector<uint8_t>& treeChunkData, const std::vector<unsigned int>& uniqueNodes, std::vector<unsigned int>& dagIndices, unsigned int treeIndex) {
+    unsigned int uniqueIndex = uniqueNodes[treeIndex];
+    if(dagIndices[uniqueIndex] != UINT32_MAX) return dagIndices[uniqueIndex];
+
+    const OctreeNode& treeNode = treeNodes[uniqueIndex];
+    unsigned int childCount = getChildCount(treeNode.childMasks);
+    unsigned int firstChildIndex = nodes.size();
+    dagIndices[uniqueIndex] = firstChildIndex;
+    nodes.resize(firstChildIndex + childCount);
+
+    for(unsigned int c = 0; c < childCount; ++c) {
+        unsigned int uniqueChildIndex = uniqueNodes[treeNode.data + c];
+        const OctreeNode& treeChild = treeNodes[uniqueChildIndex];
+        nodes[firstChildIndex + c] = treeChild;
+
+        if(treeChild.childMasks != 0) {
+            unsigned int firstGrandChildIndex = copyDAGChildren(treeNodes, treeChunkData, uniqueNodes, dagIndices, uniqueChildIndex);
+            nodes[firstChildIndex + c].data = firstGrandChildIndex;
+        }
+        else if((treeChild.data & OctreeNode::CHUNK_FLAG) != 0) {
+            if(dagIndices[uniqueChildIndex] == UINT32_MAX) {
+                unsigned int chunkWidth = worldWidth >> maxDepth;
+                unsigned int treeChunkIndex = treeChild.data & ~OctreeNode::CHUNK_FLAG;
+                unsigned int encodedChunkSize = getEncodedChunkSize(treeChunkData.data() + treeChunkIndex, chunkWidth);
+                dagIndices[uniqueChildIndex] = chunkData.size();
+                chunkData.insert(chunkData.end(), treeChunkData.begin() + treeChunkIndex, treeChunkData.begin() + treeChunkIndex + encodedChunkSize);
+            }
+            nodes[firstChildIndex + c].data = dagIndices[uniqueChildIndex] | OctreeNode::CHUNK_FLAG;
+        }
+    }
+
+    return firstChildIndex;
+}
+
+std::vector<uint32_t> Octree::buildRopes(const OctreeNode* nodes, unsigned int nodeCount) {
+    if(nodeCount >= (1u << ROPE_DEPTH_SHIFT)) {
+        std::cout << "ERROR: The octree has too many nodes for ropes" << std::endl;
+        return {};
+    }
+
+    std::vector<uint32_t> ropes(nodeCount * 6, NO_ROPE);
+    initChildRopes(nodes, ropes, 0, 0);
+    return ropes;
+}
+
+// Returns the rope of 'child' of the node at 'nodeIndex' through 'face', from the ropes of the node. A face between two children leads to
+//  the sibling, or to the node itself if the sibling is empty. Any other face leads to the child of the node's neighbour that is next to it,
+//  if the neighbour is as large as the node and has that child, and otherwise to the neighbour.
+uint32_t getChildRope(const OctreeNode* nodes, const std::vector<uint32_t>& ropes, unsigned int nodeIndex, unsigned int depth, unsigned int child, unsigned int face) {
+    const OctreeNode& node = nodes[nodeIndex];
+
+    // Bit 'axis' of the child index is set for the children on the positive side of that axis
+    unsigned int axisBit = 1 << (face / 2);
+    bool positiveFace = (face & 1) != 0;
+    unsigned int neighbourChild = child ^ axisBit;
+    uint32_t neighbourChildBit = 1 << neighbourChild;
+
+    if(((child & axisBit) != 0) != positiveFace) {
+        if((node.childMasks & neighbourChildBit) != 0) {
+            return (node.data + getChildCount(node.childMasks & (neighbourChildBit - 1))) | ((depth + 1) << Octree::ROPE_DEPTH_SHIFT);
+        }
+        return nodeIndex | (depth << Octree::ROPE_DEPTH_SHIFT);
+    }
+
+    uint32_t rope = ropes[nodeIndex * 6 + face];
+    if(rope != Octree::NO_ROPE && (rope >> Octree::ROPE_DEPTH_SHIFT) == depth) {
+        const OctreeNode& neighbour = nodes[rope & ((1 << Octree::ROPE_DEPTH_SHIFT) - 1)];
+        if((neighbour.childMasks & neighbourChildBit) != 0) {
+            rope = (neighbour.data + getChildCount(neighbour.childMasks & (neighbourChildBit - 1))) | ((depth + 1) << Octree::ROPE_DEPTH_SHIFT);
+        }
+    }
+    return rope;
+}
+
+// Sets the ropes of the children of the node at 'nodeIndex' from the ropes of the node, and then the ropes of their descendants
+void initChildRopes(const OctreeNode* nodes, std::vector<uint32_t>& ropes, unsigned int nodeIndex, unsigned int depth) {
+    const OctreeNode& node = nodes[nodeIndex];
+    if(node.childMasks == 0) return;
+
+    for(unsigned int child = 0; child < 8; ++child) {
+        uint32_t childBit = 1 << child;
+        if((node.childMasks & childBit) == 0) continue;
+        unsigned int childIndex = node.data + getChildCount(node.childMasks & (childBit - 1));
+
+        for(unsigned int face = 0; face < 6; ++face) {
+            ropes[childIndex * 6 + face] = getChildRope(nodes, ropes, nodeIndex, depth, child, face);
+        }
+
+        initChildRopes(nodes, ropes, childIndex, depth + 1);
+    }
+}
+
+bool isNodeInRanges(const std::vector<OctreeDirtyRange>& nodeRanges, unsigned int nodeIndex) {
+    size_t offset = (size_t)nodeIndex * sizeof(OctreeNode);
+    auto it = std::upper_bound(nodeRanges.begin(), nodeRanges.end(), offset, [](size_t offset, const OctreeDirtyRange& range) { return offset < range.offset; });
+    return it != nodeRanges.begin() && offset < (it - 1)->offset + (it - 1)->size;
+}
+
+// Sets the ropes of the children of the node at 'nodeIndex' again, and descends into the children whose descendants' ropes can have changed.
+//  The ropes of a node's children only depend on the node, its ropes and the nodes of the same size that they lead to. Every node that an
+//  edit wrote, moved or gave new children is in 'dirtyNodeRanges', so a child is skipped if its ropes are the same as before and neither it
+//  nor the neighbours of the same size that its ropes lead to are dirty. The byte ranges of the ropes that changed are added to
+//  'dirtyRopeRanges'.
+void updateChildRopes(const OctreeNode* nodes, std::vector<uint32_t>& ropes, const std::vector<OctreeDirtyRange>& dirtyNodeRanges, unsigned int nodeIndex, unsigned int depth, std::vector<OctreeDirtyRange>& dirtyRopeRanges) {
+    const OctreeNode& node = nodes[nodeIndex];
+    if(node.childMasks == 0) return;
+
+    bool ropesChanged = false;
+    for(unsigned int child = 0; child < 8; ++child) {
+        uint32_t childBit = 1 << child;
+        if((node.childMasks & childBit) == 0) continue;
+        unsigned int childIndex = node.data + getChildCount(node.childMasks & (childBit - 1));
+
+        bool updateDescendants = isNodeInRanges(dirtyNodeRanges, childIndex);
+        for(unsigned int face = 0; face < 6; ++face) {
+            uint32_t rope = getChildRope(nodes, ropes, nodeIndex, depth, child, face);
+            if(ropes[childIndex * 6 + face] != rope) {
+                ropes[childIndex * 6 + face] = rope;
+                ropesChanged = true;
+                updateDescendants = true;
+            }
+            else if(rope != Octree::NO_ROPE && (rope >> Octree::ROPE_DEPTH_SHIFT) == depth + 1) {
+                updateDescendants = updateDescendants || isNodeInRanges(dirtyNodeRanges, rope & ((1 << Octree::ROPE_DEPTH_SHIFT) - 1));
             }
         }
+
+        if(updateDescendants) updateChildRopes(nodes, ropes, dirtyNodeRanges, childIndex, depth + 1, dirtyRopeRanges);
     }
+
+    if(ropesChanged) dirtyRopeRanges.push_back({ node.data * 6 * sizeof(uint32_t), getChildCount(node.childMasks) * 6 * sizeof(uint32_t) });
 }
\ No newline at end of file
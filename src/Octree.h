@@ -1,28 +1,172 @@
 #pragma once
 #include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <map>
+#include <array>
 #include <cstdint>
+#include <cstddef>
 
+// Nodes only exist for children that are not empty, and the children of a node are stored next to each other in the order of their child index.
+//  The node of child 'i' is found at 'data + bitCount(childMasks & ((1 << i) - 1))'.
 struct OctreeNode {
-    OctreeNode(unsigned int parentIndex) : parentIndex(parentIndex), childrenIndices{0, 0, 0, 0, 0, 0, 0, 0}, dataIndex(0), isSolidColor(1) {}
-    const unsigned int parentIndex;
-    unsigned int childrenIndices[8];
-    int isSolidColor;
-    unsigned int dataIndex;
+    // Set in 'data' of a leaf whose voxels are stored in chunkData
+    static const uint32_t CHUNK_FLAG = 0x80000000;
+
+    OctreeNode() : childMasks(0), data(0) {}
+    OctreeNode(uint32_t childMasks, uint32_t data) : childMasks(childMasks), data(data) {}
+
+    uint32_t childMasks; // Bits 0-7 are set for children that are not empty, bits 8-15 for children that are leaves. Zero if the node is a leaf.
+    uint32_t data; // Index of the first child, or for leaves the palette index or the index of the chunk in chunkData with CHUNK_FLAG set.
+};
+
+enum class OctreeBuildMethod {
+    TopDown, BottomUp
+};
+
+class ThreadPool;
+
+// Fills 'destination' with the voxels of the z layers [startZ, startZ + depth), indexed as x + y * worldWidth + (z - startZ) * worldWidth^2.
+//  Returns false if the voxels could not be read.
+typedef std::function<bool(unsigned int startZ, unsigned int depth, uint8_t* destination)> VoxelSlabReader;
+
+// A voxel that is not empty, for building octrees from worlds that are too sparse to store every voxel
+struct SparseVoxel {
+    uint32_t x, y, z;
+    uint8_t paletteIndex;
+};
+
+// Returned by a VoxelRegionClassifier for a region whose voxels may not all be the same color
+const int MIXED_REGION = -1;
+// Returns the palette index of the cube of 'width' voxels at 'x', 'y', 'z' if every voxel in it has that index, and MIXED_REGION otherwise.
+//  Returning MIXED_REGION for a region that turns out to be a single color only costs time, the octree is the same.
+typedef std::function<int(unsigned int x, unsigned int y, unsigned int z, unsigned int width)> VoxelRegionClassifier;
+// Fills 'destination' with the voxels of the cube of 'width' voxels at 'x', 'y', 'z', indexed as x + y * width + z * width^2 from its corner
+typedef std::function<void(unsigned int x, unsigned int y, unsigned int z, unsigned int width, uint8_t* destination)> VoxelRegionReader;
+
+// A range of bytes in 'nodes' or 'chunkData' that was changed by an edit and has to be uploaded again
+struct OctreeDirtyRange {
+    size_t offset, size;
 };
 
 class Octree {
 public:
-    Octree(uint8_t* world, unsigned int worldWidth, unsigned int maxDepth);
+    // Width of the sub-blocks of a chunk that each have one bit in the chunk's occupancy mask, so that rays can skip empty sub-blocks
+    static const unsigned int SUB_BLOCK_WIDTH = 4;
+
+    // 'threadCount' is the number of threads used by the bottom up build, zero uses every available core
+    Octree(uint8_t* world, unsigned int worldWidth, unsigned int maxDepth, OctreeBuildMethod buildMethod = OctreeBuildMethod::BottomUp, unsigned int threadCount = 0);
+    // Reads the world one slab of z layers at a time and builds each slab while the next one is read. The slabs are as thick as the memory
+    //  budget allows for two of them, but never thinner than a chunk.
+    Octree(const VoxelSlabReader& readSlab, unsigned int worldWidth, unsigned int maxDepth, size_t slabMemoryBudget, unsigned int threadCount = 0);
+    // Builds the same octree as the dense constructor from the voxels that are not empty, in memory that grows with the number of voxels and
+    //  chunks that are not empty instead of with the world. Voxels outside the world are ignored, and the last of several voxels at the same
+    //  position wins.
+    Octree(const std::vector<SparseVoxel>& voxels, unsigned int worldWidth, unsigned int maxDepth);
+    // Builds the same octree as the dense constructor from procedural content. Regions are classified from the root down, and only the chunks
+    //  of regions that are classified as mixed all the way down are read.
+    Octree(const VoxelRegionClassifier& classifyRegion, const VoxelRegionReader& readRegion, unsigned int worldWidth, unsigned int maxDepth);
+
+    // Copies an octree, for example one that is mapped from a cache file, so that it can be edited
+    Octree(const OctreeNode* nodes, unsigned int nodeCount, const uint8_t* chunkData, size_t chunkDataSize, unsigned int worldWidth, unsigned int maxDepth, bool isDAG);
+
+    // Sets every voxel in the box from 'min' up to but not including 'max' to 'paletteIndex'. Single color nodes that are partly covered are
+    //  split and nodes that become a single color are merged, so the octree has the same nodes as one built from the edited world, only stored
+    //  in other places. Freed blocks of nodes and chunk slots are reused by later edits. DAGs can not be edited, and false is returned for them.
+    bool fillBox(unsigned int minX, unsigned int minY, unsigned int minZ, unsigned int maxX, unsigned int maxY, unsigned int maxZ, uint8_t paletteIndex);
+    bool clearBox(unsigned int minX, unsigned int minY, unsigned int minZ, unsigned int maxX, unsigned int maxY, unsigned int maxZ) { return fillBox(minX, minY, minZ, maxX, maxY, maxZ, 0); }
+    bool setVoxel(unsigned int x, unsigned int y, unsigned int z, uint8_t paletteIndex) { return fillBox(x, y, z, x + 1, y + 1, z + 1, paletteIndex); }
+
+    // Return the byte ranges of 'nodes' and 'chunkData' that were changed by edits since the last call, sorted and with touching ranges merged
+    std::vector<OctreeDirtyRange> takeDirtyNodeRanges();
+    std::vector<OctreeDirtyRange> takeDirtyChunkDataRanges();
+
+    // Stores 'nodes' and 'chunkData' in the order a newly built octree has them, which drops the blocks and slots that edits have freed
+    void repack();
+
+    // Shares identical chunks and identical subtrees so that each of them is only stored once, turning the octree into a directed acyclic graph.
+    //  Afterwards the children of a node can be the children of several nodes.
+    void convertToDAG();
+
+    // A rope holds the index of a node in its low ROPE_DEPTH_SHIFT bits and the depth of that node in the bits above
+    static const uint32_t ROPE_DEPTH_SHIFT = 27;
+    static const uint32_t NO_ROPE = 0xFFFFFFFF;
+
+    // Returns six ropes for every node, in the order -x, +x, -y, +y, -z, +z, so that a traversal can step to the next node without descending
+    //  from the root. Each rope points to the deepest node that contains the region of the same size as the node on the other side of the face,
+    //  which is a neighbour of the same size or a larger one. Faces on the edge of the world and nodes that are not in the tree (the blocks
+    //  that edits have freed) have NO_ROPE. The ropes depend on the path to a node, so they can not be built for a DAG, and they have to be
+    //  updated after an edit. Returns no ropes if the node indices do not fit in ROPE_DEPTH_SHIFT bits.
+    static std::vector<uint32_t> buildRopes(const OctreeNode* nodes, unsigned int nodeCount);
+    // Updates 'ropes', built by buildRopes before the edits since the last call, to the edited octree. Only the nodes that edits wrote or
+    //  moved, their face neighbours and the descendants whose ropes lead to them are visited, and blocks that edits have freed keep their old
+    //  ropes. Returns the byte ranges of 'ropes' that changed. 'ropes' is cleared if the node indices no longer fit.
+    std::vector<OctreeDirtyRange> updateRopes(std::vector<uint32_t>& ropes);
+
+    // Returns true if every voxel in the cube of 'width' voxels at 'startx', 'starty', 'startz' of a world as wide as this octree has the same
+    //  palette index. Used by the top down build, and public so that it can be benchmarked.
+    bool isSolidColor(uint8_t* world, int width, int startx, int starty, int startz);
 
 private:
+    // The descendants of a node that are built by one task before they are stitched into 'nodes'
+    struct OctreeSubtree {
+        unsigned int depth, x, y, z;
+        unsigned int nodeIndex; // Index of the first descendant in 'nodes'
+        unsigned int spineNodesBefore; // Number of nodes above the split depth that come before the subtree in 'nodes'
+        std::vector<OctreeNode> nodes;
+        std::vector<uint8_t> chunkData;
+    };
+
     void initOctree(uint8_t* world, unsigned int currentIndex, int depth, int startx, int starty, int startz);
-    bool isSolidColor(uint8_t* world, int width, int startx, int starty, int startz);
     void initData(uint8_t* world, OctreeNode& node, int width, int startx, int starty, int startz);
 
+    void initOctreeBottomUp(uint8_t* world, unsigned int threadCount);
+    void initLevels(uint8_t* world, std::vector<std::vector<uint16_t>>& levels, ThreadPool& threadPool);
+    unsigned int initSpineChildren(const std::vector<std::vector<uint16_t>>& levels, unsigned int splitDepth, unsigned int depth, unsigned int x, unsigned int y, unsigned int z, unsigned int& nodeIndex, std::vector<OctreeNode>& spineNodes, std::vector<OctreeSubtree>& subtrees);
+    void countSubtree(const std::vector<std::vector<uint16_t>>& levels, unsigned int depth, unsigned int x, unsigned int y, unsigned int z, unsigned int& nodeCount);
+    unsigned int initChildrenFromLevels(uint8_t* world, const std::vector<std::vector<uint16_t>>& levels, OctreeSubtree& subtree, unsigned int depth, unsigned int x, unsigned int y, unsigned int z);
+    void copyChunk(uint8_t* world, unsigned int x, unsigned int y, unsigned int z, std::vector<uint8_t>& destination);
+
+    void initOctreeFromSlabs(const VoxelSlabReader& readSlab, size_t slabMemoryBudget, unsigned int threadCount);
+    unsigned int initChildrenFromSlabSubtrees(const std::vector<std::vector<uint16_t>>& levels, std::vector<std::unique_ptr<Octree>>& slabSubtrees, unsigned int slabDepth, unsigned int depth, unsigned int x, unsigned int y, unsigned int z);
+
+    // Maps the Morton code of every node in a level that is not empty to its palette index, or to MIXED_COLOR if its voxels differ
+    typedef std::unordered_map<uint64_t, uint16_t> SparseLevel;
+
+    void initOctreeFromVoxels(const std::vector<SparseVoxel>& voxels);
+    void initSparseLevelsFromRegions(const VoxelRegionClassifier& classifyRegion, const VoxelRegionReader& readRegion, std::vector<SparseLevel>& levels, std::unordered_map<uint64_t, uint32_t>& chunkOffsets, std::vector<uint8_t>& chunk, unsigned int depth, unsigned int x, unsigned int y, unsigned int z);
+    void addSparseChunk(const uint8_t* chunk, std::vector<SparseLevel>& levels, std::unordered_map<uint64_t, uint32_t>& chunkOffsets, uint64_t mortonCode);
+    void initOctreeFromSparseLevels(std::vector<SparseLevel>& levels, const std::unordered_map<uint64_t, uint32_t>& chunkOffsets);
+    unsigned int initChildrenFromSparseLevels(const std::vector<SparseLevel>& levels, const std::unordered_map<uint64_t, uint32_t>& chunkOffsets, unsigned int depth, uint64_t mortonCode);
+
+    struct EditBox {
+        unsigned int min[3], max[3];
+    };
+
+    OctreeNode fillNode(OctreeNode node, unsigned int depth, unsigned int x, unsigned int y, unsigned int z, const EditBox& box, uint8_t paletteIndex);
+    OctreeNode fillChunk(OctreeNode node, unsigned int x, unsigned int y, unsigned int z, const EditBox& box, uint8_t paletteIndex);
+    void freeDescendants(const OctreeNode& node);
+    unsigned int allocateNodeBlock(unsigned int nodeCount);
+    unsigned int allocateChunkSlot(unsigned int size);
+    void freeChunkSlot(unsigned int offset, unsigned int size);
+    unsigned int repackChildren(const std::vector<OctreeNode>& oldNodes, const std::vector<uint8_t>& oldChunkData, unsigned int oldIndex);
+
+    unsigned int copyDAGChildren(const std::vector<OctreeNode>& treeNodes, const std::vector<uint8_t>& treeChunkData, const std::vector<unsigned int>& uniqueNodes, std::vector<unsigned int>& dagIndices, unsigned int treeIndex);
+
 public:
     const unsigned int worldWidth;
     const unsigned int maxDepth;
+    bool isDAG;
     
-    std::vector<uint8_t> chunkData;
+    std::vector<uint8_t> chunkData; // Encoded chunks, each one a local palette and bit-packed indices into it (see encodeChunk in Octree.cpp)
     std::vector<OctreeNode> nodes;
+
+private:
+    std::array<std::vector<unsigned int>, 9> m_freeNodeBlocks; // Index of every free block of nodes, by the number of nodes in the block
+    std::multimap<unsigned int, unsigned int> m_freeChunkSlots; // Offset of every free slot in chunkData, by its size in bytes
+    std::vector<OctreeDirtyRange> m_dirtyNodeRanges;
+    std::vector<OctreeDirtyRange> m_dirtyChunkDataRanges;
+    std::vector<OctreeDirtyRange> m_ropeDirtyNodeRanges; // The node ranges changed since the last updateRopes, kept apart from the upload ranges
+    bool m_isEdited = false;
 };
\ No newline at end of file
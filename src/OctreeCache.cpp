@@ -0,0 +1,182 @@
+#include "OctreeCache.h"
+#include "FileMapping.h"
+#include <fstream>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+
+
+namespace OctreeCache {
+
+    // Every section starts at a multiple of SECTION_ALIGNMENT bytes from the start of the file, and the mapping starts on a page boundary
+    const size_t SECTION_ALIGNMENT = 64;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceHash;
+        uint32_t worldWidth;
+        uint32_t maxDepth;
+        uint32_t isDAG;
+        uint32_t nodeCount;
+        uint64_t nodesOffset;
+        uint64_t chunkDataOffset;
+        uint64_t chunkDataSize;
+        uint64_t paletteOffset;
+    };
+
+    size_t alignSection(size_t offset);
+
+    uint64_t hashFile(const char* filename) {
+        std::ifstream file(filename, std::ios::binary | std::ios::in);
+        if(!file.is_open()) return 0;
+
+        // FNV-1a over 8 bytes at a time, read in blocks so that large worlds are never in memory all at once. The tail is padded with zeros,
+        //  so the size is hashed as well.
+        std::vector<uint8_t> block(1 << 20);
+        uint64_t hash = 14695981039346656037ull;
+        uint64_t fileSize = 0;
+        while(file) {
+            file.read((char*)block.data(), block.size());
+            size_t blockSize = file.gcount();
+            if(blockSize == 0) break;
+            fileSize += blockSize;
+
+            std::memset(block.data() + blockSize, 0, (8 - blockSize % 8) % 8);
+            for(size_t i = 0; i < blockSize; i += 8) {
+                uint64_t word;
+                std::memcpy(&word, block.data() + i, 8);
+                hash = (hash ^ word) * 1099511628211ull;
+            }
+        }
+        return (hash ^ fileSize) * 1099511628211ull;
+    }
+
+    bool saveOctreeCache(const char* filename, const Octree& octree, const float* paletteData, uint64_t sourceHash) {
+        Header header;
+        std::memcpy(header.magic, "VOCT", 4);
+        header.version = VERSION;
+        header.sourceHash = sourceHash;
+        header.worldWidth = octree.worldWidth;
+        header.maxDepth = octree.maxDepth;
+        header.isDAG = octree.isDAG ? 1 : 0;
+        header.nodeCount = octree.nodes.size();
+        header.nodesOffset = alignSection(sizeof(Header));
+        header.chunkDataOffset = alignSection(header.nodesOffset + octree.nodes.size() * sizeof(OctreeNode));
+        header.chunkDataSize = octree.chunkData.size();
+        header.paletteOffset = alignSection(header.chunkDataOffset + header.chunkDataSize);
+
+        std::ofstream file(filename, std::ios::binary | std::ios::out | std::ios::trunc);
+        if(!file.is_open()) {
+            std::cout << "Could not open file " << filename << std::endl;
+            return false;
+        }
+
+        // The header is written last so that a file that was not written completely is never accepted
+        std::vector<char> padding(SECTION_ALIGNMENT, 0);
+        file.write(padding.data(), header.nodesOffset);
+        file.write((const char*)octree.nodes.data(), octree.nodes.size() * sizeof(OctreeNode));
+        file.write(padding.data(), header.chunkDataOffset - (header.nodesOffset + octree.nodes.size() * sizeof(OctreeNode)));
+        file.write((const char*)octree.chunkData.data(), octree.chunkData.size());
+        file.write(padding.data(), header.paletteOffset - (header.chunkDataOffset + header.chunkDataSize));
+        file.write((const char*)paletteData, 256 * 3 * sizeof(float));
+        file.seekp(0, std::ios::beg);
+        file.write((const char*)&header, sizeof(Header));
+
+        if(!file.good()) {
+            std::cout << "ERROR: Could not write octree cache " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    OctreeCacheData loadOctreeCache(const char* filename, uint64_t sourceHash) {
+        OctreeCacheData data = {nullptr, 0, nullptr, 0, nullptr, 0, 0, false, nullptr, 0};
+
+        size_t fileSize;
+        void* mapping = FileMapping::mapFile(filename, fileSize);
+        if(mapping == nullptr) return data;
+
+        Header header;
+        bool valid = fileSize >= sizeof(Header);
+        if(valid) {
+            std::memcpy(&header, mapping, sizeof(Header));
+            valid = std::memcmp(header.magic, "VOCT", 4) == 0 && header.version == VERSION && header.sourceHash == sourceHash;
+        }
+        if(valid) {
+            valid = header.nodesOffset + (uint64_t)header.nodeCount * sizeof(OctreeNode) <= header.chunkDataOffset
+                && header.chunkDataOffset + header.chunkDataSize <= header.paletteOffset
+                && header.paletteOffset + 256 * 3 * sizeof(float) <= fileSize;
+        }
+        if(!valid) {
+            FileMapping::unmapFile(mapping, fileSize);
+            return data;
+        }
+
+        const uint8_t* file = (const uint8_t*)mapping;
+        data.nodes = (const OctreeNode*)(file + header.nodesOffset);
+        data.nodeCount = header.nodeCount;
+        data.chunkData = file + header.chunkDataOffset;
+        data.chunkDataSize = header.chunkDataSize;
+        data.paletteData = (const float*)(file + header.paletteOffset);
+        data.worldWidth = header.worldWidth;
+        data.maxDepth = header.maxDepth;
+        data.isDAG = header.isDAG != 0;
+        data.mapping = mapping;
+        data.mappingSize = fileSize;
+        return data;
+    }
+
+    void unloadOctreeCache(OctreeCacheData& data) {
+        if(data.mapping != nullptr) FileMapping::unmapFile(data.mapping, data.mappingSize);
+        data = {nullptr, 0, nullptr, 0, nullptr, 0, 0, false, nullptr, 0};
+    }
+
+    bool buildOctreeCache(const char* worldFilename, VoxelDataAxis axis, const char* cacheFilename, unsigned int maxDepth, bool convertToDAG, size_t slabMemoryBudget, unsigned int threadCount) {
+        uint64_t sourceHash = hashFile(worldFilename);
+
+        VoxelStream voxelStream = VoxelLoader::openVoxelStream(worldFilename, axis);
+        if(voxelStream.paletteData == nullptr) {
+            return false;
+        }
+        if(voxelStream.sizeX != voxelStream.sizeY || voxelStream.sizeX != voxelStream.sizeZ) {
+            std::cout << "ERROR: world sides must have the same length" << std::endl;
+            delete[] voxelStream.paletteData;
+            return false;
+        }
+
+        // The world is streamed into the octree so that it never has to be in memory all at once
+        bool readFailed = false;
+        VoxelSlabReader readSlab = [&voxelStream, &readFailed](unsigned int startZ, unsigned int depth, uint8_t* destination) {
+            bool succeeded = VoxelLoader::readVoxelSlab(voxelStream, startZ, depth, destination);
+            if(!succeeded) readFailed = true;
+            return succeeded;
+        };
+
+        auto octreeBuildStart = std::chrono::high_resolution_clock::now();
+        Octree octree(readSlab, voxelStream.sizeX, maxDepth, slabMemoryBudget, threadCount);
+        std::chrono::duration<double, std::milli> octreeBuildTime = std::chrono::high_resolution_clock::now() - octreeBuildStart;
+        if(readFailed) {
+            delete[] voxelStream.paletteData;
+            return false;
+        }
+        std::cout << "Octree built in " << octreeBuildTime.count() << " ms" << std::endl;
+
+        // Sharing identical subtrees makes worlds with repeated structures smaller, the shaders traverse both layouts the same way
+        if(convertToDAG) {
+            size_t treeSize = octree.chunkData.size() + octree.nodes.size() * sizeof(OctreeNode);
+            octree.convertToDAG();
+            size_t dagSize = octree.chunkData.size() + octree.nodes.size() * sizeof(OctreeNode);
+            std::cout << "Octree DAG: " << treeSize << " -> " << dagSize << " bytes (" << (double)treeSize / dagSize << "x)" << std::endl;
+        }
+
+        bool saved = saveOctreeCache(cacheFilename, octree, voxelStream.paletteData, sourceHash);
+        delete[] voxelStream.paletteData;
+        return saved;
+    }
+
+    size_t alignSection(size_t offset) {
+        return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include "Octree.h"
+#include "VoxelLoader.h"
+#include <cstdint>
+#include <cstddef>
+
+// An octree that is memory mapped from a cache file. 'nodes' and 'chunkData' point into the mapping and are laid out exactly as they are
+//  uploaded to the shader storage buffers, so they can be passed to ShaderStorageBuffer::setData without being copied.
+struct OctreeCacheData {
+    const OctreeNode* nodes;
+    unsigned int nodeCount;
+    const uint8_t* chunkData;
+    size_t chunkDataSize;
+    const float* paletteData;
+    unsigned int worldWidth, maxDepth;
+    bool isDAG;
+
+    void* mapping;
+    size_t mappingSize;
+};
+
+namespace OctreeCache {
+
+    // Increase when the layout of the file, OctreeNode or the chunk encoding changes so that old cache files are rebuilt
+    const uint32_t VERSION = 1;
+
+    uint64_t hashFile(const char* filename);
+
+    bool saveOctreeCache(const char* filename, const Octree& octree, const float* paletteData, uint64_t sourceHash);
+    // The returned nodes are nullptr if the file could not be mapped, is from another version or was not built from a source with 'sourceHash'
+    OctreeCacheData loadOctreeCache(const char* filename, uint64_t sourceHash);
+    void unloadOctreeCache(OctreeCacheData& data);
+
+    // Streams a world into an octree and saves it together with the palette of the world to a cache file. At most 'slabMemoryBudget' bytes
+    //  of the world are in memory at once (see the streaming Octree constructor).
+    bool buildOctreeCache(const char* worldFilename, VoxelDataAxis axis, const char* cacheFilename, unsigned int maxDepth, bool convertToDAG, size_t slabMemoryBudget, unsigned int threadCount = 0);
+
+}
\ No newline at end of file
@@ -0,0 +1,283 @@
+#include "OctreeRayCaster.h"
+#include <cstring>
+#include <cmath>
+#include <bitset>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+bool isPacketKernelCompiled();
+bool isAVX2SupportedByCPU();
+glm::vec3 getNextVoxel(const glm::vec3& cubeCenterPos, glm::vec3& normal, float& rayLength, const glm::vec3& origin, float cubeWidth, const glm::vec3& direction, const glm::vec3& invDirection);
+
+std::unique_ptr<OctreeRayCaster> OctreeRayCaster::create(const OctreeNode* nodes, const uint8_t* chunkData, unsigned int worldWidth, unsigned int maxDepth) {
+    switch(worldWidth >> maxDepth) {
+        case 1: return std::make_unique<ChunkWidthOctreeRayCaster<1>>(nodes, chunkData, worldWidth, maxDepth);
+        case 2: return std::make_unique<ChunkWidthOctreeRayCaster<2>>(nodes, chunkData, worldWidth, maxDepth);
+        case 4: return std::make_unique<ChunkWidthOctreeRayCaster<4>>(nodes, chunkData, worldWidth, maxDepth);
+        case 8: return std::make_unique<ChunkWidthOctreeRayCaster<8>>(nodes, chunkData, worldWidth, maxDepth);
+        case 16: return std::make_unique<ChunkWidthOctreeRayCaster<16>>(nodes, chunkData, worldWidth, maxDepth);
+        case 32: return std::make_unique<ChunkWidthOctreeRayCaster<32>>(nodes, chunkData, worldWidth, maxDepth);
+        case 64: return std::make_unique<ChunkWidthOctreeRayCaster<64>>(nodes, chunkData, worldWidth, maxDepth);
+        case 128: return std::make_unique<ChunkWidthOctreeRayCaster<128>>(nodes, chunkData, worldWidth, maxDepth);
+        case 256: return std::make_unique<ChunkWidthOctreeRayCaster<256>>(nodes, chunkData, worldWidth, maxDepth);
+        default: return nullptr;
+    }
+}
+
+std::unique_ptr<OctreeRayCaster> OctreeRayCaster::create(const Octree& octree) {
+    return create(octree.nodes.data(), octree.chunkData.data(), octree.worldWidth, octree.maxDepth);
+}
+
+bool OctreeRayCaster::isPacketTracingVectorized() {
+    static const bool vectorized = isPacketKernelCompiled() && isAVX2SupportedByCPU();
+    return vectorized;
+}
+
+template<unsigned int ChunkWidth>
+ChunkWidthOctreeRayCaster<ChunkWidth>::ChunkWidthOctreeRayCaster(const OctreeNode* nodes, const uint8_t* chunkData, unsigned int worldWidth, unsigned int maxDepth)
+    : m_nodes(nodes), m_chunkData(chunkData), m_worldWidth(worldWidth), m_maxDepth(maxDepth) {
+
+}
+
+template<unsigned int ChunkWidth>
+OctreeRayHit ChunkWidthOctreeRayCaster<ChunkWidth>::castRay(const glm::vec3& origin, const glm::vec3& direction, float startDistance, unsigned int maxIterations, float maxDistance) const {
+    glm::vec3 voxelPos = glm::floor(origin + direction * startDistance) + glm::vec3(0.5f, 0.5f, 0.5f); // voxelPos is always in the center of a voxel
+    glm::vec3 normal = glm::vec3(1.0f, 0.0f, 0.0f);
+    float rayLength = startDistance;
+
+    glm::vec3 invDirection = 1.0f / direction;
+    float hWorldWidth = m_worldWidth / 2.0f;
+
+    for(unsigned int iteration = 0; iteration < maxIterations && rayLength < maxDistance; ++iteration) {
+        if(voxelPos.x <= -hWorldWidth || voxelPos.x >= hWorldWidth || voxelPos.y <= -hWorldWidth || voxelPos.y >= hWorldWidth || voxelPos.z <= -hWorldWidth || voxelPos.z >= hWorldWidth) {
+            break;
+        }
+
+        unsigned int currentDepth = 0;
+        glm::vec3 localOctreeNodeVoxelPos = voxelPos;
+        uint32_t leafData = getOctreeNode(currentDepth, localOctreeNodeVoxelPos);
+
+        uint32_t paletteIndex = 0;
+        if((leafData & OctreeNode::CHUNK_FLAG) != 0) {
+            // localOctreeNodeVoxelPos is in the range [-width/2, width/2], we want to transform it into the range [0, width]
+            glm::vec3 localVoxelPos = glm::floor(localOctreeNodeVoxelPos + glm::vec3(ChunkWidth * 0.5f)) + glm::vec3(0.5f);
+            paletteIndex = getVoxelData(leafData & ~OctreeNode::CHUNK_FLAG, localVoxelPos, normal, rayLength, origin + (localVoxelPos - voxelPos), direction, invDirection);
+        }
+        else {
+            paletteIndex = leafData;
+        }
+
+        if(paletteIndex != 0) {
+            if(rayLength > maxDistance) break;
+            return OctreeRayHit{ true, (uint8_t)paletteIndex, rayLength, origin + rayLength * direction, normal };
+        }
+
+        float width = (float)(m_worldWidth >> currentDepth);
+        glm::vec3 octreeNodePos = glm::floor(voxelPos / width) * width + glm::vec3(width * 0.5f); // position of the center of the current octreeNode
+
+        voxelPos = getNextVoxel(octreeNodePos, normal, rayLength, origin, width, direction, invDirection);
+    }
+
+    return OctreeRayHit{ false, 0, -1.0f, glm::vec3(0.0f), glm::vec3(0.0f) };
+}
+
+template<unsigned int ChunkWidth>
+void ChunkWidthOctreeRayCaster<ChunkWidth>::castRayPacket(const OctreeRayPacket& packet, unsigned int maxIterations, OctreeRayHit* hits) const {
+    if(OctreeRayCaster::isPacketTracingVectorized()) {
+        castRayPacketAVX2(packet, maxIterations, hits);
+        return;
+    }
+
+    for(unsigned int i = 0; i < RAY_PACKET_SIZE; ++i) {
+        glm::vec3 origin(packet.originX[i], packet.originY[i], packet.originZ[i]);
+        glm::vec3 direction(packet.directionX[i], packet.directionY[i], packet.directionZ[i]);
+        hits[i] = castRay(origin, direction, packet.startDistance[i], maxIterations, packet.maxDistance[i]);
+    }
+}
+
+template<unsigned int ChunkWidth>
+float ChunkWidthOctreeRayCaster<ChunkWidth>::getRayLength(const glm::vec3& origin, const glm::vec3& direction, unsigned int maxIterations, float maxDistance) const {
+    glm::vec3 voxelPos = glm::floor(origin) + glm::vec3(0.5f, 0.5f, 0.5f); // voxelPos is always in the center of a voxel
+    glm::vec3 normal = glm::vec3(1.0f, 0.0f, 0.0f);
+    float rayLength = 0.0f;
+
+    glm::vec3 invDirection = 1.0f / direction;
+    float hWorldWidth = m_worldWidth / 2.0f;
+
+    for(unsigned int iterations = 0; iterations < maxIterations && rayLength < maxDistance; ++iterations) {
+        if(voxelPos.x <= -hWorldWidth || voxelPos.x >= hWorldWidth || voxelPos.y <= -hWorldWidth || voxelPos.y >= hWorldWidth || voxelPos.z <= -hWorldWidth || voxelPos.z >= hWorldWidth) {
+            break;
+        }
+
+        unsigned int currentDepth = 0;
+        glm::vec3 localOctreeNodeVoxelPos = voxelPos;
+        uint32_t leafData = getOctreeNode(currentDepth, localOctreeNodeVoxelPos);
+
+        if((leafData & OctreeNode::CHUNK_FLAG) != 0) {
+            glm::vec3 localVoxelPos = glm::floor(localOctreeNodeVoxelPos + glm::vec3(ChunkWidth * 0.5f)) + glm::vec3(0.5f);
+            rayLength = getRayLengthInChunk(leafData & ~OctreeNode::CHUNK_FLAG, localVoxelPos, origin + (localVoxelPos - voxelPos), direction, invDirection);
+            if(rayLength >= 0.0f) {
+                return rayLength;
+            }
+        }
+        else if(leafData != 0) {
+            return rayLength;
+        }
+
+        float width = (float)(m_worldWidth >> currentDepth);
+        glm::vec3 octreeNodePos = glm::floor(voxelPos / width) * width + glm::vec3(width * 0.5f);
+
+        voxelPos = getNextVoxel(octreeNodePos, normal, rayLength, origin, width, direction, invDirection);
+    }
+
+    return maxDistance;
+}
+
+// The chunks are read a word at a time like the shaders read the chunkData SSBO, but chunkData is a byte array that is not known to be aligned
+template<unsigned int ChunkWidth>
+uint32_t ChunkWidthOctreeRayCaster<ChunkWidth>::getChunkWord(uint32_t wordIndex) const {
+    uint32_t word;
+    std::memcpy(&word, m_chunkData + (size_t)wordIndex * 4, 4);
+    return word;
+}
+
+// Finds the leaf containing 'pos', starting from the root, and returns its data (zero if the leaf is empty). 'depth' must be zero, the depth
+//  of the leaf is returned in it, and 'pos' is moved into the space of the leaf like getOctreeNode in octreeTraversal.glsl does.
+template<unsigned int ChunkWidth>
+uint32_t ChunkWidthOctreeRayCaster<ChunkWidth>::getOctreeNode(unsigned int& depth, glm::vec3& pos) const {
+    OctreeNode node = m_nodes[0];
+    while(node.childMasks != 0) {
+        int childIndex = ((pos.x >= 0) ? 1 : 0) + ((pos.y >= 0) ? 1 : 0) * 2 + ((pos.z >= 0) ? 1 : 0) * 4;
+
+        float qWidth = (float)(m_worldWidth >> 2) / (float)(1u << depth);
+        pos.x += qWidth * ((pos.x >= 0) ? -1.0f : 1.0f);
+        pos.y += qWidth * ((pos.y >= 0) ? -1.0f : 1.0f);
+        pos.z += qWidth * ((pos.z >= 0) ? -1.0f : 1.0f);
+
+        depth++;
+        uint32_t childBit = 1u << childIndex;
+        if((node.childMasks & childBit) == 0) return 0;
+
+        // The children are packed, so the child index is the number of non empty children before it
+        node = m_nodes[node.data + std::bitset<8>(node.childMasks & (childBit - 1)).count()];
+    }
+    return node.data;
+}
+
+template<unsigned int ChunkWidth>
+bool ChunkWidthOctreeRayCaster<ChunkWidth>::isSubBlockOccupied(uint32_t chunkDataIndex, int subBlockX, int subBlockY, int subBlockZ) const {
+    uint32_t subBlockID = subBlockX + (subBlockY + subBlockZ * SUB_BLOCKS_PER_ROW) * SUB_BLOCKS_PER_ROW;
+    return (getChunkWord((chunkDataIndex >> 2) + 1 + (subBlockID >> 5)) & (1u << (subBlockID & 31))) != 0;
+}
+
+template<unsigned int ChunkWidth>
+uint32_t ChunkWidthOctreeRayCaster<ChunkWidth>::getVoxelByte(uint32_t chunkDataIndex, int x, int y, int z) const {
+    uint32_t localVoxelID = x + y * ChunkWidth + z * ChunkWidth * ChunkWidth;
+
+    uint32_t chunkWordIndex = chunkDataIndex >> 2;
+    uint32_t header = getChunkWord(chunkWordIndex);
+    uint32_t bitsPerIndex = header & 0xFF;
+    uint32_t paletteSize = header >> 8;
+
+    uint32_t bitIndex = localVoxelID * bitsPerIndex;
+    uint32_t paletteWordIndex = chunkWordIndex + 1 + OCCUPANCY_WORDS;
+    uint32_t indicesWordIndex = paletteWordIndex + ((paletteSize + 3) >> 2);
+    uint32_t index = (getChunkWord(indicesWordIndex + (bitIndex >> 5)) >> (bitIndex & 31)) & ((1u << bitsPerIndex) - 1);
+    if(paletteSize == 0) return index;
+
+    return m_chunkData[paletteWordIndex * 4 + index];
+}
+
+// Raymarches through a chunk and returns the palette index of the first voxel hit, or zero if no voxels were hit, like getVoxelData in
+//  octreeTraversal.glsl
+template<unsigned int ChunkWidth>
+uint32_t ChunkWidthOctreeRayCaster<ChunkWidth>::getVoxelData(uint32_t chunkDataIndex, glm::vec3& localVoxelPos, glm::vec3& normal, float& rayLength, const glm::vec3& localOrigin, const glm::vec3& direction, const glm::vec3& invDirection) const {
+    const float width = (float)ChunkWidth;
+    const int subBlockWidth = (int)Octree::SUB_BLOCK_WIDTH;
+
+    // A ray can not visit more than 3 * ChunkWidth voxels before leaving the chunk
+    for(unsigned int iteration = 0; iteration < 3 * ChunkWidth; ++iteration) {
+        if(localVoxelPos.x < 0.0f || localVoxelPos.x >= width || localVoxelPos.y < 0.0f || localVoxelPos.y >= width || localVoxelPos.z < 0.0f || localVoxelPos.z >= width) {
+            break;
+        }
+
+        int x = (int)std::floor(localVoxelPos.x), y = (int)std::floor(localVoxelPos.y), z = (int)std::floor(localVoxelPos.z);
+        int subBlockX = x / subBlockWidth, subBlockY = y / subBlockWidth, subBlockZ = z / subBlockWidth;
+        if(!isSubBlockOccupied(chunkDataIndex, subBlockX, subBlockY, subBlockZ)) {
+            glm::vec3 subBlockPos = glm::vec3((float)(subBlockX * subBlockWidth), (float)(subBlockY * subBlockWidth), (float)(subBlockZ * subBlockWidth)) + glm::vec3(subBlockWidth * 0.5f);
+            localVoxelPos = getNextVoxel(subBlockPos, normal, rayLength, localOrigin, (float)subBlockWidth, direction, invDirection);
+            continue;
+        }
+
+        uint32_t voxelByte = getVoxelByte(chunkDataIndex, x, y, z);
+        if(voxelByte != 0) {
+            return voxelByte;
+        }
+
+        localVoxelPos = getNextVoxel(localVoxelPos, normal, rayLength, localOrigin, 1.0f, direction, invDirection);
+    }
+
+    return 0;
+}
+
+// Like getRayLengthInChunk in lightingShader.glsl, which measures the length from zero when the ray enters the chunk
+template<unsigned int ChunkWidth>
+float ChunkWidthOctreeRayCaster<ChunkWidth>::getRayLengthInChunk(uint32_t chunkDataIndex, glm::vec3 localVoxelPos, const glm::vec3& localOrigin, const glm::vec3& direction, const glm::vec3& invDirection) const {
+    glm::vec3 normal;
+    float rayLength = 0.0f;
+    if(getVoxelData(chunkDataIndex, localVoxelPos, normal, rayLength, localOrigin, direction, invDirection) != 0) {
+        return rayLength;
+    }
+    return -1.0f;
+}
+
+template class ChunkWidthOctreeRayCaster<1>;
+template class ChunkWidthOctreeRayCaster<2>;
+template class ChunkWidthOctreeRayCaster<4>;
+template class ChunkWidthOctreeRayCaster<8>;
+template class ChunkWidthOctreeRayCaster<16>;
+template class ChunkWidthOctreeRayCaster<32>;
+template class ChunkWidthOctreeRayCaster<64>;
+template class ChunkWidthOctreeRayCaster<128>;
+template class ChunkWidthOctreeRayCaster<256>;
+
+bool isAVX2SupportedByCPU() {
+#if defined(_MSC_VER)
+    // AVX2 also needs the operating system to save the upper halves of the registers
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesRegisters = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesRegisters && (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+// Calculates the center of the next voxel and the normal by traversing a ray starting on 'origin' with direction 'direction'.
+glm::vec3 getNextVoxel(const glm::vec3& cubeCenterPos, glm::vec3& normal, float& rayLength, const glm::vec3& origin, float cubeWidth, const glm::vec3& direction, const glm::vec3& invDirection) {
+    // origin + direction * dRay = cubeCenterPos +- width/2 <=> dRay = (cubeCenterPos +- width/2 - origin) / direction
+    glm::vec3 dPos = cubeCenterPos + glm::vec3(((direction.x >= 0) ? cubeWidth : -cubeWidth), ((direction.y >= 0) ? cubeWidth : -cubeWidth), ((direction.z >= 0) ? cubeWidth : -cubeWidth)) * 0.5f - origin;
+    glm::vec3 dRay = dPos * invDirection;
+
+    if(dRay.x < dRay.y && dRay.x < dRay.z) {
+        normal = glm::vec3(-glm::sign(direction.x), 0.0f, 0.0f);
+        rayLength = dRay.x;
+    }
+    else if(dRay.y < dRay.z) {
+        normal = glm::vec3(0.0f, -glm::sign(direction.y), 0.0f);
+        rayLength = dRay.y;
+    }
+    else {
+        normal = glm::vec3(0.0f, 0.0f, -glm::sign(direction.z));
+        rayLength = dRay.z;
+    }
+    glm::vec3 nextCubeCenterPos = origin + rayLength * direction - normal * 0.5f;
+
+    return glm::floor(nextCubeCenterPos) + glm::vec3(0.5f, 0.5f, 0.5f);
+}
\ No newline at end of file
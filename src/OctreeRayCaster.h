@@ -0,0 +1,81 @@
+#pragma once
+#include "Octree.h"
+#include <glm/glm.hpp>
+#include <memory>
+#include <cstdint>
+
+struct OctreeRayHit {
+    bool hit;
+    uint8_t paletteIndex;
+    float distance; // Distance along the ray from its origin to the hit, or -1 if nothing was hit
+    glm::vec3 pos;
+    glm::vec3 normal;
+};
+
+// Number of rays that castRayPacket traces together, one per lane of an AVX2 register
+const unsigned int RAY_PACKET_SIZE = 8;
+
+// Rays stored one component per array, so that the components of every ray in the packet can be loaded into one register
+struct OctreeRayPacket {
+    float originX[RAY_PACKET_SIZE], originY[RAY_PACKET_SIZE], originZ[RAY_PACKET_SIZE];
+    float directionX[RAY_PACKET_SIZE], directionY[RAY_PACKET_SIZE], directionZ[RAY_PACKET_SIZE];
+    float startDistance[RAY_PACKET_SIZE];
+    float maxDistance[RAY_PACKET_SIZE];
+};
+
+// Traces rays through an octree on the CPU the same way the shaders do. castRay does what getGBufferData in octreeTraversal.glsl does and
+//  getRayLength what the function of the same name in lightingShader.glsl does, with the same float operations in the same order, so the
+//  results are the same as the shaders'. The nodes and chunks are read where they are, they have to stay alive and unchanged while the ray
+//  caster is used. DAGs can be traced as well.
+class OctreeRayCaster {
+public:
+    virtual ~OctreeRayCaster() {}
+
+    // Returns the first voxel hit by the ray. The march starts 'startDistance' along the ray, which must be known to be empty up to there, and
+    //  stops after 'maxIterations' steps or once it is 'maxDistance' along the ray. Hits further away than 'maxDistance' are misses, with a
+    //  'maxDistance' of infinity the hits are the same as those of getGBufferData.
+    virtual OctreeRayHit castRay(const glm::vec3& origin, const glm::vec3& direction, float startDistance, unsigned int maxIterations, float maxDistance) const = 0;
+    // Traces the RAY_PACKET_SIZE rays of 'packet' and writes their hits to 'hits'. The hits are the same as those of castRay.
+    virtual void castRayPacket(const OctreeRayPacket& packet, unsigned int maxIterations, OctreeRayHit* hits) const = 0;
+    // Returns the distance from 'origin' to the first voxel along the ray, or 'maxDistance' if there was none within 'maxIterations' steps.
+    virtual float getRayLength(const glm::vec3& origin, const glm::vec3& direction, unsigned int maxIterations, float maxDistance) const = 0;
+
+    // Returns a ray caster that is specialized for the chunk width of the octree, or nullptr if there is none for it
+    static std::unique_ptr<OctreeRayCaster> create(const OctreeNode* nodes, const uint8_t* chunkData, unsigned int worldWidth, unsigned int maxDepth);
+    static std::unique_ptr<OctreeRayCaster> create(const Octree& octree);
+
+    // Returns true if castRayPacket traces the rays of a packet together with AVX2 instructions, and false if it traces them one at a time
+    //  because the ray caster was built without AVX2 or the CPU does not support it
+    static bool isPacketTracingVectorized();
+};
+
+// The width of the chunks is known at compile time, so that the sizes and offsets in a chunk are constants. Instances exist for the chunk
+//  widths from 1 to 256.
+template<unsigned int ChunkWidth>
+class ChunkWidthOctreeRayCaster : public OctreeRayCaster {
+public:
+    ChunkWidthOctreeRayCaster(const OctreeNode* nodes, const uint8_t* chunkData, unsigned int worldWidth, unsigned int maxDepth);
+
+    OctreeRayHit castRay(const glm::vec3& origin, const glm::vec3& direction, float startDistance, unsigned int maxIterations, float maxDistance) const override;
+    void castRayPacket(const OctreeRayPacket& packet, unsigned int maxIterations, OctreeRayHit* hits) const override;
+    float getRayLength(const glm::vec3& origin, const glm::vec3& direction, unsigned int maxIterations, float maxDistance) const override;
+
+private:
+    static const unsigned int SUB_BLOCKS_PER_ROW = (ChunkWidth + Octree::SUB_BLOCK_WIDTH - 1) / Octree::SUB_BLOCK_WIDTH;
+    static const unsigned int OCCUPANCY_WORDS = (SUB_BLOCKS_PER_ROW * SUB_BLOCKS_PER_ROW * SUB_BLOCKS_PER_ROW + 31) / 32;
+
+    // Defined in OctreeRayCasterAVX2.cpp, which is the only file compiled with AVX2 enabled
+    void castRayPacketAVX2(const OctreeRayPacket& packet, unsigned int maxIterations, OctreeRayHit* hits) const;
+
+    uint32_t getChunkWord(uint32_t wordIndex) const;
+    uint32_t getOctreeNode(unsigned int& depth, glm::vec3& pos) const;
+    bool isSubBlockOccupied(uint32_t chunkDataIndex, int subBlockX, int subBlockY, int subBlockZ) const;
+    uint32_t getVoxelByte(uint32_t chunkDataIndex, int x, int y, int z) const;
+    uint32_t getVoxelData(uint32_t chunkDataIndex, glm::vec3& localVoxelPos, glm::vec3& normal, float& rayLength, const glm::vec3& localOrigin, const glm::vec3& direction, const glm::vec3& invDirection) const;
+    float getRayLengthInChunk(uint32_t chunkDataIndex, glm::vec3 localVoxelPos, const glm::vec3& localOrigin, const glm::vec3& direction, const glm::vec3& invDirection) const;
+
+    const OctreeNode* m_nodes;
+    const uint8_t* m_chunkData;
+    unsigned int m_worldWidth;
+    unsigned int m_maxDepth;
+};
@@ -0,0 +1,283 @@
+#include "OctreeRayCaster.h"
+
+// The packet kernel of ChunkWidthOctreeRayCaster. This is the only file that is compiled with AVX2 enabled, so that the rest of the program
+//  still runs on CPUs without it, and castRayPacket only calls into it after checking that the CPU supports AVX2.
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+static_assert(Octree::SUB_BLOCK_WIDTH == 4, "The packet kernel finds the sub-block of a voxel with a shift by two");
+
+bool isPacketKernelCompiled();
+bool anyLane(__m256 mask);
+__m256 selectLanes(__m256 mask, __m256 ifSet, __m256 ifNotSet);
+__m256i selectLanes(__m256 mask, __m256i ifSet, __m256i ifNotSet);
+__m256i gatherWords(const void* base, __m256i wordIndices, __m256 mask);
+__m256i countLowByteBits(__m256i value);
+void getNextVoxelAVX2(__m256 cubeCenterPos[3], __m256 normal[3], __m256& rayLength, const __m256 origin[3], __m256 cubeWidth, const __m256 direction[3], const __m256 invDirection[3], __m256 lanes);
+
+bool isPacketKernelCompiled() {
+    return true;
+}
+
+// Does the same as castRay for eight rays in lockstep. Every lane takes the steps castRay takes for its ray, with the same float operations,
+//  and lanes whose ray has hit something or left the world are masked off until the whole packet is done. Nodes, occupancy masks and voxel
+//  indices are fetched for all lanes at once with gathers.
+template<unsigned int ChunkWidth>
+void ChunkWidthOctreeRayCaster<ChunkWidth>::castRayPacketAVX2(const OctreeRayPacket& packet, unsigned int maxIterations, OctreeRayHit* hits) const {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i intOne = _mm256_set1_epi32(1);
+
+    __m256 origin[3] = { _mm256_loadu_ps(packet.originX), _mm256_loadu_ps(packet.originY), _mm256_loadu_ps(packet.originZ) };
+    __m256 direction[3] = { _mm256_loadu_ps(packet.directionX), _mm256_loadu_ps(packet.directionY), _mm256_loadu_ps(packet.directionZ) };
+    __m256 rayLength = _mm256_loadu_ps(packet.startDistance);
+    const __m256 maxDistance = _mm256_loadu_ps(packet.maxDistance);
+
+    __m256 invDirection[3], voxelPos[3];
+    for(int axis = 0; axis < 3; ++axis) {
+        invDirection[axis] = _mm256_div_ps(one, direction[axis]);
+        voxelPos[axis] = _mm256_add_ps(_mm256_floor_ps(_mm256_add_ps(origin[axis], _mm256_mul_ps(direction[axis], rayLength))), half);
+    }
+    __m256 normal[3] = { one, zero, zero };
+    const __m256 hWorldWidth = _mm256_set1_ps(m_worldWidth / 2.0f);
+    const __m256 negativeHWorldWidth = _mm256_set1_ps(-(m_worldWidth / 2.0f));
+
+    __m256i hitPaletteIndex = _mm256_setzero_si256();
+    __m256 hitRayLength = zero;
+    __m256 hitNormal[3] = { zero, zero, zero };
+
+    __m256 active = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for(unsigned int iteration = 0; iteration < maxIterations; ++iteration) {
+        active = _mm256_and_ps(active, _mm256_cmp_ps(rayLength, maxDistance, _CMP_LT_OQ));
+        for(int axis = 0; axis < 3; ++axis) {
+            __m256 outside = _mm256_or_ps(_mm256_cmp_ps(voxelPos[axis], negativeHWorldWidth, _CMP_LE_OQ), _mm256_cmp_ps(voxelPos[axis], hWorldWidth, _CMP_GE_OQ));
+            active = _mm256_andnot_ps(outside, active);
+        }
+        if(!anyLane(active)) break;
+
+        // Descend from the root, one level per step for every lane that has not reached its leaf
+        __m256i nodeIndex = _mm256_setzero_si256();
+        __m256i depth = _mm256_setzero_si256();
+        __m256i leafData = _mm256_setzero_si256();
+        __m256 localPos[3] = { voxelPos[0], voxelPos[1], voxelPos[2] };
+        __m256 descending = active;
+        for(unsigned int level = 0; anyLane(descending); ++level) {
+            __m256i nodeWordIndex = _mm256_slli_epi32(nodeIndex, 1);
+            __m256i childMasks = gatherWords(m_nodes, nodeWordIndex, descending);
+            __m256i data = gatherWords(m_nodes, _mm256_add_epi32(nodeWordIndex, intOne), descending);
+
+            __m256 isLeaf = _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(childMasks, _mm256_setzero_si256())), descending);
+            leafData = selectLanes(isLeaf, data, leafData);
+            descending = _mm256_andnot_ps(isLeaf, descending);
+            if(!anyLane(descending)) break;
+
+            __m256 qWidth = _mm256_set1_ps((float)(m_worldWidth >> 2) / (float)(1u << level));
+            __m256i childIndex = _mm256_setzero_si256();
+            for(int axis = 0; axis < 3; ++axis) {
+                __m256 positive = _mm256_cmp_ps(localPos[axis], zero, _CMP_GE_OQ);
+                childIndex = _mm256_or_si256(childIndex, _mm256_and_si256(_mm256_castps_si256(positive), _mm256_set1_epi32(1 << axis)));
+                __m256 moved = _mm256_add_ps(localPos[axis], _mm256_mul_ps(qWidth, selectLanes(positive, _mm256_set1_ps(-1.0f), one)));
+                localPos[axis] = selectLanes(descending, moved, localPos[axis]);
+            }
+            depth = _mm256_add_epi32(depth, _mm256_and_si256(_mm256_castps_si256(descending), intOne));
+
+            __m256i childBit = _mm256_sllv_epi32(intOne, childIndex);
+            __m256 isEmpty = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(childMasks, childBit), _mm256_setzero_si256()));
+            descending = _mm256_andnot_ps(isEmpty, descending);
+
+            // The children are packed, so the child index is the number of non empty children before it
+            __m256i packedIndex = countLowByteBits(_mm256_and_si256(childMasks, _mm256_sub_epi32(childBit, intOne)));
+            nodeIndex = selectLanes(descending, _mm256_add_epi32(data, packedIndex), nodeIndex);
+        }
+
+        __m256 isChunk = _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_setzero_si256(), leafData)), active);
+        __m256 isSolid = _mm256_andnot_ps(isChunk, _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(leafData, _mm256_setzero_si256())), active));
+        hitPaletteIndex = selectLanes(isSolid, leafData, hitPaletteIndex);
+        hitRayLength = selectLanes(isSolid, rayLength, hitRayLength);
+        for(int axis = 0; axis < 3; ++axis) hitNormal[axis] = selectLanes(isSolid, normal[axis], hitNormal[axis]);
+        active = _mm256_andnot_ps(isSolid, active);
+
+        if(anyLane(isChunk)) {
+            const __m256 chunkWidth = _mm256_set1_ps((float)ChunkWidth);
+            __m256i chunkWordIndex = _mm256_srli_epi32(_mm256_and_si256(leafData, _mm256_set1_epi32(~OctreeNode::CHUNK_FLAG)), 2);
+            __m256 localVoxelPos[3], localOrigin[3];
+            for(int axis = 0; axis < 3; ++axis) {
+                localVoxelPos[axis] = _mm256_add_ps(_mm256_floor_ps(_mm256_add_ps(localPos[axis], _mm256_set1_ps(ChunkWidth * 0.5f))), half);
+                localOrigin[axis] = _mm256_add_ps(origin[axis], _mm256_sub_ps(localVoxelPos[axis], voxelPos[axis]));
+            }
+
+            __m256 inChunk = isChunk;
+            for(unsigned int chunkIteration = 0; chunkIteration < 3 * ChunkWidth; ++chunkIteration) {
+                for(int axis = 0; axis < 3; ++axis) {
+                    __m256 outside = _mm256_or_ps(_mm256_cmp_ps(localVoxelPos[axis], zero, _CMP_LT_OQ), _mm256_cmp_ps(localVoxelPos[axis], chunkWidth, _CMP_GE_OQ));
+                    inChunk = _mm256_andnot_ps(outside, inChunk);
+                }
+                if(!anyLane(inChunk)) break;
+
+                __m256i iLocalPos[3], iSubBlockPos[3];
+                for(int axis = 0; axis < 3; ++axis) {
+                    iLocalPos[axis] = _mm256_cvttps_epi32(_mm256_floor_ps(localVoxelPos[axis]));
+                    iSubBlockPos[axis] = _mm256_srli_epi32(iLocalPos[axis], 2);
+                }
+                const __m256i subBlocksPerRow = _mm256_set1_epi32(SUB_BLOCKS_PER_ROW);
+                __m256i subBlockID = _mm256_add_epi32(iSubBlockPos[0], _mm256_mullo_epi32(_mm256_add_epi32(iSubBlockPos[1], _mm256_mullo_epi32(iSubBlockPos[2], subBlocksPerRow)), subBlocksPerRow));
+                __m256i occupancyWord = gatherWords(m_chunkData, _mm256_add_epi32(_mm256_add_epi32(chunkWordIndex, intOne), _mm256_srli_epi32(subBlockID, 5)), inChunk);
+                __m256i occupancyBit = _mm256_and_si256(_mm256_srlv_epi32(occupancyWord, _mm256_and_si256(subBlockID, _mm256_set1_epi32(31))), intOne);
+                __m256 occupied = _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(occupancyBit, intOne)), inChunk);
+
+                if(anyLane(occupied)) {
+                    __m256i header = gatherWords(m_chunkData, chunkWordIndex, occupied);
+                    __m256i bitsPerIndex = _mm256_and_si256(header, _mm256_set1_epi32(0xFF));
+                    __m256i paletteSize = _mm256_srli_epi32(header, 8);
+
+                    __m256i localVoxelID = _mm256_add_epi32(iLocalPos[0], _mm256_add_epi32(_mm256_mullo_epi32(iLocalPos[1], _mm256_set1_epi32(ChunkWidth)), _mm256_mullo_epi32(iLocalPos[2], _mm256_set1_epi32(ChunkWidth * ChunkWidth))));
+                    __m256i bitIndex = _mm256_mullo_epi32(localVoxelID, bitsPerIndex);
+                    __m256i paletteWordIndex = _mm256_add_epi32(chunkWordIndex, _mm256_set1_epi32(1 + OCCUPANCY_WORDS));
+                    __m256i indicesWordIndex = _mm256_add_epi32(paletteWordIndex, _mm256_srli_epi32(_mm256_add_epi32(paletteSize, _mm256_set1_epi32(3)), 2));
+                    __m256i indexWord = gatherWords(m_chunkData, _mm256_add_epi32(indicesWordIndex, _mm256_srli_epi32(bitIndex, 5)), occupied);
+                    __m256i index = _mm256_and_si256(_mm256_srlv_epi32(indexWord, _mm256_and_si256(bitIndex, _mm256_set1_epi32(31))), _mm256_sub_epi32(_mm256_sllv_epi32(intOne, bitsPerIndex), intOne));
+
+                    __m256 hasPalette = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(paletteSize, _mm256_setzero_si256())), occupied);
+                    __m256i paletteWord = gatherWords(m_chunkData, _mm256_add_epi32(paletteWordIndex, _mm256_srli_epi32(index, 2)), hasPalette);
+                    __m256i paletteByte = _mm256_and_si256(_mm256_srlv_epi32(paletteWord, _mm256_slli_epi32(_mm256_and_si256(index, _mm256_set1_epi32(3)), 3)), _mm256_set1_epi32(0xFF));
+                    __m256i voxelByte = selectLanes(hasPalette, paletteByte, index);
+
+                    __m256 isHit = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(voxelByte, _mm256_setzero_si256())), occupied);
+                    hitPaletteIndex = selectLanes(isHit, voxelByte, hitPaletteIndex);
+                    hitRayLength = selectLanes(isHit, rayLength, hitRayLength);
+                    for(int axis = 0; axis < 3; ++axis) hitNormal[axis] = selectLanes(isHit, normal[axis], hitNormal[axis]);
+                    active = _mm256_andnot_ps(isHit, active);
+                    inChunk = _mm256_andnot_ps(isHit, inChunk);
+                }
+
+                // Empty sub-blocks are crossed in one step, the other lanes step to the next voxel
+                __m256 isEmptySubBlock = _mm256_andnot_ps(occupied, inChunk);
+                __m256 cubeCenterPos[3];
+                for(int axis = 0; axis < 3; ++axis) {
+                    __m256 subBlockPos = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_slli_epi32(iSubBlockPos[axis], 2)), _mm256_set1_ps(2.0f));
+                    cubeCenterPos[axis] = selectLanes(isEmptySubBlock, subBlockPos, localVoxelPos[axis]);
+                }
+                __m256 cubeWidth = selectLanes(isEmptySubBlock, _mm256_set1_ps(4.0f), one);
+                getNextVoxelAVX2(cubeCenterPos, normal, rayLength, localOrigin, cubeWidth, direction, invDirection, inChunk);
+                for(int axis = 0; axis < 3; ++axis) localVoxelPos[axis] = selectLanes(inChunk, cubeCenterPos[axis], localVoxelPos[axis]);
+            }
+            if(!anyLane(active)) break;
+        }
+
+        // Step to the next node along the ray
+        __m256 width = _mm256_cvtepi32_ps(_mm256_srlv_epi32(_mm256_set1_epi32(m_worldWidth), depth));
+        __m256 octreeNodePos[3];
+        for(int axis = 0; axis < 3; ++axis) {
+            octreeNodePos[axis] = _mm256_add_ps(_mm256_mul_ps(_mm256_floor_ps(_mm256_div_ps(voxelPos[axis], width)), width), _mm256_mul_ps(width, half));
+        }
+        getNextVoxelAVX2(octreeNodePos, normal, rayLength, origin, width, direction, invDirection, active);
+        for(int axis = 0; axis < 3; ++axis) voxelPos[axis] = selectLanes(active, octreeNodePos[axis], voxelPos[axis]);
+    }
+
+    alignas(32) uint32_t paletteIndices[RAY_PACKET_SIZE];
+    alignas(32) float rayLengths[RAY_PACKET_SIZE], normalX[RAY_PACKET_SIZE], normalY[RAY_PACKET_SIZE], normalZ[RAY_PACKET_SIZE];
+    _mm256_store_si256((__m256i*)paletteIndices, hitPaletteIndex);
+    _mm256_store_ps(rayLengths, hitRayLength);
+    _mm256_store_ps(normalX, hitNormal[0]);
+    _mm256_store_ps(normalY, hitNormal[1]);
+    _mm256_store_ps(normalZ, hitNormal[2]);
+    for(unsigned int i = 0; i < RAY_PACKET_SIZE; ++i) {
+        if(paletteIndices[i] == 0 || rayLengths[i] > packet.maxDistance[i]) {
+            hits[i] = OctreeRayHit{ false, 0, -1.0f, glm::vec3(0.0f), glm::vec3(0.0f) };
+            continue;
+        }
+        glm::vec3 origin(packet.originX[i], packet.originY[i], packet.originZ[i]);
+        glm::vec3 direction(packet.directionX[i], packet.directionY[i], packet.directionZ[i]);
+        hits[i] = OctreeRayHit{ true, (uint8_t)paletteIndices[i], rayLengths[i], origin + rayLengths[i] * direction, glm::vec3(normalX[i], normalY[i], normalZ[i]) };
+    }
+}
+
+bool anyLane(__m256 mask) {
+    return _mm256_movemask_ps(mask) != 0;
+}
+
+__m256 selectLanes(__m256 mask, __m256 ifSet, __m256 ifNotSet) {
+    return _mm256_blendv_ps(ifNotSet, ifSet, mask);
+}
+
+__m256i selectLanes(__m256 mask, __m256i ifSet, __m256i ifNotSet) {
+    return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(ifNotSet), _mm256_castsi256_ps(ifSet), mask));
+}
+
+// Loads the 32-bit words at 'wordIndices' from 'base' in the lanes of 'mask', the other lanes are zero and read nothing
+__m256i gatherWords(const void* base, __m256i wordIndices, __m256 mask) {
+    return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*)base, wordIndices, _mm256_castps_si256(mask), 4);
+}
+
+// Counts the set bits in the lowest byte of every lane, the other bytes must be zero. AVX2 has no vector popcount, so every nibble is looked
+//  up in a table of bit counts.
+__m256i countLowByteBits(__m256i value) {
+    const __m256i nibbleBitCounts = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nibbleMask = _mm256_set1_epi32(0x0F);
+    __m256i lowNibbleCount = _mm256_shuffle_epi8(nibbleBitCounts, _mm256_and_si256(value, nibbleMask));
+    __m256i highNibbleCount = _mm256_shuffle_epi8(nibbleBitCounts, _mm256_and_si256(_mm256_srli_epi32(value, 4), nibbleMask));
+    return _mm256_add_epi8(lowNibbleCount, highNibbleCount);
+}
+
+// getNextVoxel for every lane in 'lanes'. The center of the next voxel is returned in 'cubeCenterPos', the lanes that are not in 'lanes'
+//  keep their normal and ray length.
+void getNextVoxelAVX2(__m256 cubeCenterPos[3], __m256 normal[3], __m256& rayLength, const __m256 origin[3], __m256 cubeWidth, const __m256 direction[3], const __m256 invDirection[3], __m256 lanes) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+    __m256 dRay[3], negativeSign[3];
+    for(int axis = 0; axis < 3; ++axis) {
+        __m256 isPositive = _mm256_cmp_ps(direction[axis], zero, _CMP_GT_OQ);
+        __m256 isNegative = _mm256_cmp_ps(direction[axis], zero, _CMP_LT_OQ);
+        __m256 signedWidth = selectLanes(_mm256_cmp_ps(direction[axis], zero, _CMP_GE_OQ), cubeWidth, _mm256_xor_ps(cubeWidth, signBit));
+        __m256 dPos = _mm256_sub_ps(_mm256_add_ps(cubeCenterPos[axis], _mm256_mul_ps(signedWidth, half)), origin[axis]);
+        dRay[axis] = _mm256_mul_ps(dPos, invDirection[axis]);
+        // -sign(direction), which is -0.0 for a direction of zero like in the shader
+        negativeSign[axis] = selectLanes(isPositive, _mm256_set1_ps(-1.0f), selectLanes(isNegative, _mm256_set1_ps(1.0f), signBit));
+    }
+
+    __m256 xIsMin = _mm256_and_ps(_mm256_cmp_ps(dRay[0], dRay[1], _CMP_LT_OQ), _mm256_cmp_ps(dRay[0], dRay[2], _CMP_LT_OQ));
+    __m256 yIsMin = _mm256_andnot_ps(xIsMin, _mm256_cmp_ps(dRay[1], dRay[2], _CMP_LT_OQ));
+    __m256 zIsMin = _mm256_andnot_ps(_mm256_or_ps(xIsMin, yIsMin), _mm256_castsi256_ps(_mm256_set1_epi32(-1)));
+
+    __m256 newNormal[3] = { _mm256_and_ps(xIsMin, negativeSign[0]), _mm256_and_ps(yIsMin, negativeSign[1]), _mm256_and_ps(zIsMin, negativeSign[2]) };
+    __m256 newRayLength = selectLanes(xIsMin, dRay[0], selectLanes(yIsMin, dRay[1], dRay[2]));
+
+    for(int axis = 0; axis < 3; ++axis) {
+        __m256 nextCubeCenterPos = _mm256_sub_ps(_mm256_add_ps(origin[axis], _mm256_mul_ps(newRayLength, direction[axis])), _mm256_mul_ps(newNormal[axis], half));
+        cubeCenterPos[axis] = _mm256_add_ps(_mm256_floor_ps(nextCubeCenterPos), half);
+        normal[axis] = selectLanes(lanes, newNormal[axis], normal[axis]);
+    }
+    rayLength = selectLanes(lanes, newRayLength, rayLength);
+}
+
+#else
+
+bool isPacketKernelCompiled() {
+    return false;
+}
+
+// Never called, since isPacketTracingVectorized returns false when this file is compiled without AVX2
+template<unsigned int ChunkWidth>
+void ChunkWidthOctreeRayCaster<ChunkWidth>::castRayPacketAVX2(const OctreeRayPacket& packet, unsigned int maxIterations, OctreeRayHit* hits) const {
+    for(unsigned int i = 0; i < RAY_PACKET_SIZE; ++i) {
+        glm::vec3 origin(packet.originX[i], packet.originY[i], packet.originZ[i]);
+        glm::vec3 direction(packet.directionX[i], packet.directionY[i], packet.directionZ[i]);
+        hits[i] = castRay(origin, direction, packet.startDistance[i], maxIterations, packet.maxDistance[i]);
+    }
+}
+
+#endif
+
+template void ChunkWidthOctreeRayCaster<1>::castRayPacketAVX2(const OctreeRayPacket&, unsigned int, OctreeRayHit*) const;
+template void ChunkWidthOctreeRayCaster<2>::castRayPacketAVX2(const OctreeRayPacket&, unsigned int, OctreeRayHit*) const;
+template void ChunkWidthOctreeRayCaster<4>::castRayPacketAVX2(const OctreeRayPacket&, unsigned int, OctreeRayHit*) const;
+template void ChunkWidthOctreeRayCaster<8>::castRayPacketAVX2(const OctreeRayPacket&, unsigned int, OctreeRayHit*) const;
+template void ChunkWidthOctreeRayCaster<16>::castRayPacketAVX2(const OctreeRayPacket&, unsigned int, OctreeRayHit*) const;
+template void ChunkWidthOctreeRayCaster<32>::castRayPacketAVX2(const OctreeRayPacket&, unsigned int, OctreeRayHit*) const;
+template void ChunkWidthOctreeRayCaster<64>::castRayPacketAVX2(const OctreeRayPacket&, unsigned int, OctreeRayHit*) const;
+template void ChunkWidthOctreeRayCaster<128>::castRayPacketAVX2(const OctreeRayPacket&, unsigned int, OctreeRayHit*) const;
+template void ChunkWidthOctreeRayCaster<256>::castRayPacketAVX2(const OctreeRayPacket&, unsigned int, OctreeRayHit*) const;
\ No newline at end of file
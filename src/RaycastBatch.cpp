@@ -0,0 +1,117 @@
+#include "RaycastBatch.h"
+#include <algorithm>
+#include <numeric>
+#include <iostream>
+
+uint64_t getRaySortKey(const glm::vec3& origin, const glm::vec3& direction, float worldWidth);
+
+RaycastBatch::RaycastBatch(const Octree& octree, unsigned int threadCount)
+    : m_octree(octree), m_threadPool(threadCount) {
+
+}
+
+unsigned int RaycastBatch::addRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) {
+    m_origins.push_back(origin);
+    m_directions.push_back(glm::normalize(direction));
+    m_maxDistances.push_back(maxDistance);
+    return m_origins.size() - 1;
+}
+
+void RaycastBatch::clear() {
+    m_origins.clear();
+    m_directions.clear();
+    m_maxDistances.clear();
+    m_hits.clear();
+}
+
+void RaycastBatch::trace(bool sortForCoherence) {
+    unsigned int rayCount = m_origins.size();
+    m_hits.resize(rayCount);
+    m_order.resize(rayCount);
+    std::iota(m_order.begin(), m_order.end(), 0);
+    if(sortForCoherence) sortRays();
+
+    // The ray caster is created for every batch since edits can move the nodes and chunks of the octree
+    std::unique_ptr<OctreeRayCaster> rayCaster = OctreeRayCaster::create(m_octree);
+    if(!rayCaster) {
+        std::cout << "ERROR: There is no ray caster for octrees with chunks of width " << (m_octree.worldWidth >> m_octree.maxDepth) << std::endl;
+        std::fill(m_hits.begin(), m_hits.end(), OctreeRayHit{ false, 0, -1.0f, glm::vec3(0.0f), glm::vec3(0.0f) });
+        return;
+    }
+
+    for(unsigned int begin = 0; begin < rayCount; begin += RAYS_PER_TASK) {
+        unsigned int end = std::min(begin + RAYS_PER_TASK, rayCount);
+        const OctreeRayCaster& caster = *rayCaster;
+        m_threadPool.submit([this, &caster, begin, end]() { traceRange(caster, begin, end); });
+    }
+    m_threadPool.wait();
+}
+
+// Orders the rays by the octant of their direction, then by their origin along a Morton curve and then by their direction, so that the rays
+//  that end up in the same packet start close to each other and point roughly the same way
+void RaycastBatch::sortRays() {
+    unsigned int rayCount = m_origins.size();
+    m_sortKeys.resize(rayCount);
+    for(unsigned int i = 0; i < rayCount; ++i) {
+        m_sortKeys[i] = getRaySortKey(m_origins[i], m_directions[i], (float)m_octree.worldWidth);
+    }
+    std::sort(m_order.begin(), m_order.end(), [this](unsigned int a, unsigned int b) { return m_sortKeys[a] < m_sortKeys[b]; });
+}
+
+// Traces the rays from 'begin' up to but not including 'end' in m_order, in packets as long as there are enough rays left for one
+void RaycastBatch::traceRange(const OctreeRayCaster& rayCaster, unsigned int begin, unsigned int end) {
+    // A ray can not visit more leaves than three times the number of the smallest leaves along the width of the world
+    unsigned int maxIterations = 3u << m_octree.maxDepth;
+
+    unsigned int orderIndex = begin;
+    for(; orderIndex + RAY_PACKET_SIZE <= end; orderIndex += RAY_PACKET_SIZE) {
+        OctreeRayPacket packet;
+        for(unsigned int lane = 0; lane < RAY_PACKET_SIZE; ++lane) {
+            unsigned int rayIndex = m_order[orderIndex + lane];
+            packet.originX[lane] = m_origins[rayIndex].x;
+            packet.originY[lane] = m_origins[rayIndex].y;
+            packet.originZ[lane] = m_origins[rayIndex].z;
+            packet.directionX[lane] = m_directions[rayIndex].x;
+            packet.directionY[lane] = m_directions[rayIndex].y;
+            packet.directionZ[lane] = m_directions[rayIndex].z;
+            packet.startDistance[lane] = 0.0f;
+            packet.maxDistance[lane] = m_maxDistances[rayIndex];
+        }
+
+        OctreeRayHit hits[RAY_PACKET_SIZE];
+        rayCaster.castRayPacket(packet, maxIterations, hits);
+        for(unsigned int lane = 0; lane < RAY_PACKET_SIZE; ++lane) {
+            m_hits[m_order[orderIndex + lane]] = hits[lane];
+        }
+    }
+
+    for(; orderIndex < end; ++orderIndex) {
+        unsigned int rayIndex = m_order[orderIndex];
+        m_hits[rayIndex] = rayCaster.castRay(m_origins[rayIndex], m_directions[rayIndex], 0.0f, maxIterations, m_maxDistances[rayIndex]);
+    }
+}
+
+// The octant of the direction in the highest bits, then the origin quantized to 12 bits per axis and the direction to 8 bits per axis, both
+//  with their bits interleaved
+uint64_t getRaySortKey(const glm::vec3& origin, const glm::vec3& direction, float worldWidth) {
+    auto spreadBits = [](uint64_t value) {
+        value &= 0xFFF;
+        value = (value | (value << 16)) & 0x0000FF0000FFull;
+        value = (value | (value << 8)) & 0x00F00F00F00Full;
+        value = (value | (value << 4)) & 0x0C30C30C30C3ull;
+        value = (value | (value << 2)) & 0x249249249249ull;
+        return value;
+    };
+    auto quantize = [](float value, float minValue, float maxValue, unsigned int steps) {
+        float normalized = (value - minValue) / (maxValue - minValue);
+        return (uint64_t)std::min(std::max(normalized * steps, 0.0f), steps - 1.0f);
+    };
+
+    uint64_t octant = ((direction.x >= 0.0f) ? 1 : 0) | ((direction.y >= 0.0f) ? 2 : 0) | ((direction.z >= 0.0f) ? 4 : 0);
+    uint64_t originCode = 0, directionCode = 0;
+    for(int axis = 0; axis < 3; ++axis) {
+        originCode |= spreadBits(quantize(origin[axis], -worldWidth / 2.0f, worldWidth / 2.0f, 4096)) << axis;
+        directionCode |= spreadBits(quantize(direction[axis], -1.0f, 1.0f, 256)) << axis;
+    }
+    return (octant << 60) | (originCode << 24) | directionCode;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include "OctreeRayCaster.h"
+#include "ThreadPool.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+// Traces many rays through an octree at once on a pool of threads, for queries like picking and line of sight that gameplay code makes every
+//  tick. Rays are added, traced together with trace() and their hits read with getHits(), in the order the rays were added. The rays are
+//  sorted so that rays that start close to each other and point the same way are traced together in packets, which visit the same nodes.
+class RaycastBatch {
+public:
+    // 'threadCount' is the number of threads that trace the rays, zero uses every available core
+    RaycastBatch(const Octree& octree, unsigned int threadCount = 0);
+
+    // Adds a ray and returns the index of its hit. 'direction' must not be zero but does not have to be normalized, distances are measured
+    //  in voxels. Voxels further away than 'maxDistance' are not hit.
+    unsigned int addRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance);
+    // Removes every ray and hit, the memory is kept for the next batch
+    void clear();
+
+    // Traces every ray that was added. The octree must not be changed while the rays are traced, but it can be edited between calls.
+    //  Without 'sortForCoherence' the rays are traced in the order they were added.
+    void trace(bool sortForCoherence = true);
+
+    const std::vector<OctreeRayHit>& getHits() const { return m_hits; }
+    unsigned int getRayCount() const { return m_origins.size(); }
+
+private:
+    void sortRays();
+    void traceRange(const OctreeRayCaster& rayCaster, unsigned int begin, unsigned int end);
+
+private:
+    // Number of rays traced by one task of the thread pool
+    static const unsigned int RAYS_PER_TASK = 512;
+
+    const Octree& m_octree;
+    ThreadPool m_threadPool;
+
+    std::vector<glm::vec3> m_origins;
+    std::vector<glm::vec3> m_directions;
+    std::vector<float> m_maxDistances;
+    std::vector<uint64_t> m_sortKeys;
+    std::vector<unsigned int> m_order; // Index of the rays in the order they are traced
+    std::vector<OctreeRayHit> m_hits;
+};
\ No newline at end of file
@@ -9,17 +9,33 @@
 #include <GL/glew.h>
 
 std::unordered_map<std::string, std::string> getSourcesFromFile(const char* filepath);
+std::string readShaderSource(const std::string& filepath);
 int createShader(const std::string& source, GLenum shaderType);
 void deleteShader(unsigned int shaderID);
 int createShaderProgram(unsigned int vertexShaderID, unsigned int fragmentShaderID);
+int createComputeShaderProgram(unsigned int computeShaderID);
 
 Shader::Shader(const char* filepath) {
     std::unordered_map<std::string, std::string> sources = getSourcesFromFile(filepath);
 
     auto vertexShaderSource = sources.find("vertex");
     auto fragmentShaderSource = sources.find("fragment");
+    auto computeShaderSource = sources.find("compute");
 
-    if(vertexShaderSource != sources.end() && fragmentShaderSource != sources.end()) {
+    if(computeShaderSource != sources.end()) {
+        int computeShaderID = createShader(computeShaderSource->second, GL_COMPUTE_SHADER);
+        if(computeShaderID < 0) {
+            m_compiled = false;
+            return;
+        }
+
+        m_shaderProgramID = createComputeShaderProgram(computeShaderID);
+        useShader();
+        loadUniformLocations();
+
+        deleteShader(computeShaderID);
+    }
+    else if(vertexShaderSource != sources.end() && fragmentShaderSource != sources.end()) {
         int vertexShaderID = createShader(vertexShaderSource->second, GL_VERTEX_SHADER);
         int fragmentShaderID = createShader(fragmentShaderSource->second, GL_FRAGMENT_SHADER);
         if(vertexShaderID < 0 || fragmentShaderID < 0) {
@@ -29,12 +45,13 @@ Shader::Shader(const char* filepath) {
 
         m_shaderProgramID = createShaderProgram(vertexShaderID, fragmentShaderID);
         useShader();
+        loadUniformLocations();
 
         deleteShader(vertexShaderID);
         deleteShader(fragmentShaderID);
     }
     else {
-        std::cout << "ERROR: No vertex and/or fragment shader" << std::endl;
+        std::cout << "ERROR: No compute shader or vertex and/or fragment shader" << std::endl;
         m_compiled = false;
         return;
     }
@@ -64,111 +81,219 @@ void Shader::bindTextures() {
 }
 
 void Shader::setUniform1f(const char* name, const float& v) {
-    glUniform1f(getUniformLocation(name), v);
+    setUniform1f(getUniformLocation(name), v);
 }
 
 void Shader::setUniform2f(const char* name, const float& v1, const float& v2) {
-    glUniform2f(getUniformLocation(name), v1, v2);
+    setUniform2f(getUniformLocation(name), v1, v2);
 }
 
 void Shader::setUniform3f(const char* name, const float& v1, const float& v2, const float& v3) {
-    glUniform3f(getUniformLocation(name), v1, v2, v3);
+    setUniform3f(getUniformLocation(name), v1, v2, v3);
 }
 
 void Shader::setUniform4f(const char* name, const float& v1, const float& v2, const float& v3, const float& v4) {
-    glUniform4f(getUniformLocation(name), v1, v2, v3, v4);
+    setUniform4f(getUniformLocation(name), v1, v2, v3, v4);
 }
 
 void Shader::setUniform1i(const char* name, const int& v) {
-    glUniform1i(getUniformLocation(name), v);
+    setUniform1i(getUniformLocation(name), v);
 }
 
 void Shader::setUniform2i(const char* name, const int& v1, const int& v2) {
-    glUniform2i(getUniformLocation(name), v1, v2);
+    setUniform2i(getUniformLocation(name), v1, v2);
 }
 
 void Shader::setUniform3i(const char* name, const int& v1, const int& v2, const int& v3) {
-    glUniform3i(getUniformLocation(name), v1, v2, v3);
+    setUniform3i(getUniformLocation(name), v1, v2, v3);
 }
 
 void Shader::setUniform4i(const char* name, const int& v1, const int& v2, const int& v3, const int& v4) {
-    glUniform4i(getUniformLocation(name), v1, v2, v3, v4);
+    setUniform4i(getUniformLocation(name), v1, v2, v3, v4);
 }
 
 void Shader::setUniform1ui(const char* name, const unsigned int& v) {
-    glUniform1ui(getUniformLocation(name), v);
+    setUniform1ui(getUniformLocation(name), v);
 }
 
 void Shader::setUniform2ui(const char* name, const unsigned int& v1, const unsigned int& v2) {
-    glUniform2ui(getUniformLocation(name), v1, v2);
+    setUniform2ui(getUniformLocation(name), v1, v2);
 }
 
 void Shader::setUniform3ui(const char* name, const unsigned int& v1, const unsigned int& v2, const unsigned int& v3) {
-    glUniform3ui(getUniformLocation(name), v1, v2, v3);
+    setUniform3ui(getUniformLocation(name), v1, v2, v3);
 }
 
 void Shader::setUniform4ui(const char* name, const unsigned int& v1, const unsigned int& v2, const unsigned int& v3, const unsigned int& v4) {
-    glUniform4ui(getUniformLocation(name), v1, v2, v3, v4);
+    setUniform4ui(getUniformLocation(name), v1, v2, v3, v4);
 }
 
 void Shader::setUniform1fv(const char* name, const unsigned int count, const float* v) {
-    glUniform1fv(getUniformLocation(name), count, v);
+    setUniform1fv(getUniformLocation(name), count, v);
 }
 
 void Shader::setUniform2fv(const char* name, const unsigned int count, const float* v) {
-    glUniform2fv(getUniformLocation(name), count, v);
+    setUniform2fv(getUniformLocation(name), count, v);
 }
 
 void Shader::setUniform3fv(const char* name, const unsigned int count, const float* v) {
-    glUniform3fv(getUniformLocation(name), count, v);
+    setUniform3fv(getUniformLocation(name), count, v);
 }
 
 void Shader::setUniform4fv(const char* name, const unsigned int count, const float* v) {
-    glUniform4fv(getUniformLocation(name), count, v);
+    setUniform4fv(getUniformLocation(name), count, v);
 }
 
 void Shader::setUniform1iv(const char* name, const unsigned int count, const int* v) {
-    glUniform1iv(getUniformLocation(name), count, v);
+    setUniform1iv(getUniformLocation(name), count, v);
 }
 
 void Shader::setUniform2iv(const char* name, const unsigned int count, const int* v) {
-    glUniform2iv(getUniformLocation(name), count, v);
+    setUniform2iv(getUniformLocation(name), count, v);
 }
 
 void Shader::setUniform3iv(const char* name, const unsigned int count, const int* v) {
-    glUniform3iv(getUniformLocation(name), count, v);
+    setUniform3iv(getUniformLocation(name), count, v);
 }
 
 void Shader::setUniform4iv(const char* name, const unsigned int count, const int* v) {
-    glUniform4iv(getUniformLocation(name), count, v);
+    setUniform4iv(getUniformLocation(name), count, v);
 }
 
 void Shader::setUniform1uiv(const char* name, const unsigned int count, const unsigned int* v) {
-    glUniform1uiv(getUniformLocation(name), count, v);
+    setUniform1uiv(getUniformLocation(name), count, v);
 }
 
 void Shader::setUniform2uiv(const char* name, const unsigned int count, const unsigned int* v) {
-    glUniform2uiv(getUniformLocation(name), count, v);
+    setUniform2uiv(getUniformLocation(name), count, v);
 }
 
 void Shader::setUniform3uiv(const char* name, const unsigned int count, const unsigned int* v) {
-    glUniform3uiv(getUniformLocation(name), count, v);
+    setUniform3uiv(getUniformLocation(name), count, v);
 }
 
 void Shader::setUniform4uiv(const char* name, const unsigned int count, const unsigned int* v) {
-    glUniform4uiv(getUniformLocation(name), count, v);
+    setUniform4uiv(getUniformLocation(name), count, v);
 }
 
 void Shader::setUniformMat2(const char* name, const glm::mat2& matrix) {
-    glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &(matrix[0][0]));
+    setUniformMat2(getUniformLocation(name), matrix);
 }
 
 void Shader::setUniformMat3(const char* name, const glm::mat3& matrix) {
-    glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &(matrix[0][0]));
+    setUniformMat3(getUniformLocation(name), matrix);
 }
 
 void Shader::setUniformMat4(const char* name, const glm::mat4& matrix) {
-    glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &(matrix[0][0]));
+    setUniformMat4(getUniformLocation(name), matrix);
+}
+
+void Shader::setUniform1f(int location, const float& v) {
+    glUniform1f(location, v);
+}
+
+void Shader::setUniform2f(int location, const float& v1, const float& v2) {
+    glUniform2f(location, v1, v2);
+}
+
+void Shader::setUniform3f(int location, const float& v1, const float& v2, const float& v3) {
+    glUniform3f(location, v1, v2, v3);
+}
+
+void Shader::setUniform4f(int location, const float& v1, const float& v2, const float& v3, const float& v4) {
+    glUniform4f(location, v1, v2, v3, v4);
+}
+
+void Shader::setUniform1i(int location, const int& v) {
+    glUniform1i(location, v);
+}
+
+void Shader::setUniform2i(int location, const int& v1, const int& v2) {
+    glUniform2i(location, v1, v2);
+}
+
+void Shader::setUniform3i(int location, const int& v1, const int& v2, const int& v3) {
+    glUniform3i(location, v1, v2, v3);
+}
+
+void Shader::setUniform4i(int location, const int& v1, const int& v2, const int& v3, const int& v4) {
+    glUniform4i(location, v1, v2, v3, v4);
+}
+
+void Shader::setUniform1ui(int location, const unsigned int& v) {
+    glUniform1ui(location, v);
+}
+
+void Shader::setUniform2ui(int location, const unsigned int& v1, const unsigned int& v2) {
+    glUniform2ui(location, v1, v2);
+}
+
+void Shader::setUniform3ui(int location, const unsigned int& v1, const unsigned int& v2, const unsigned int& v3) {
+    glUniform3ui(location, v1, v2, v3);
+}
+
+void Shader::setUniform4ui(int location, const unsigned int& v1, const unsigned int& v2, const unsigned int& v3, const unsigned int& v4) {
+    glUniform4ui(location, v1, v2, v3, v4);
+}
+
+void Shader::setUniform1fv(int location, const unsigned int count, const float* v) {
+    glUniform1fv(location, count, v);
+}
+
+void Shader::setUniform2fv(int location, const unsigned int count, const float* v) {
+    glUniform2fv(location, count, v);
+}
+
+void Shader::setUniform3fv(int location, const unsigned int count, const float* v) {
+    glUniform3fv(location, count, v);
+}
+
+void Shader::setUniform4fv(int location, const unsigned int count, const float* v) {
+    glUniform4fv(location, count, v);
+}
+
+void Shader::setUniform1iv(int location, const unsigned int count, const int* v) {
+    glUniform1iv(location, count, v);
+}
+
+void Shader::setUniform2iv(int location, const unsigned int count, const int* v) {
+    glUniform2iv(location, count, v);
+}
+
+void Shader::setUniform3iv(int location, const unsigned int count, const int* v) {
+    glUniform3iv(location, count, v);
+}
+
+void Shader::setUniform4iv(int location, const unsigned int count, const int* v) {
+    glUniform4iv(location, count, v);
+}
+
+void Shader::setUniform1uiv(int location, const unsigned int count, const unsigned int* v) {
+    glUniform1uiv(location, count, v);
+}
+
+void Shader::setUniform2uiv(int location, const unsigned int count, const unsigned int* v) {
+    glUniform2uiv(location, count, v);
+}
+
+void Shader::setUniform3uiv(int location, const unsigned int count, const unsigned int* v) {
+    glUniform3uiv(location, count, v);
+}
+
+void Shader::setUniform4uiv(int location, const unsigned int count, const unsigned int* v) {
+    glUniform4uiv(location, count, v);
+}
+
+void Shader::setUniformMat2(int location, const glm::mat2& matrix) {
+    glUniformMatrix2fv(location, 1, GL_FALSE, &(matrix[0][0]));
+}
+
+void Shader::setUniformMat3(int location, const glm::mat3& matrix) {
+    glUniformMatrix3fv(location, 1, GL_FALSE, &(matrix[0][0]));
+}
+
+void Shader::setUniformMat4(int location, const glm::mat4& matrix) {
+    glUniformMatrix4fv(location, 1, GL_FALSE, &(matrix[0][0]));
 }
 
 void Shader::setTexture(std::weak_ptr<Texture> texture, unsigned int target, const char* samplerUniformName) {
@@ -176,31 +301,46 @@ void Shader::setTexture(std::weak_ptr<Texture> texture, unsigned int target, con
     setUniform1i(samplerUniformName, target);
 }
 
-int Shader::getUniformLocation(const char* name) {
+void Shader::setTexture(std::weak_ptr<Texture> texture, unsigned int target) {
+    m_textures[target] = texture;
+}
+
+int Shader::getUniformLocation(const char* name) const {
     auto search = m_uniformLocations.find(name);
     if(search != m_uniformLocations.end()) {
         return search->second;
     }
 
-    int uniformLocation = glGetUniformLocation(m_shaderProgramID, name);
-    m_uniformLocations.insert(std::pair<const char*, int>(name, uniformLocation));
+    return -1;
+}
+
+// Every active uniform is looked up once after linking. Arrays are reported as "name[0]" and are stored under their plain name.
+void Shader::loadUniformLocations() {
+    int uniformCount = 0, maxNameLength = 0;
+    glGetProgramiv(m_shaderProgramID, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(m_shaderProgramID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
 
-    return uniformLocation;
+    std::string name(maxNameLength, '\0');
+    for(int i = 0; i < uniformCount; ++i) {
+        int nameLength = 0, size = 0;
+        GLenum type;
+        glGetActiveUniform(m_shaderProgramID, i, maxNameLength, &nameLength, &size, &type, &name[0]);
+
+        std::string uniformName = name.substr(0, nameLength);
+        int uniformLocation = glGetUniformLocation(m_shaderProgramID, uniformName.c_str());
+        // Members of uniform blocks have no location
+        if(uniformLocation < 0) continue;
+
+        size_t arraySuffix = uniformName.rfind("[0]");
+        if(arraySuffix != std::string::npos && arraySuffix + 3 == uniformName.size()) uniformName.erase(arraySuffix);
+        m_uniformLocations[uniformName] = uniformLocation;
+    }
 }
 
 std::unordered_map<std::string, std::string> getSourcesFromFile(const char* filepath) {
     std::unordered_map<std::string, std::string> shaderSections;
-    
-    std::ifstream filestream(filepath, std::ios::in);
-    if(!filestream.is_open()) {
-        std::cout << "Could not open file " << filepath << std::endl;
-        return shaderSections;
-    }
-    std::stringstream buffer;
-    buffer << filestream.rdbuf();
-    filestream.close();
-    
-    std::string shaderSource = buffer.str();
+
+    std::string shaderSource = readShaderSource(filepath);
 
     const char* sectionToken = "#section";
     size_t sectionTokenLength = std::strlen(sectionToken);
@@ -219,6 +359,38 @@ std::unordered_map<std::string, std::string> getSourcesFromFile(const char* file
     return shaderSections;
 }
 
+// Reads a shader file and replaces every '#include "filename"' with the source of that file, the filename being relative to the including file
+std::string readShaderSource(const std::string& filepath) {
+    std::ifstream filestream(filepath, std::ios::in);
+    if(!filestream.is_open()) {
+        std::cout << "Could not open file " << filepath << std::endl;
+        return "";
+    }
+    std::stringstream buffer;
+    buffer << filestream.rdbuf();
+    filestream.close();
+
+    std::string source = buffer.str();
+
+    size_t directoryEnd = filepath.find_last_of("/\\");
+    std::string directory = (directoryEnd == std::string::npos) ? "" : filepath.substr(0, directoryEnd + 1);
+
+    const char* includeToken = "#include \"";
+    size_t includeTokenLength = std::strlen(includeToken);
+    size_t pos = source.find(includeToken, 0);
+    while(pos != std::string::npos) {
+        size_t filenameBegin = pos + includeTokenLength;
+        size_t filenameEnd = source.find('"', filenameBegin);
+        if(filenameEnd == std::string::npos) break;
+
+        std::string includedSource = readShaderSource(directory + source.substr(filenameBegin, filenameEnd - filenameBegin));
+        source.replace(pos, filenameEnd + 1 - pos, includedSource);
+        pos = source.find(includeToken, pos + includedSource.size());
+    }
+
+    return source;
+}
+
 int createShader(const std::string& source, GLenum shaderType) {
     unsigned int shaderID = glCreateShader(shaderType);
 
@@ -259,5 +431,23 @@ int createShaderProgram(unsigned int vertexShaderID, unsigned int fragmentShader
         std::cout << "ERROR: SHADER PROGRAM LINKING FAILED\n" << infoLog << std::endl;
     }
 
+    return shaderProgramID;
+}
+
+int createComputeShaderProgram(unsigned int computeShaderID) {
+    unsigned int shaderProgramID = glCreateProgram();
+
+    glAttachShader(shaderProgramID, computeShaderID);
+    glLinkProgram(shaderProgramID);
+
+    int  success;
+    char infoLog[512];
+    glGetProgramiv(shaderProgramID, GL_LINK_STATUS, &success);
+
+    if(!success) {
+        glGetProgramInfoLog(shaderProgramID, 512, NULL, infoLog);
+        std::cout << "ERROR: SHADER PROGRAM LINKING FAILED\n" << infoLog << std::endl;
+    }
+
     return shaderProgramID;
 }
\ No newline at end of file
@@ -44,17 +44,51 @@ public:
     void setUniformMat3(const char* name, const glm::mat3& matrix);
     void setUniformMat4(const char* name, const glm::mat4& matrix);
 
+    // The location overloads take locations from getUniformLocation, so that no names are looked up while rendering
+    void setUniform1f(int location, const float& v);
+    void setUniform2f(int location, const float& v1, const float& v2);
+    void setUniform3f(int location, const float& v1, const float& v2, const float& v3);
+    void setUniform4f(int location, const float& v1, const float& v2, const float& v3, const float& v4);
+    void setUniform1i(int location, const int& v);
+    void setUniform2i(int location, const int& v1, const int& v2);
+    void setUniform3i(int location, const int& v1, const int& v2, const int& v3);
+    void setUniform4i(int location, const int& v1, const int& v2, const int& v3, const int& v4);
+    void setUniform1ui(int location, const unsigned int& v);
+    void setUniform2ui(int location, const unsigned int& v1, const unsigned int& v2);
+    void setUniform3ui(int location, const unsigned int& v1, const unsigned int& v2, const unsigned int& v3);
+    void setUniform4ui(int location, const unsigned int& v1, const unsigned int& v2, const unsigned int& v3, const unsigned int& v4);
+    void setUniform1fv(int location, const unsigned int count, const float* v);
+    void setUniform2fv(int location, const unsigned int count, const float* v);
+    void setUniform3fv(int location, const unsigned int count, const float* v);
+    void setUniform4fv(int location, const unsigned int count, const float* v);
+    void setUniform1iv(int location, const unsigned int count, const int* v);
+    void setUniform2iv(int location, const unsigned int count, const int* v);
+    void setUniform3iv(int location, const unsigned int count, const int* v);
+    void setUniform4iv(int location, const unsigned int count, const int* v);
+    void setUniform1uiv(int location, const unsigned int count, const unsigned int* v);
+    void setUniform2uiv(int location, const unsigned int count, const unsigned int* v);
+    void setUniform3uiv(int location, const unsigned int count, const unsigned int* v);
+    void setUniform4uiv(int location, const unsigned int count, const unsigned int* v);
+    void setUniformMat2(int location, const glm::mat2& matrix);
+    void setUniformMat3(int location, const glm::mat3& matrix);
+    void setUniformMat4(int location, const glm::mat4& matrix);
+
     void setTexture(std::weak_ptr<Texture> texture, unsigned int target, const char* samplerUniformName);
+    // Replaces the texture of a texture unit whose sampler uniform has already been set
+    void setTexture(std::weak_ptr<Texture> texture, unsigned int target);
+
+    // Returns -1 for names that are not an active uniform of the shader, which the setUniform functions ignore
+    int getUniformLocation(const char* name) const;
 
     unsigned int getShaderProgramID() const { return m_shaderProgramID; }
 
 private:
-    int getUniformLocation(const char* name);
+    void loadUniformLocations();
 
 private:
     unsigned int m_shaderProgramID;
     bool m_compiled;
 
-    std::unordered_map<const char*, int> m_uniformLocations;
+    std::unordered_map<std::string, int> m_uniformLocations;
     std::unordered_map<unsigned int, std::weak_ptr<Texture>> m_textures;
 };
\ No newline at end of file
@@ -1,10 +1,15 @@
 #include "ShaderStorageBuffer.h"
 #include <GL/glew.h>
 
-ShaderStorageBuffer::ShaderStorageBuffer(unsigned int index) : Buffer() {
+ShaderStorageBuffer::ShaderStorageBuffer(unsigned int index) : Buffer(), m_index(index) {
     bind();
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, getBufferID());
 }
+
+// Shaders only see the partition of the current frame
+void ShaderStorageBuffer::bindPartition() {
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, m_index, getBufferID(), getPartitionOffset(), getDataSize());
+}
     
 int ShaderStorageBuffer::getBufferType() {
     return GL_SHADER_STORAGE_BUFFER;
@@ -5,6 +5,12 @@ class ShaderStorageBuffer : public Buffer {
 public:
     ShaderStorageBuffer(unsigned int index);
     
+protected:
+    virtual void bindPartition() override;
+
 private:
     virtual int getBufferType() override;
+
+private:
+    unsigned int m_index;
 };
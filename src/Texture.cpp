@@ -2,6 +2,8 @@
 #include <GL/glew.h>
 
 #include <iostream>
+#include <fstream>
+#include <vector>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -76,6 +78,24 @@ void Texture::textureImage2D(TextureFormat textureFormat, unsigned int width, un
     textureImage2dInternal(textureFormat, width, height, data, GL_FLOAT);
 }
 
+bool Texture::saveImage(const char* filename) {
+    std::ofstream file(filename, std::ios::binary);
+    if(!file.is_open()) {
+        std::cout << "ERROR: Could not open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> pixels((size_t)m_width * m_height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureImage(m_textureID, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels.size(), pixels.data());
+
+    file << "P6\n" << m_width << " " << m_height << "\n255\n";
+    for(unsigned int y = m_height; y > 0; --y) {
+        file.write((const char*)pixels.data() + (size_t)(y - 1) * m_width * 3, (size_t)m_width * 3);
+    }
+    return file.good();
+}
+
 void Texture::bind() {
     glBindTexture(m_textureTypeID, m_textureID);
 }
@@ -84,6 +104,17 @@ void Texture::unbind() {
     glBindTexture(m_textureTypeID, 0);
 }
 
+void Texture::bindImage(unsigned int unit, TextureAccess access) {
+    GLenum glAccess = GL_READ_WRITE;
+    switch(access) {
+        case TextureAccess::READ_ONLY: glAccess = GL_READ_ONLY; break;
+        case TextureAccess::WRITE_ONLY: glAccess = GL_WRITE_ONLY; break;
+        case TextureAccess::READ_WRITE: glAccess = GL_READ_WRITE; break;
+    }
+
+    glBindImageTexture(unit, m_textureID, 0, GL_FALSE, 0, glAccess, getOpenGLTextureFormats(m_textureFormat).first);
+}
+
 void Texture::setFilterMode(TextureFilterMode filterMode) {
     unsigned int filterModeID = getOpenGLFilterMode(filterMode);
 
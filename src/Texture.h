@@ -12,6 +12,10 @@ enum class TextureWrapMode {
     CLAMP_TO_EDGE, CLAMP_TO_BORDER, MIRRORED_REPEAT, REPEAT, MIRROR_CLAMP_TO_EDGE
 };
 
+enum class TextureAccess {
+    READ_ONLY, WRITE_ONLY, READ_WRITE
+};
+
 enum class TextureFormat {
     R, RG, RGB, RGBA,
     R8, R16, RG8, RG16, RGB8, RGB12, RGBA8, RGBA16, SRGB8, SRGB8_ALPHA8, R16F, RG16F, RGB16F, RGBA16F, R32F, RG32F, RGB32F,
@@ -33,8 +37,13 @@ public:
     void textureImage2D(TextureFormat textureFormat, unsigned int width, unsigned int height, unsigned int* data);
     void textureImage2D(TextureFormat textureFormat, unsigned int width, unsigned int height, float* data);
 
+    // Writes level 0 of the texture to a binary PPM file with 8 bits per channel, the first row of the texture is the bottom row of the image
+    bool saveImage(const char* filename);
+
     void bind();
     void unbind();
+    // Binds level 0 of the texture to an image unit, for image load/store in shaders
+    void bindImage(unsigned int unit, TextureAccess access);
 
     void setFilterMode(TextureFilterMode filterMode);
     void setWrapModeS(TextureWrapMode wrapMode);
@@ -0,0 +1,126 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+// Index of the queue owned by the current thread, or -1 if the thread does not belong to a pool
+thread_local int t_workerIndex = -1;
+thread_local ThreadPool* t_workerPool = nullptr;
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+    : m_queuedTasks(0), m_unfinishedTasks(0), m_nextQueue(0), m_stopping(false) {
+
+    if(threadCount == 0) threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for(unsigned int i = 0; i < threadCount; ++i) {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    // The last queue belongs to the thread calling wait()
+    for(unsigned int i = 0; i + 1 < threadCount; ++i) {
+        m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for(std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    unsigned int queueIndex;
+    if(t_workerPool == this) {
+        queueIndex = t_workerIndex;
+    }
+    else {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        queueIndex = m_nextQueue;
+        m_nextQueue = (m_nextQueue + 1) % m_queues.size();
+    }
+
+    // The counters are increased first so that they never drop below the number of tasks in the queues
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queuedTasks++;
+        m_unfinishedTasks++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_queues[queueIndex]->mutex);
+        m_queues[queueIndex]->tasks.push_back(std::move(task));
+    }
+    m_condition.notify_all();
+}
+
+void ThreadPool::wait() {
+    unsigned int workerIndex = m_queues.size() - 1;
+    int previousWorkerIndex = t_workerIndex;
+    ThreadPool* previousWorkerPool = t_workerPool;
+    t_workerIndex = workerIndex;
+    t_workerPool = this;
+
+    while(true) {
+        if(runTask(workerIndex)) continue;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(m_unfinishedTasks == 0) break;
+        if(m_queuedTasks == 0) {
+            m_condition.wait(lock, [this]() { return m_unfinishedTasks == 0 || m_queuedTasks > 0; });
+        }
+    }
+
+    t_workerIndex = previousWorkerIndex;
+    t_workerPool = previousWorkerPool;
+}
+
+void ThreadPool::workerLoop(unsigned int workerIndex) {
+    t_workerIndex = workerIndex;
+    t_workerPool = this;
+
+    while(true) {
+        if(runTask(workerIndex)) continue;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() { return m_stopping || m_queuedTasks > 0; });
+        if(m_stopping) return;
+    }
+}
+
+// Runs one task from the worker's own queue, or steals one from another worker. Returns false if every queue was empty.
+bool ThreadPool::runTask(unsigned int workerIndex) {
+    std::function<void()> task;
+
+    for(unsigned int i = 0; i < m_queues.size() && !task; ++i) {
+        WorkerQueue& queue = *m_queues[(workerIndex + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.tasks.empty()) continue;
+
+        if(i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if(!task) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queuedTasks--;
+    }
+
+    task();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_unfinishedTasks--;
+        if(m_unfinishedTasks == 0) m_condition.notify_all();
+    }
+    return true;
+}
\ No newline at end of file
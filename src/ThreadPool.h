@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+
+// A pool of worker threads where every worker has its own task queue. A worker runs the newest task in its own queue first and steals the
+//  oldest task from another worker when its queue is empty. The thread calling wait() works as one of the workers until every task is done.
+class ThreadPool {
+public:
+    ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+    void wait();
+
+    unsigned int getThreadCount() const { return m_queues.size(); }
+
+private:
+    void workerLoop(unsigned int workerIndex);
+    bool runTask(unsigned int workerIndex);
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::thread> m_threads;
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    unsigned int m_queuedTasks;
+    unsigned int m_unfinishedTasks;
+    unsigned int m_nextQueue;
+    bool m_stopping;
+};
\ No newline at end of file
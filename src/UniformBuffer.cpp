@@ -0,0 +1,16 @@
+#include "UniformBuffer.h"
+#include <GL/glew.h>
+
+UniformBuffer::UniformBuffer(unsigned int index) : Buffer(), m_index(index) {
+    bind();
+    glBindBufferBase(GL_UNIFORM_BUFFER, index, getBufferID());
+}
+
+// Shaders only see the partition of the current frame
+void UniformBuffer::bindPartition() {
+    glBindBufferRange(GL_UNIFORM_BUFFER, m_index, getBufferID(), getPartitionOffset(), getDataSize());
+}
+
+int UniformBuffer::getBufferType() {
+    return GL_UNIFORM_BUFFER;
+}
\ No newline at end of file
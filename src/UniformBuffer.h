@@ -0,0 +1,16 @@
+#pragma once
+#include "Buffer.h"
+
+class UniformBuffer : public Buffer {
+public:
+    UniformBuffer(unsigned int index);
+
+protected:
+    virtual void bindPartition() override;
+
+private:
+    virtual int getBufferType() override;
+
+private:
+    unsigned int m_index;
+};
@@ -1,41 +1,52 @@
 #include "VoxelLoader.h"
+#include "FileMapping.h"
+#include "ThreadPool.h"
 #include <fstream>
 #include <sstream>
 #include <cstring>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <emmintrin.h>
 
 namespace VoxelLoader {
 
-    VoxelData parseVoxelFile(uint8_t* fileBuffer, unsigned int fileSize, VoxelDataAxis axis);
-    VoxelData parseXRAWFile(uint8_t* fileBuffer, unsigned int fileSize, VoxelDataAxis axis);
-
-    VoxelData loadVoxelData(const char* filename, VoxelDataAxis axis) {
-        std::ifstream file(filename, std::ios::binary | std::ios::in | std::ios::ate);
-        if(!file.is_open()) {
+    struct XRAWHeader {
+        uint32_t XRAW;
+        uint8_t colorChannelDataType;
+        uint8_t numOfColorChannels;
+        uint8_t bitsPerChannel;
+        uint8_t bitsPerIndex;
+        uint32_t x;
+        uint32_t y;
+        uint32_t z;
+        uint32_t numOfPaletteColors;
+    };
+
+    VoxelData parseVoxelFile(const uint8_t* fileBuffer, size_t fileSize, VoxelDataAxis axis, unsigned int threadCount);
+    float* parseXRAWPalette(const uint8_t* paletteBuffer, const XRAWHeader& header);
+
+    VoxelData loadVoxelData(const char* filename, VoxelDataAxis axis, unsigned int threadCount) {
+        // The file is parsed straight from the mapping, so the voxels are only copied once, into the returned buffer
+        size_t fileSize;
+        void* mapping = FileMapping::mapFile(filename, fileSize);
+        if(mapping == nullptr) {
             std::cout << "Could not open file " << filename << std::endl;
             return {nullptr, 0, 0, 0, nullptr};
         }
 
-        std::streampos fileSize = file.tellg();
-        file.seekg(0, std::ios::beg);
-
-        uint8_t* fileBuffer = new uint8_t[fileSize];
-        file.read((char*)fileBuffer, fileSize);
-        
-        file.close();
-
-        VoxelData res = parseVoxelFile(fileBuffer, fileSize, axis);
+        VoxelData res = parseVoxelFile((const uint8_t*)mapping, fileSize, axis, threadCount);
 
-        delete[] fileBuffer;
+        FileMapping::unmapFile(mapping, fileSize);
 
         return res;
     }
 
-    VoxelData parseVoxelFile(uint8_t* fileBuffer, unsigned int fileSize, VoxelDataAxis axis) {
+    VoxelData parseVoxelFile(const uint8_t* fileBuffer, size_t fileSize, VoxelDataAxis axis, unsigned int threadCount) {
         if(fileSize < 4) return {nullptr, 0, 0, 0, nullptr};
 
         if(fileBuffer[0] == 'X' && fileBuffer[1] == 'R' && fileBuffer[2] == 'A' && fileBuffer[3] == 'W'){
-            return parseXRAWFile(fileBuffer, fileSize, axis);
+            return parseXRAWFile(fileBuffer, fileSize, axis, threadCount);
         }
         else {
             std::cout << "unsuported file type" << std::endl;
@@ -43,23 +54,11 @@ namespace VoxelLoader {
         }
     }
 
-    VoxelData parseXRAWFile(uint8_t* fileBuffer, unsigned int fileSize, VoxelDataAxis axis) {
-        struct Header {
-            uint32_t XRAW;
-            uint8_t colorChannelDataType;
-            uint8_t numOfColorChannels;
-            uint8_t bitsPerChannel;
-            uint8_t bitsPerIndex;
-            uint32_t x;
-            uint32_t y;
-            uint32_t z;
-            uint32_t numOfPaletteColors;
-        };
-
-        if(fileSize < sizeof(Header)) return {nullptr, 0, 0, 0, nullptr};
-
-        Header header;
-        header = *((Header*)fileBuffer);
+    VoxelData parseXRAWFile(const uint8_t* fileBuffer, size_t fileSize, VoxelDataAxis axis, unsigned int threadCount) {
+        if(fileSize < sizeof(XRAWHeader)) return {nullptr, 0, 0, 0, nullptr};
+
+        XRAWHeader header;
+        std::memcpy(&header, fileBuffer, sizeof(XRAWHeader));
         
         std::cout << (int)header.colorChannelDataType << ", " << (int)header.numOfColorChannels << ", " << (int)header.bitsPerChannel << ", " << (int)header.bitsPerIndex << ", " << (int)header.x << ", " << (int)header.y << ", " << (int)header.z << ", " << (int)header.numOfPaletteColors << std::endl; 
         if(header.numOfPaletteColors != 256) {
@@ -67,9 +66,9 @@ namespace VoxelLoader {
             return {nullptr, 0, 0, 0, nullptr};
         }
 
-        unsigned int voxelDataSize = header.x * header.y * header.z * (header.bitsPerIndex / 8);
-        unsigned int paletteDataSize = header.numOfColorChannels * (header.bitsPerChannel / 8) * header.numOfPaletteColors;
-        if(fileSize < sizeof(Header) + voxelDataSize + paletteDataSize) {
+        size_t voxelDataSize = (size_t)header.x * header.y * header.z * (header.bitsPerIndex / 8);
+        size_t paletteDataSize = header.numOfColorChannels * (header.bitsPerChannel / 8) * header.numOfPaletteColors;
+        if(fileSize < sizeof(XRAWHeader) + voxelDataSize + paletteDataSize) {
             std::cout << "ERROR: File too small" << std::endl;
             return {nullptr, 0, 0, 0, nullptr};
         }
@@ -77,56 +76,163 @@ namespace VoxelLoader {
         uint8_t* voxelDataBuffer = new uint8_t[voxelDataSize];
 
         if(axis == VoxelDataAxis::Z_Up) {
-            for(int z = 0; z < header.z; ++z) {
-                for(int y = 0; y < header.y; ++y) {
-                    for(int x = 0; x < header.x; ++x) {
-                        int srcIndex = sizeof(Header) + x + z * header.x + y * header.x * header.z;
-                        int destIndex = x + y * header.x + z * header.x * header.y;
-                        voxelDataBuffer[destIndex] = fileBuffer[srcIndex];
-                    }
-                }
-            }
+            transposeZUp(fileBuffer + sizeof(XRAWHeader), voxelDataBuffer, header.x * (header.bitsPerIndex / 8), header.y, header.z, threadCount);
         }
         else {
-            std::memcpy(voxelDataBuffer, fileBuffer + sizeof(Header), voxelDataSize);
+            std::memcpy(voxelDataBuffer, fileBuffer + sizeof(XRAWHeader), voxelDataSize);
+        }
+
+        float* paletteData = parseXRAWPalette(fileBuffer + sizeof(XRAWHeader) + voxelDataSize, header);
+
+        return {voxelDataBuffer, header.x, header.y, header.z, paletteData};
+    }
+
+    void transposeZUp(const uint8_t* source, uint8_t* destination, size_t rowSize, unsigned int sizeY, unsigned int sizeZ, unsigned int threadCount) {
+        // Swapping y and z moves whole rows of x, the row at (y, z) in the source is the row at (z, y) in the destination. The rows are
+        //  copied in tiles of TILE_WIDTH * TILE_WIDTH rows, so that every tile reads TILE_WIDTH runs of contiguous source rows and writes
+        //  TILE_WIDTH runs of contiguous destination rows instead of jumping a whole source layer for every row.
+        const unsigned int TILE_WIDTH = 16;
+        size_t sourceLayerSize = rowSize * sizeZ;
+        size_t destinationLayerSize = rowSize * sizeY;
+
+        // Every task copies a band of TILE_WIDTH destination layers, so no two tasks write to the same memory
+        ThreadPool threadPool(threadCount);
+        for(unsigned int tileZ = 0; tileZ < sizeZ; tileZ += TILE_WIDTH) {
+            threadPool.submit([=]() {
+                unsigned int endZ = std::min(tileZ + TILE_WIDTH, sizeZ);
+                for(unsigned int tileY = 0; tileY < sizeY; tileY += TILE_WIDTH) {
+                    unsigned int endY = std::min(tileY + TILE_WIDTH, sizeY);
+                    for(unsigned int y = tileY; y < endY; ++y) {
+                        for(unsigned int z = tileZ; z < endZ; ++z) {
+                            std::memcpy(destination + y * rowSize + z * destinationLayerSize, source + z * rowSize + y * sourceLayerSize, rowSize);
+                        }
+                    }
+                }
+            });
         }
+        threadPool.wait();
+    }
 
+    float* parseXRAWPalette(const uint8_t* paletteBuffer, const XRAWHeader& header) {
         float* paletteData = new float[256 * 3];
-        unsigned int paletteStartIndex = sizeof(Header) + voxelDataSize;
         unsigned int usedColorChannels = std::min((int)header.numOfColorChannels, 3);
         unsigned int bytesPerChannels = header.bitsPerChannel / 8;
-        for(unsigned int colorIndex = 0; colorIndex < 256; ++colorIndex) {
+
+        // The common 8 bit RGBA palette converts one color per SSE2 instruction. Every store writes four floats, the fourth is overwritten
+        //  by the next color, so the last color is left to the loop below.
+        unsigned int firstColorIndex = 0;
+        if(header.colorChannelDataType == 0 && bytesPerChannels == 1 && header.numOfColorChannels == 4) {
+            const __m128 scale = _mm_set1_ps(255.0f);
+            const __m128i zero = _mm_setzero_si128();
+            for(; firstColorIndex < 255; ++firstColorIndex) {
+                int32_t color;
+                std::memcpy(&color, paletteBuffer + firstColorIndex * 4, 4);
+                __m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(color), zero), zero);
+                _mm_storeu_ps(paletteData + firstColorIndex * 3, _mm_div_ps(_mm_cvtepi32_ps(channels), scale));
+            }
+        }
+
+        for(unsigned int colorIndex = firstColorIndex; colorIndex < 256; ++colorIndex) {
             for(unsigned int channelIndex = 0; channelIndex < usedColorChannels; ++channelIndex) {
-                uint8_t* sourcePtr = fileBuffer + paletteStartIndex + (colorIndex * header.numOfColorChannels + channelIndex) * bytesPerChannels;
+                const uint8_t* sourcePtr = paletteBuffer + (colorIndex * header.numOfColorChannels + channelIndex) * bytesPerChannels;
                 unsigned int destIndex = colorIndex * 3 + channelIndex;
 
                 float res = 0;
                 switch(header.colorChannelDataType) {
                 case 0: // Unsigned integer
                     switch(bytesPerChannels) {
-                    case 1: res = *((uint8_t*)sourcePtr) / 255.0; break;
-                    case 2: res = *((uint16_t*)sourcePtr) / 255.0; break;
-                    case 4: res = *((uint32_t*)sourcePtr) / 255.0; break;
+                    case 1: res = *((const uint8_t*)sourcePtr) / 255.0; break;
+                    case 2: res = *((const uint16_t*)sourcePtr) / 255.0; break;
+                    case 4: res = *((const uint32_t*)sourcePtr) / 255.0; break;
                     }
                     break;
                 case 1: // Signed integer
                     switch(bytesPerChannels) {
-                    case 1: res = *((int8_t*)sourcePtr) / 255.0; break;
-                    case 2: res = *((int16_t*)sourcePtr) / 255.0; break;
-                    case 4: res = *((int32_t*)sourcePtr) / 255.0; break;
+                    case 1: res = *((const int8_t*)sourcePtr) / 255.0; break;
+                    case 2: res = *((const int16_t*)sourcePtr) / 255.0; break;
+                    case 4: res = *((const int32_t*)sourcePtr) / 255.0; break;
                     }
                     break;
                 case 3: // Float
-                    if(bytesPerChannels == 4) res = *((float*)sourcePtr);
+                    if(bytesPerChannels == 4) res = *((const float*)sourcePtr);
                     break;
                 }
 
                 paletteData[destIndex] = res;
             }
         }
-        
 
-        return {voxelDataBuffer, header.x, header.y, header.z, paletteData};
+        return paletteData;
+    }
+
+    VoxelStream openVoxelStream(const char* filename, VoxelDataAxis axis) {
+        VoxelStream stream;
+        stream.axis = axis;
+        stream.sizeX = stream.sizeY = stream.sizeZ = 0;
+        stream.voxelDataOffset = sizeof(XRAWHeader);
+        stream.paletteData = nullptr;
+
+        stream.file.open(filename, std::ios::binary | std::ios::in | std::ios::ate);
+        if(!stream.file.is_open()) {
+            std::cout << "Could not open file " << filename << std::endl;
+            return stream;
+        }
+        size_t fileSize = stream.file.tellg();
+        stream.file.seekg(0, std::ios::beg);
+
+        XRAWHeader header;
+        if(fileSize < sizeof(XRAWHeader) || !stream.file.read((char*)&header, sizeof(XRAWHeader)) || std::memcmp(&header.XRAW, "XRAW", 4) != 0) {
+            std::cout << "unsuported file type" << std::endl;
+            return stream;
+        }
+        if(header.numOfPaletteColors != 256) {
+            std::cout << "ERROR: Number of palette colors must be 256" << std::endl;
+            return stream;
+        }
+        if(header.bitsPerIndex != 8) {
+            std::cout << "ERROR: Only 8 bit voxel indices can be streamed" << std::endl;
+            return stream;
+        }
+
+        size_t voxelDataSize = (size_t)header.x * header.y * header.z;
+        size_t paletteDataSize = header.numOfColorChannels * (header.bitsPerChannel / 8) * header.numOfPaletteColors;
+        if(fileSize < sizeof(XRAWHeader) + voxelDataSize + paletteDataSize) {
+            std::cout << "ERROR: File too small" << std::endl;
+            return stream;
+        }
+
+        // The palette is stored after the voxels
+        std::vector<uint8_t> paletteBuffer(paletteDataSize);
+        stream.file.seekg(sizeof(XRAWHeader) + voxelDataSize, std::ios::beg);
+        stream.file.read((char*)paletteBuffer.data(), paletteDataSize);
+        stream.paletteData = parseXRAWPalette(paletteBuffer.data(), header);
+
+        stream.sizeX = header.x;
+        stream.sizeY = header.y;
+        stream.sizeZ = header.z;
+        return stream;
+    }
+
+    bool readVoxelSlab(VoxelStream& stream, unsigned int startZ, unsigned int depth, uint8_t* destination) {
+        size_t layerSize = (size_t)stream.sizeX * stream.sizeY;
+
+        if(stream.axis == VoxelDataAxis::Z_Up) {
+            // The file stores the layers along y, so every layer in the file holds one row of every z layer in the slab
+            std::vector<uint8_t> rows((size_t)depth * stream.sizeX);
+            for(unsigned int y = 0; y < stream.sizeY; ++y) {
+                size_t srcIndex = stream.voxelDataOffset + (size_t)startZ * stream.sizeX + (size_t)y * stream.sizeX * stream.sizeZ;
+                stream.file.seekg(srcIndex, std::ios::beg);
+                if(!stream.file.read((char*)rows.data(), rows.size())) return false;
+
+                for(unsigned int z = 0; z < depth; ++z) {
+                    std::memcpy(destination + (size_t)y * stream.sizeX + z * layerSize, rows.data() + (size_t)z * stream.sizeX, stream.sizeX);
+                }
+            }
+            return true;
+        }
+
+        stream.file.seekg(stream.voxelDataOffset + startZ * layerSize, std::ios::beg);
+        return (bool)stream.file.read((char*)destination, depth * layerSize);
     }
 
 }
\ No newline at end of file
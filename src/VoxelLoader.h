@@ -1,5 +1,7 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
+#include <fstream>
 
 enum class VoxelDataAxis {
     Y_Up, Z_Up
@@ -11,8 +13,28 @@ struct VoxelData {
     float* paletteData;
 };
 
+// A voxel file that is read one slab of z layers at a time, so that the whole world never has to be in memory. The palette is loaded when
+//  the stream is opened.
+struct VoxelStream {
+    std::ifstream file;
+    VoxelDataAxis axis;
+    unsigned int sizeX, sizeY, sizeZ;
+    size_t voxelDataOffset;
+    float* paletteData;
+};
+
 namespace VoxelLoader {
 
-    VoxelData loadVoxelData(const char* filename, VoxelDataAxis axis = VoxelDataAxis::Y_Up);
+    // The file is memory mapped, and Z_Up worlds are transposed by 'threadCount' threads (0 uses one per hardware thread)
+    VoxelData loadVoxelData(const char* filename, VoxelDataAxis axis = VoxelDataAxis::Y_Up, unsigned int threadCount = 0);
+    // Parses an XRAW file that is already in memory, the returned voxelData is nullptr if it is not a valid file
+    VoxelData parseXRAWFile(const uint8_t* fileBuffer, size_t fileSize, VoxelDataAxis axis, unsigned int threadCount = 0);
+    // Swaps the y and z axes of voxel data that is stored as rows of 'rowSize' bytes, with 'sizeY' layers of 'sizeZ' rows in the source
+    void transposeZUp(const uint8_t* source, uint8_t* destination, size_t rowSize, unsigned int sizeY, unsigned int sizeZ, unsigned int threadCount = 0);
+
+    // The returned paletteData is nullptr if the file could not be opened or is not an XRAW file with 8 bit voxels
+    VoxelStream openVoxelStream(const char* filename, VoxelDataAxis axis = VoxelDataAxis::Y_Up);
+    // Reads the z layers [startZ, startZ + depth) into 'destination', indexed as x + y * sizeX + (z - startZ) * sizeX * sizeY
+    bool readVoxelSlab(VoxelStream& stream, unsigned int startZ, unsigned int depth, uint8_t* destination);
 
 }
\ No newline at end of file
@@ -8,22 +8,79 @@
 #include <cstring>
 #include <chrono>
 #include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
 
 #include "VertexBuffer.h"
 #include "ElementBuffer.h"
 #include "VertexArray.h"
 #include "ShaderStorageBuffer.h"
+#include "UniformBuffer.h"
+#include "FrameData.h"
 #include "Shader.h"
 #include "Framebuffer.h"
 #include "Texture.h"
 #include "VoxelLoader.h"
 #include "Octree.h"
+#include "OctreeCache.h"
+#include "GpuTimer.h"
+#include "GpuTimerLog.h"
+#include "CameraPath.h"
 
 #ifdef VOXEL_RENDERER_DEBUG
     #include "Debug.h"
 #endif
 
-int main(void) {
+int main(int argc, char** argv) {
+    // In benchmark mode the camera follows a camera path instead of the input, a fixed number of frames are rendered to a hidden window
+    //  and the frame times and the last frame are written to the output directory
+    const char* cameraPathFilename = nullptr;
+    unsigned int benchmarkFrameCount = 600;
+    const char* benchmarkOutputDirectory = "benchmark";
+    // The GPU time of every pass in every frame is streamed to this file, the benchmark mode writes it to the output directory
+    std::string passTimesFilename = "passTimes.csv";
+    glm::ivec2 windowSize(1280, 720);
+    int aoResolutionScale = 1;
+    // With dynamic resolution the g buffer, ambient occlusion and lighting passes render at a resolution that keeps the GPU time of a frame
+    //  within the target, see renderScale
+    bool enableDynamicResolution = false;
+    float targetFrameTime = 16.0f;
+    // Packs the g buffer into a distance, face and palette index per pixel, see gBuffer.glsl
+    bool useVisibilityBuffer = false;
+
+    for(int i = 1; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc) cameraPathFilename = argv[++i];
+        else if(std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) benchmarkFrameCount = std::max(std::atoi(argv[++i]), 1);
+        else if(std::strcmp(argv[i], "--resolution") == 0 && i + 2 < argc) {
+            windowSize.x = std::max(std::atoi(argv[++i]), 1);
+            windowSize.y = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if(std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) benchmarkOutputDirectory = argv[++i];
+        else if(std::strcmp(argv[i], "--pass-times") == 0 && i + 1 < argc) passTimesFilename = argv[++i];
+        else if(std::strcmp(argv[i], "--ao-scale") == 0 && i + 1 < argc) aoResolutionScale = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--visibility-buffer") == 0) useVisibilityBuffer = true;
+        else if(std::strcmp(argv[i], "--target-frame-time") == 0 && i + 1 < argc) {
+            enableDynamicResolution = true;
+            targetFrameTime = std::max((float)std::atof(argv[++i]), 0.1f);
+        }
+        else {
+            std::cout << "Usage: VoxelRenderer [--benchmark <camera path>] [--frames N] [--resolution WIDTH HEIGHT] [--output DIR] [--pass-times FILE] [--ao-scale 1|2|4] [--target-frame-time MS] [--visibility-buffer]" << std::endl;
+            return -1;
+        }
+    }
+
+    if(aoResolutionScale != 1 && aoResolutionScale != 2 && aoResolutionScale != 4) {
+        std::cout << "ERROR: The ambient occlusion scale must be 1, 2 or 4" << std::endl;
+        return -1;
+    }
+
+    bool benchmarkMode = cameraPathFilename != nullptr;
+    CameraPath cameraPath;
+    if(benchmarkMode && !cameraPath.loadFromFile(cameraPathFilename)) {
+        return -1;
+    }
+
     GLFWwindow* window;
 
     if (!glfwInit()) {
@@ -34,7 +91,8 @@ int main(void) {
     enableDebugging();
     #endif
 
-    glm::ivec2 windowSize(1280, 720);
+    // The hidden window only provides the context, it works with Mesa's software renderer on a virtual display such as Xvfb
+    if(benchmarkMode) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     window = glfwCreateWindow(windowSize.x, windowSize.y, "Voxel Renderer", NULL, NULL);
     if (!window) {
         glfwTerminate();
@@ -43,8 +101,8 @@ int main(void) {
 
     glfwMakeContextCurrent(window);
 
-    bool cursorHidden = true;
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    bool cursorHidden = !benchmarkMode;
+    if(cursorHidden) glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     if(glewInit() != GLEW_OK) {
         return -1;
@@ -61,22 +119,30 @@ int main(void) {
     initializeDebugger();
     #endif
 
-    VoxelData voxelData = VoxelLoader::loadVoxelData("assets/world.xraw", VoxelDataAxis::Z_Up);
-    uint8_t* world = voxelData.voxelData;
-    glm::vec3* palette = (glm::vec3*)voxelData.paletteData;
-
-    if(voxelData.voxelData == nullptr) {
-        return -1;
-    }
-    if(voxelData.sizeX != voxelData.sizeY || voxelData.sizeX != voxelData.sizeZ) {
-        std::cout << "ERROR: world sides must have the same length" << std::endl;
-        return -1;
+    const char* worldFilename = "assets/world.xraw";
+    const char* octreeCacheFilename = "assets/world.voct";
+    unsigned int maxOctreeDepth = 5;
+    bool convertOctreeToDAG = false;
+    size_t slabMemoryBudget = 256 * 1024 * 1024;
+
+    // The octree is only built when the cache file was not built from the current world file or with other settings. The cache can also be
+    //  built offline with the OctreeConverter project.
+    uint64_t worldHash = OctreeCache::hashFile(worldFilename);
+    OctreeCacheData octree = OctreeCache::loadOctreeCache(octreeCacheFilename, worldHash);
+    if(octree.nodes == nullptr || octree.maxDepth != maxOctreeDepth || octree.isDAG != convertOctreeToDAG) {
+        OctreeCache::unloadOctreeCache(octree);
+        if(!OctreeCache::buildOctreeCache(worldFilename, VoxelDataAxis::Z_Up, octreeCacheFilename, maxOctreeDepth, convertOctreeToDAG, slabMemoryBudget)) {
+            return -1;
+        }
+        octree = OctreeCache::loadOctreeCache(octreeCacheFilename, worldHash);
+        if(octree.nodes == nullptr) {
+            std::cout << "ERROR: Could not load octree cache " << octreeCacheFilename << std::endl;
+            return -1;
+        }
     }
+    const glm::vec3* palette = (const glm::vec3*)octree.paletteData;
 
-    Octree octree(world, voxelData.sizeX, 5);
-
-    delete[] world;
-    std::cout << octree.chunkData.size() << ", " << octree.nodes.size() << " : " << octree.chunkData.size() + octree.nodes.size() * sizeof(OctreeNode) << std::endl;
+    std::cout << octree.chunkDataSize << ", " << octree.nodeCount << " : " << octree.chunkDataSize + octree.nodeCount * sizeof(OctreeNode) << std::endl;
 
     float verticies[6 * 3] {
         -1.0, -1.0,  0.0,
@@ -101,42 +167,99 @@ int main(void) {
     vao.unbind();
 
     ShaderStorageBuffer octreeNodesSSB(0);
-    octreeNodesSSB.setData(octree.nodes.data(), octree.nodes.size() * sizeof(OctreeNode), BufferDataUsage::DYNAMIC_COPY);
+    octreeNodesSSB.setData(octree.nodes, octree.nodeCount * sizeof(OctreeNode), BufferDataUsage::DYNAMIC_COPY);
 
     ShaderStorageBuffer chunkDataSSB(1);
-    chunkDataSSB.setData(octree.chunkData.data(), octree.chunkData.size() * sizeof(uint8_t), BufferDataUsage::DYNAMIC_COPY);
+    chunkDataSSB.setData(octree.chunkData, octree.chunkDataSize * sizeof(uint8_t), BufferDataUsage::DYNAMIC_COPY);
+
+    // The ropes let the traversal step to the next node without descending from the root. They can not be built for a DAG or for octrees
+    //  with more nodes than a rope can index, and the traversal descends from the root when there are none.
+    std::vector<uint32_t> octreeRopes;
+    if(!octree.isDAG) octreeRopes = Octree::buildRopes(octree.nodes, octree.nodeCount);
+    ShaderStorageBuffer octreeRopesSSB(2);
+    octreeRopesSSB.setData(octreeRopes.data(), octreeRopes.size() * sizeof(uint32_t), BufferDataUsage::DYNAMIC_COPY);
+
+    // The per-frame constants are written to their own partition every frame, so updating them never waits for the previous frames
+    UniformBuffer frameDataUB(FRAME_DATA_BINDING);
+    frameDataUB.setPersistentStorage(sizeof(FrameData));
+    FrameData frameData = {};
+
+    // The octree is copied out of the cache mapping the first time it is edited. Edits only upload the byte ranges that changed, and the
+    //  buffers are given room to grow so that edits which add nodes or chunks rarely have to reallocate them.
+    std::unique_ptr<Octree> editableOctree;
+    auto uploadOctreeRanges = [](ShaderStorageBuffer& buffer, const void* data, size_t dataSize, const std::vector<OctreeDirtyRange>& dirtyRanges) {
+        if(dataSize > buffer.getDataSize()) {
+            buffer.setData(nullptr, dataSize + dataSize / 4, BufferDataUsage::DYNAMIC_COPY);
+            buffer.updateRange(data, 0, dataSize);
+            return dataSize;
+        }
 
+        size_t uploadSize = 0;
+        for(const OctreeDirtyRange& range : dirtyRanges) {
+            buffer.updateRange((const uint8_t*)data + range.offset, range.offset, range.size);
+            uploadSize += range.size;
+        }
+        return uploadSize;
+    };
+
+    // The g buffer textures have four channels since images with three channels can not be written by the compute shader
     Framebuffer gBuffer;
     gBuffer.bind();
 
     std::shared_ptr<Texture> albedoTexture = std::make_shared<Texture>(TextureType::TEXTURE_2D);
-    albedoTexture->textureImage2D(TextureFormat::RGB16F, windowSize.x, windowSize.y, (float*)NULL);
+    albedoTexture->textureImage2D(TextureFormat::RGBA16F, windowSize.x, windowSize.y, (float*)NULL);
     albedoTexture->setFilterMode(TextureFilterMode::NEAREST);
 
     std::shared_ptr<Texture> normalTexture0 = std::make_shared<Texture>(TextureType::TEXTURE_2D);
-    normalTexture0->textureImage2D(TextureFormat::RGB16F, windowSize.x, windowSize.y, (float*)NULL);
+    normalTexture0->textureImage2D(TextureFormat::RGBA16F, windowSize.x, windowSize.y, (float*)NULL);
     normalTexture0->setFilterMode(TextureFilterMode::NEAREST);
     std::shared_ptr<Texture> normalTexture1 = std::make_shared<Texture>(TextureType::TEXTURE_2D);
-    normalTexture1->textureImage2D(TextureFormat::RGB16F, windowSize.x, windowSize.y, (float*)NULL);
+    normalTexture1->textureImage2D(TextureFormat::RGBA16F, windowSize.x, windowSize.y, (float*)NULL);
     normalTexture1->setFilterMode(TextureFilterMode::NEAREST);
     std::weak_ptr<Texture> normalTexture = normalTexture0;
     std::weak_ptr<Texture> prevNormalTexture = normalTexture1;
 
     std::shared_ptr<Texture> posTexture0 = std::make_shared<Texture>(TextureType::TEXTURE_2D);
-    posTexture0->textureImage2D(TextureFormat::RGB32F, windowSize.x, windowSize.y, (float*)NULL);
+    posTexture0->textureImage2D(TextureFormat::RGBA32F, windowSize.x, windowSize.y, (float*)NULL);
     posTexture0->setFilterMode(TextureFilterMode::NEAREST);
     std::shared_ptr<Texture> posTexture1 = std::make_shared<Texture>(TextureType::TEXTURE_2D);
-    posTexture1->textureImage2D(TextureFormat::RGB32F, windowSize.x, windowSize.y, (float*)NULL);
+    posTexture1->textureImage2D(TextureFormat::RGBA32F, windowSize.x, windowSize.y, (float*)NULL);
     posTexture1->setFilterMode(TextureFilterMode::NEAREST);
     std::weak_ptr<Texture> posTexture = posTexture0;
     std::weak_ptr<Texture> prevPosTexture = posTexture1;
 
+    // The compact g buffer, used instead of the three textures above when useVisibilityBuffer is set. The distance to the hit is in the red
+    //  channel and the palette index and face in the green channel.
+    std::shared_ptr<Texture> visibilityTexture0 = std::make_shared<Texture>(TextureType::TEXTURE_2D);
+    visibilityTexture0->textureImage2D(TextureFormat::RG32UI, windowSize.x, windowSize.y, (unsigned int*)NULL);
+    visibilityTexture0->setFilterMode(TextureFilterMode::NEAREST);
+    std::shared_ptr<Texture> visibilityTexture1 = std::make_shared<Texture>(TextureType::TEXTURE_2D);
+    visibilityTexture1->textureImage2D(TextureFormat::RG32UI, windowSize.x, windowSize.y, (unsigned int*)NULL);
+    visibilityTexture1->setFilterMode(TextureFilterMode::NEAREST);
+    std::weak_ptr<Texture> visibilityTexture = visibilityTexture0;
+    std::weak_ptr<Texture> prevVisibilityTexture = visibilityTexture1;
+
     gBuffer.attachTexture(albedoTexture.get(), 0);
     gBuffer.attachTexture(normalTexture.lock().get(), 1);
     gBuffer.attachTexture(posTexture.lock().get(), 2);
+    gBuffer.attachTexture(visibilityTexture.lock().get(), 3);
 
     gBuffer.unbind();
 
+    // One texel per DEPTH_PREPASS_TILE_WIDTH x DEPTH_PREPASS_TILE_WIDTH tile, see octreeTraversal.glsl
+    const unsigned int depthPrepassTileWidth = 8;
+    std::shared_ptr<Texture> depthPrepassTexture = std::make_shared<Texture>(TextureType::TEXTURE_2D);
+    depthPrepassTexture->textureImage2D(TextureFormat::R32F, (windowSize.x + depthPrepassTileWidth - 1) / depthPrepassTileWidth, (windowSize.y + depthPrepassTileWidth - 1) / depthPrepassTileWidth, (float*)NULL);
+    depthPrepassTexture->setFilterMode(TextureFilterMode::NEAREST);
+
+    // Distances from the camera to the hits of the previous frame, scattered into the pixels they are seen in this frame
+    Framebuffer reprojectionFramebuffer;
+    std::shared_ptr<Texture> reprojectedDistanceTexture = std::make_shared<Texture>(TextureType::TEXTURE_2D);
+    reprojectedDistanceTexture->textureImage2D(TextureFormat::R32UI, windowSize.x, windowSize.y, (unsigned int*)NULL);
+    reprojectedDistanceTexture->setFilterMode(TextureFilterMode::NEAREST);
+    reprojectionFramebuffer.attachTexture(reprojectedDistanceTexture.get(), 0);
+    reprojectionFramebuffer.unbind();
+
     Framebuffer lightingFrameBuffer;
     lightingFrameBuffer.bind();
 
@@ -149,6 +272,11 @@ int main(void) {
     std::weak_ptr<Texture> frameTexture = frameTexture0;
     std::weak_ptr<Texture> prevFrameTexture = frameTexture1;
 
+    // Output of the lighting pass at the render resolution, the TAA pass upscales it into frameTexture
+    std::shared_ptr<Texture> lightingTexture = std::make_shared<Texture>(TextureType::TEXTURE_2D);
+    lightingTexture->textureImage2D(TextureFormat::RGBA16F, windowSize.x, windowSize.y, (float*)NULL);
+    lightingTexture->setFilterMode(TextureFilterMode::NEAREST);
+
     std::shared_ptr<Texture> blueNoiseTexture = std::make_shared<Texture>(TextureType::TEXTURE_2D);
     blueNoiseTexture->textureImage2D("assets/blueNoise.png", 3);
     blueNoiseTexture->setFilterMode(TextureFilterMode::NEAREST);
@@ -170,11 +298,38 @@ int main(void) {
     std::weak_ptr<Texture> denoisedFrameDst = denoisedFrame0;
     std::weak_ptr<Texture> denoisedFrameSrc = denoisedFrame1;
 
-    lightingFrameBuffer.attachTexture(frameTexture.lock().get(), 0);
+    lightingFrameBuffer.attachTexture(lightingTexture.get(), 0);
     lightingFrameBuffer.unbind();
 
+    // Ambient occlusion traced at a reduced resolution, only the bottom left 1 / aoResolutionScale of the render resolution is used. It is as
+    //  large as the window so that the resolution can be changed without reallocating it.
+    Framebuffer ambientOcclusionFramebuffer;
+    std::shared_ptr<Texture> ambientOcclusionTexture = std::make_shared<Texture>(TextureType::TEXTURE_2D);
+    ambientOcclusionTexture->textureImage2D(TextureFormat::R16F, windowSize.x, windowSize.y, (float*)NULL);
+    ambientOcclusionTexture->setFilterMode(TextureFilterMode::NEAREST);
+    ambientOcclusionFramebuffer.attachTexture(ambientOcclusionTexture.get(), 0);
+    ambientOcclusionFramebuffer.unbind();
+
+    // The default framebuffer of a hidden window may not keep its pixels, so in benchmark mode the final frame is rendered to a texture
+    Framebuffer outputFramebuffer;
+    std::shared_ptr<Texture> outputTexture = std::make_shared<Texture>(TextureType::TEXTURE_2D);
+    if(benchmarkMode) {
+        outputTexture->textureImage2D(TextureFormat::RGBA8, windowSize.x, windowSize.y, (unsigned char*)NULL);
+        outputTexture->setFilterMode(TextureFilterMode::NEAREST);
+        outputFramebuffer.attachTexture(outputTexture.get(), 0);
+    }
+    outputFramebuffer.unbind();
+
     Shader gBufferShader("shader.glsl");
     if(!gBufferShader.compiledSuccessfully()) return -1;
+    Shader gBufferComputeShader("gBufferComputeShader.glsl");
+    if(!gBufferComputeShader.compiledSuccessfully()) return -1;
+    Shader depthPrepassShader("depthPrepassShader.glsl");
+    if(!depthPrepassShader.compiledSuccessfully()) return -1;
+    Shader reprojectionShader("reprojectionShader.glsl");
+    if(!reprojectionShader.compiledSuccessfully()) return -1;
+    Shader ambientOcclusionShader("ambientOcclusionShader.glsl");
+    if(!ambientOcclusionShader.compiledSuccessfully()) return -1;
     Shader lightingShader("lightingShader.glsl");
     if(!lightingShader.compiledSuccessfully()) return -1;
     Shader taaShader("taaShader.glsl");
@@ -188,9 +343,28 @@ int main(void) {
     gBufferShader.setUniform1ui("u_worldWidth", octree.worldWidth);
     gBufferShader.setUniform1ui("u_maxOctreeDepth", octree.maxDepth);
     gBufferShader.setUniform1ui("u_chunkWidth", octree.worldWidth / std::pow(2, octree.maxDepth));
-    gBufferShader.setUniform3fv("u_palette", 256, (float*)palette);
-    gBufferShader.setUniform2i("u_windowSize", windowSize.x, windowSize.y);
-    gBufferShader.setUniform1f("u_fov", 1.0);
+    gBufferShader.setUniform3fv("u_palette", 256, (const float*)palette);
+    gBufferShader.setTexture(depthPrepassTexture, 0, "u_depthPrepass");
+    gBufferShader.setTexture(reprojectedDistanceTexture, 1, "u_reprojectedDistance");
+
+    gBufferComputeShader.useShader();
+    gBufferComputeShader.setUniform1ui("u_worldWidth", octree.worldWidth);
+    gBufferComputeShader.setUniform1ui("u_maxOctreeDepth", octree.maxDepth);
+    gBufferComputeShader.setUniform1ui("u_chunkWidth", octree.worldWidth / std::pow(2, octree.maxDepth));
+    gBufferComputeShader.setUniform3fv("u_palette", 256, (const float*)palette);
+    gBufferComputeShader.setTexture(depthPrepassTexture, 0, "u_depthPrepass");
+    gBufferComputeShader.setTexture(reprojectedDistanceTexture, 1, "u_reprojectedDistance");
+
+    depthPrepassShader.useShader();
+    depthPrepassShader.setUniform1ui("u_worldWidth", octree.worldWidth);
+    depthPrepassShader.setUniform1ui("u_maxOctreeDepth", octree.maxDepth);
+    depthPrepassShader.setUniform1ui("u_chunkWidth", octree.worldWidth / std::pow(2, octree.maxDepth));
+
+    reprojectionShader.useShader();
+    reprojectionShader.setTexture(prevNormalTexture, 0, "u_prevNormalTexture");
+    reprojectionShader.setTexture(prevPosTexture, 1, "u_prevPosTexture");
+    reprojectionShader.setTexture(prevVisibilityTexture, 2, "u_prevVisibilityTexture");
+    reprojectionShader.setUniform3fv("u_palette", 256, (const float*)palette);
 
     lightingShader.useShader();
     lightingShader.setUniform1ui("u_worldWidth", octree.worldWidth);
@@ -200,13 +374,48 @@ int main(void) {
     lightingShader.setTexture(albedoTexture, 0, "u_gAlbedo");
     lightingShader.setTexture(normalTexture, 1, "u_gNormal");
     lightingShader.setTexture(posTexture, 2, "u_gPos");
+    lightingShader.setTexture(ambientOcclusionTexture, 3, "u_ambientOcclusion");
+    lightingShader.setTexture(visibilityTexture, 4, "u_gVisibility");
     lightingShader.setTexture(blueNoiseTexture, 8, "u_blueNoiseTexture");
 
+    ambientOcclusionShader.useShader();
+    ambientOcclusionShader.setUniform1ui("u_worldWidth", octree.worldWidth);
+    ambientOcclusionShader.setUniform1ui("u_maxOctreeDepth", octree.maxDepth);
+    ambientOcclusionShader.setUniform1ui("u_chunkWidth", octree.worldWidth / std::pow(2, octree.maxDepth));
+    ambientOcclusionShader.setTexture(albedoTexture, 0, "u_gAlbedo");
+    ambientOcclusionShader.setTexture(normalTexture, 1, "u_gNormal");
+    ambientOcclusionShader.setTexture(posTexture, 2, "u_gPos");
+    ambientOcclusionShader.setTexture(visibilityTexture, 4, "u_gVisibility");
+    ambientOcclusionShader.setTexture(blueNoiseTexture, 8, "u_blueNoiseTexture");
+
     postProcessShader.useShader();
     postProcessShader.setTexture(frameTexture, 0, "u_frameTexture");
     postProcessShader.setTexture(albedoTexture, 1, "u_gAlbedo");
     postProcessShader.setTexture(normalTexture, 2, "u_gNormal");
     postProcessShader.setTexture(posTexture, 3, "u_gPos");
+    postProcessShader.setTexture(visibilityTexture, 4, "u_gVisibility");
+    postProcessShader.setUniform3fv("u_palette", 256, (const float*)palette);
+    int postProcessOutputImageLocation = postProcessShader.getUniformLocation("u_outputImage");
+
+    taaShader.useShader();
+    taaShader.setTexture(lightingTexture, 0, "u_frameTexture");
+    taaShader.setTexture(normalTexture, 1, "u_normalTexture");
+    taaShader.setTexture(posTexture, 2, "u_posTexture");
+    taaShader.setTexture(prevFrameTexture, 4, "u_prevFrameTexture");
+    taaShader.setTexture(prevNormalTexture, 5, "u_prevNormalTexture");
+    taaShader.setTexture(prevPosTexture, 6, "u_prevPosTexture");
+    taaShader.setTexture(visibilityTexture, 3, "u_visibilityTexture");
+    taaShader.setTexture(prevVisibilityTexture, 7, "u_prevVisibilityTexture");
+    taaShader.setUniform3fv("u_palette", 256, (const float*)palette);
+
+    denoisingShader.useShader();
+    denoisingShader.setTexture(frameTexture, 0, "u_frameTexture");
+    denoisingShader.setTexture(albedoTexture, 1, "u_albedoTexture");
+    denoisingShader.setTexture(normalTexture, 2, "u_normalTexture");
+    denoisingShader.setTexture(posTexture, 3, "u_posTexture");
+    denoisingShader.setTexture(visibilityTexture, 4, "u_visibilityTexture");
+    denoisingShader.setUniform3fv("u_palette", 256, (const float*)palette);
+    int denoisingScaleLocation = denoisingShader.getUniformLocation("u_scale");
 
     glm::vec3 position = glm::vec3(0.0, 0.0, 0.0);
     glm::vec3 prevPosition = position;
@@ -226,6 +435,8 @@ int main(void) {
 
     int outputImageSelection = 0;
     float taaAlpha = 0.1;
+    // A TAA alpha of one makes the TAA pass ignore its history for a frame, for when the previous frame can not be blended with this one
+    bool taaHistoryValid = true;
     float taaDistWeightScaler = 0.1;
     float taaNormalWeightScaler = 0.02;
     float taaColorWeightScaler = 0.01;
@@ -237,7 +448,74 @@ int main(void) {
 
     int denoiseIterations = 3;
 
-    while (!glfwWindowShouldClose(window)) {
+    // Must match TILE_WIDTH in gBufferComputeShader.glsl
+    const unsigned int gBufferComputeTileWidth = 8;
+    bool useComputeGBuffer = false;
+    GpuTimer fragmentGBufferTimer;
+    GpuTimer computeGBufferTimer;
+
+    bool enableDepthPrepass = true;
+    GpuTimer depthPrepassTimer;
+
+    bool enableReprojection = false;
+    // False when the previous frame's hits can not be reprojected, since there was no previous frame or the octree was edited after it
+    bool reprojectionHistoryValid = false;
+    GpuTimer reprojectionTimer;
+
+    bool enableOctreeRopes = !octree.isDAG;
+
+    // aoResolutionScale 1 traces the ambient occlusion in the lighting shader, 2 and 4 trace it at half and quarter resolution and upsample
+    //  it there
+    GpuTimer ambientOcclusionTimer;
+
+    // Every texture is allocated at the window resolution and the passes before TAA only fill the bottom left renderSize of them, so the
+    //  resolution can change every frame without reallocating anything. The rays are jittered so that the TAA history gathers the detail
+    //  between the pixels of the render resolution.
+    float renderScale = 1.0f;
+    float minRenderScale = 0.5f;
+    glm::ivec2 renderSize = windowSize;
+    glm::ivec2 prevRenderSize = windowSize;
+    // Halton (2, 3) sequence
+    const glm::vec2 jitterOffsets[8] = {
+        {  0.0f,    -0.1667f }, { -0.25f,    0.1667f }, { 0.25f,  -0.3889f }, { -0.375f, -0.0556f },
+        {  0.125f,   0.2778f }, { -0.125f,  -0.2778f }, { 0.375f,  0.0556f }, { -0.4375f, 0.3889f }
+    };
+
+    GpuTimer lightingTimer;
+    GpuTimer taaTimer;
+    GpuTimer denoisingTimer;
+    GpuTimer postProcessTimer;
+    std::vector<std::pair<std::string, GpuTimer*>> passTimers = {
+        { "reprojection", &reprojectionTimer }, { "depthPrepass", &depthPrepassTimer }, { "gBufferFragment", &fragmentGBufferTimer },
+        { "gBufferCompute", &computeGBufferTimer }, { "ambientOcclusion", &ambientOcclusionTimer }, { "lighting", &lightingTimer }, { "taa", &taaTimer }, { "denoising", &denoisingTimer },
+        { "postProcess", &postProcessTimer }
+    };
+    GpuTimerLog passTimesLog(passTimers);
+
+    int editBoxMin[3] = { 0, 0, 0 };
+    int editBoxMax[3] = { 16, 16, 16 };
+    int editPaletteIndex = 1;
+    double editTime = 0.0;
+    size_t editUploadSize = 0;
+
+    // The frames are spread evenly over the camera path. Every frame waits for the GPU to finish it, so that each frame time covers all of
+    //  the work of that frame and nothing of the frames before it.
+    unsigned int benchmarkFrame = 0;
+    std::vector<double> benchmarkFrameTimes;
+    std::vector<float> benchmarkRenderScales;
+    if(benchmarkMode) {
+        CameraPathKeyframe keyframe = cameraPath.getKeyframe(cameraPath.getStartTime());
+        position = keyframe.position;
+        prevPosition = position;
+        cameraAngle = keyframe.angle;
+
+        std::filesystem::create_directories(benchmarkOutputDirectory);
+        passTimesLog.open((std::string(benchmarkOutputDirectory) + "/passTimes.csv").c_str());
+    }
+
+    while (!glfwWindowShouldClose(window) && !(benchmarkMode && benchmarkFrame == benchmarkFrameCount)) {
+        auto frameStart = std::chrono::high_resolution_clock::now();
+
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
@@ -249,7 +527,7 @@ int main(void) {
         timeAccumulator += d.count();
         if(timeAccumulator > 1000000000) {
             timeAccumulator -= 1000000000;
-            std::cout << "Fps: " << frameCounter << ", Frame time: " << 1.0 / frameCounter << std::endl;
+            std::cout << "Fps: " << frameCounter << ", Frame time: " << 1000.0 / frameCounter << " ms" << std::endl;
             frameCounter = 0;
         }
         deltaTime = d.count() / 1000000000.0;
@@ -261,99 +539,201 @@ int main(void) {
         glm::vec3 forwardVector = glm::vec3(sin(cameraAngle), 0.0, -cos(cameraAngle));
         glm::vec3 strafeVector = glm::cross(forwardVector, glm::vec3(0.0, 1.0, 0.0));
         prevPosition = position;
-        if(glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) movementSpeed *= 5;
-        if(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) position += movementSpeed * forwardVector;
-        if(glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) position -= movementSpeed * strafeVector;
-        if(glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) position -= movementSpeed * forwardVector;
-        if(glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) position += movementSpeed * strafeVector;
-        if(glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) position.y += movementSpeed;
-        if(glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS) position.y -= movementSpeed;
+        if(benchmarkMode) {
+            double pathTime = (benchmarkFrameCount > 1) ? cameraPath.getDuration() * benchmarkFrame / (benchmarkFrameCount - 1) : 0.0;
+            CameraPathKeyframe keyframe = cameraPath.getKeyframe(cameraPath.getStartTime() + pathTime);
+            position = keyframe.position;
+            cameraAngle = keyframe.angle;
+        }
+        else {
+            if(glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) movementSpeed *= 5;
+            if(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) position += movementSpeed * forwardVector;
+            if(glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) position -= movementSpeed * strafeVector;
+            if(glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) position -= movementSpeed * forwardVector;
+            if(glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) position += movementSpeed * strafeVector;
+            if(glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) position.y += movementSpeed;
+            if(glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS) position.y -= movementSpeed;
+        }
         
         prevCameraRotMatrix = cameraRotMatrix;
         cameraRotMatrix = glm::mat3(glm::rotate(glm::mat4(1.0), (float)-cameraAngle, glm::vec3(0.0, 1.0, 0.0)));
 
         glfwGetCursorPos(window, &xMousePos, &yMousePos);
 
-        if(glfwGetKey(window, GLFW_KEY_ESCAPE)) {
+        setFrameDataMatrix(frameData.cameraRotMatrix, cameraRotMatrix);
+        setFrameDataMatrix(frameData.prevCameraRotMatrix, prevCameraRotMatrix);
+        frameData.cameraPos = position;
+        frameData.fov = 1.0;
+        frameData.prevCameraPos = prevPosition;
+        frameData.frame = (float)frame;
+        if(!enableDynamicResolution) renderScale = 1.0f;
+        renderSize.x = std::max((int)std::lround(windowSize.x * renderScale), 1);
+        renderSize.y = std::max((int)std::lround(windowSize.y * renderScale), 1);
+        frameData.windowSize = glm::vec2((float)windowSize.x, (float)windowSize.y);
+        frameData.noiseTextureScale = glm::vec2((float)renderSize.x / (float)blueNoiseTexture->getWidth(), (float)renderSize.y / (float)blueNoiseTexture->getHeight());
+        frameData.renderSize = glm::vec2((float)renderSize.x, (float)renderSize.y);
+        frameData.prevRenderSize = glm::vec2((float)prevRenderSize.x, (float)prevRenderSize.y);
+        frameData.prevJitter = frameData.jitter;
+        frameData.jitter = enableDynamicResolution ? jitterOffsets[frame % 8] : glm::vec2(0.0f);
+        frameData.taaAlpha = taaHistoryValid ? taaAlpha : 1.0f;
+        taaHistoryValid = true;
+        frameData.taaDistWeightScaler = taaDistWeightScaler;
+        frameData.taaNormalWeightScaler = taaNormalWeightScaler;
+        frameData.taaColorWeightScaler = taaColorWeightScaler;
+        frameData.denoisingColorWeightScaler = denoisingColorWeightScaler;
+        frameData.denoisingNormalWeightScaler = denoisingNormalWeightScaler;
+        frameData.denoisingPosWeightScaler = denoisingPosWeightScaler;
+        frameData.depthPrepassEnabled = enableDepthPrepass ? 1 : 0;
+        frameData.reprojectionEnabled = (enableReprojection && reprojectionHistoryValid) ? 1 : 0;
+        reprojectionHistoryValid = true;
+        frameData.octreeRopesEnabled = (enableOctreeRopes && !octreeRopes.empty()) ? 1 : 0;
+        frameData.aoResolutionScale = aoResolutionScale;
+        frameData.visibilityBufferEnabled = useVisibilityBuffer ? 1 : 0;
+        frameDataUB.updateRange(&frameData, 0, sizeof(FrameData));
+
+        if(!benchmarkMode && glfwGetKey(window, GLFW_KEY_ESCAPE)) {
             if(cursorHidden) glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
             else glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
             cursorHidden = !cursorHidden;
         }
 
-        // Render g buffer
-        gBuffer.bind();
-        // glClear(GL_COLOR_BUFFER_BIT);
-        gBufferShader.useShader();
-        vao.bind();
+        // Reproject the hits of the previous frame, the g buffer starts its rays just in front of them
+        if(frameData.reprojectionEnabled) {
+            reprojectionTimer.begin(frame);
+            reprojectionFramebuffer.bind();
+            reprojectionFramebuffer.setDrawBuffers();
+            const unsigned int clearValue[4] = { 0xFFFFFFFF, 0, 0, 0 }; // NO_REPROJECTED_DISTANCE in octreeTraversal.glsl
+            glClearBufferuiv(GL_COLOR, 0, clearValue);
+
+            reprojectionShader.useShader();
+            reprojectionShader.setTexture(prevNormalTexture, 0);
+            reprojectionShader.setTexture(prevPosTexture, 1);
+            reprojectionShader.setTexture(prevVisibilityTexture, 2);
+            reprojectionShader.bindTextures();
+            reprojectedDistanceTexture->bindImage(0, TextureAccess::READ_WRITE);
+
+            glDispatchCompute((prevRenderSize.x + 7) / 8, (prevRenderSize.y + 7) / 8, 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+            reprojectionTimer.end();
+        }
 
-        gBufferShader.setUniform3f("u_cameraPos", position.x, position.y, position.z);
-        gBufferShader.setUniformMat3("u_cameraRotMatrix", cameraRotMatrix);
+        // Find where the primary rays of each tile can start
+        if(enableDepthPrepass) {
+            depthPrepassTimer.begin(frame);
+            depthPrepassShader.useShader();
+            depthPrepassTexture->bindImage(0, TextureAccess::WRITE_ONLY);
+
+            // The prepass has one invocation per tile in work groups of 8 x 8 tiles
+            unsigned int groupsX = ((renderSize.x + depthPrepassTileWidth - 1) / depthPrepassTileWidth + 7) / 8;
+            unsigned int groupsY = ((renderSize.y + depthPrepassTileWidth - 1) / depthPrepassTileWidth + 7) / 8;
+            glDispatchCompute(groupsX, groupsY, 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+            depthPrepassTimer.end();
+        }
 
-        gBuffer.attachTexture(normalTexture.lock().get(), 1);
-        gBuffer.attachTexture(posTexture.lock().get(), 2);
-        
-        gBuffer.setDrawBuffers();
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        // Render g buffer, the passes up to TAA are drawn with a viewport of the render resolution
+        vao.bind();
+        glViewport(0, 0, renderSize.x, renderSize.y);
+        if(useComputeGBuffer) {
+            computeGBufferTimer.begin(frame);
+            gBufferComputeShader.useShader();
+            gBufferComputeShader.bindTextures();
+            albedoTexture->bindImage(0, TextureAccess::WRITE_ONLY);
+            normalTexture.lock()->bindImage(1, TextureAccess::WRITE_ONLY);
+            posTexture.lock()->bindImage(2, TextureAccess::WRITE_ONLY);
+            visibilityTexture.lock()->bindImage(3, TextureAccess::WRITE_ONLY);
+
+            unsigned int tilesX = (renderSize.x + gBufferComputeTileWidth - 1) / gBufferComputeTileWidth;
+            unsigned int tilesY = (renderSize.y + gBufferComputeTileWidth - 1) / gBufferComputeTileWidth;
+            glDispatchCompute(tilesX, tilesY, 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+            computeGBufferTimer.end();
+        }
+        else {
+            fragmentGBufferTimer.begin(frame);
+            gBuffer.bind();
+            // glClear(GL_COLOR_BUFFER_BIT);
+            gBufferShader.useShader();
+            gBufferShader.bindTextures();
+
+            gBuffer.attachTexture(normalTexture.lock().get(), 1);
+            gBuffer.attachTexture(posTexture.lock().get(), 2);
+            gBuffer.attachTexture(visibilityTexture.lock().get(), 3);
+
+            // Only the textures of the g buffer in use are written
+            if(useVisibilityBuffer) gBuffer.setDrawBuffers({ 3 });
+            else gBuffer.setDrawBuffers({ 0, 1, 2 });
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            fragmentGBufferTimer.end();
+        }
         
+        // Ambient occlusion at a reduced resolution
+        if(aoResolutionScale > 1) {
+            ambientOcclusionTimer.begin(frame);
+            ambientOcclusionShader.useShader();
+            ambientOcclusionShader.setTexture(normalTexture, 1);
+            ambientOcclusionShader.setTexture(posTexture, 2);
+            ambientOcclusionShader.setTexture(visibilityTexture, 4);
+            ambientOcclusionShader.bindTextures();
+
+            ambientOcclusionFramebuffer.setDrawBuffers();
+            glViewport(0, 0, (renderSize.x + aoResolutionScale - 1) / aoResolutionScale, (renderSize.y + aoResolutionScale - 1) / aoResolutionScale);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            glViewport(0, 0, renderSize.x, renderSize.y);
+            ambientOcclusionTimer.end();
+        }
+
         // Lighting calculations
+        lightingTimer.begin(frame);
         lightingFrameBuffer.bind();
         lightingShader.useShader();
-        lightingShader.setUniform1f("u_frame", float(frame));
-        lightingShader.setUniform2f("u_noiseTextureScale", (float)windowSize.x / (float)blueNoiseTexture->getWidth(), (float)windowSize.y / (float)blueNoiseTexture->getHeight());
 
-        lightingFrameBuffer.attachTexture(frameTexture.lock().get(), 0);
-        lightingShader.setTexture(normalTexture, 1, "u_gNormal");
-        lightingShader.setTexture(posTexture, 2, "u_gPos");
+        lightingFrameBuffer.attachTexture(lightingTexture.get(), 0);
+        lightingShader.setTexture(normalTexture, 1);
+        lightingShader.setTexture(posTexture, 2);
+        lightingShader.setTexture(visibilityTexture, 4);
 
         lightingShader.bindTextures();
         
         lightingFrameBuffer.setDrawBuffers();
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        glViewport(0, 0, windowSize.x, windowSize.y);
+        lightingTimer.end();
+
+        // TAA, which also upscales the frame to the window resolution. With a TAA alpha of one it only upscales.
+        taaTimer.begin(frame);
+        taaShader.useShader();
+        taaShader.setTexture(normalTexture, 1);
+        taaShader.setTexture(posTexture, 2);
+        taaShader.setTexture(prevFrameTexture, 4);
+        taaShader.setTexture(prevNormalTexture, 5);
+        taaShader.setTexture(prevPosTexture, 6);
+        taaShader.setTexture(visibilityTexture, 3);
+        taaShader.setTexture(prevVisibilityTexture, 7);
+
+        taaShader.bindTextures();
 
-        // TAA
-        if(taaAlpha < 1.0) {
-            taaShader.useShader();
-            taaShader.setTexture(frameTexture, 0, "u_frameTexture");
-            taaShader.setTexture(normalTexture, 1, "u_normalTexture");
-            taaShader.setTexture(posTexture, 2, "u_posTexture");
-            taaShader.setTexture(prevFrameTexture, 4, "u_prevFrameTexture");
-            taaShader.setTexture(prevNormalTexture, 5, "u_prevNormalTexture");
-            taaShader.setTexture(prevPosTexture, 6, "u_prevPosTexture");
-
-            taaShader.setUniform3f("u_cameraPos", position.x, position.y, position.z);
-            taaShader.setUniform3f("u_prevCameraPos", prevPosition.x, prevPosition.y, prevPosition.z);
-            taaShader.setUniformMat3("u_prevCameraRotMatrix", prevCameraRotMatrix);
-            taaShader.setUniform2f("u_windowSize", (float)windowSize.x, (float)windowSize.y);
-            taaShader.setUniform1f("u_fov", 1.0);
-            taaShader.setUniform1f("u_taaAlpha", taaAlpha);
-            taaShader.setUniform1f("u_taaDistWeightScaler", taaDistWeightScaler);
-            taaShader.setUniform1f("u_taaNormalWeightScaler", taaNormalWeightScaler);
-            taaShader.setUniform1f("u_taaColorNormalScaler", taaColorWeightScaler);
-
-            taaShader.bindTextures();
-
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        }
+        lightingFrameBuffer.attachTexture(frameTexture.lock().get(), 0);
+        lightingFrameBuffer.setDrawBuffers();
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        taaTimer.end();
 
         std::weak_ptr<Texture> result = frameTexture;
 
         if(enableDenoising) {
+            denoisingTimer.begin(frame);
             denoisingShader.useShader();
-            denoisingShader.setUniform2f("u_windowSize", (float)windowSize.x, (float)windowSize.y);
-            denoisingShader.setUniform1f("u_colorWeightScaler", denoisingColorWeightScaler);
-            denoisingShader.setUniform1f("u_normalWeightScaler", denoisingNormalWeightScaler);
-            denoisingShader.setUniform1f("u_posWeightScaler", denoisingPosWeightScaler);
-            denoisingShader.setTexture(albedoTexture, 1, "u_albedoTexture");
-            denoisingShader.setTexture(normalTexture, 2, "u_normalTexture");
-            denoisingShader.setTexture(posTexture, 3, "u_posTexture");
+            denoisingShader.setTexture(normalTexture, 2);
+            denoisingShader.setTexture(posTexture, 3);
+            denoisingShader.setTexture(visibilityTexture, 4);
 
             for(int iteration = 0; iteration < denoiseIterations; ++iteration) {
                 std::swap(denoisedFrameSrc, denoisedFrameDst);
                 std::weak_ptr<Texture> srcTexture = (iteration == 0) ? frameTexture : denoisedFrameSrc;
 
-                denoisingShader.setUniform1f("u_scale", (float)(std::pow(2.0, iteration)));
+                denoisingShader.setUniform1f(denoisingScaleLocation, (float)(std::pow(2.0, iteration)));
 
-                denoisingShader.setTexture(srcTexture, 0, "u_frameTexture");
+                denoisingShader.setTexture(srcTexture, 0);
                 lightingFrameBuffer.attachTexture(denoisedFrameDst.lock().get(), 0);
 
                 denoisingShader.bindTextures();
@@ -361,24 +741,51 @@ int main(void) {
                 glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
             }
 
+            denoisingTimer.end();
             result = denoisedFrameDst;
         }
 
         // Render final frame
+        postProcessTimer.begin(frame);
         lightingFrameBuffer.unbind();
+        if(benchmarkMode) outputFramebuffer.setDrawBuffers();
         postProcessShader.useShader();
-        postProcessShader.setTexture(result, 0, "u_frameTexture");
-        postProcessShader.setTexture(normalTexture, 2, "u_gNormal");
+        postProcessShader.setTexture(result, 0);
+        postProcessShader.setTexture(normalTexture, 2);
+        postProcessShader.setTexture(posTexture, 3);
+        postProcessShader.setTexture(visibilityTexture, 4);
         postProcessShader.bindTextures();
-        postProcessShader.setUniform1i("u_frameTexture", outputImageSelection);
+        postProcessShader.setUniform1i(postProcessOutputImageLocation, outputImageSelection);
         
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        postProcessTimer.end();
 
         // Render GUI
         ImGui::RadioButton("Show final image", &outputImageSelection, 0);
         ImGui::RadioButton("Show albedo buffer", &outputImageSelection, 1);
         ImGui::RadioButton("Show normal buffer", &outputImageSelection, 2);
 
+        ImGui::Checkbox("Compute shader g buffer", &useComputeGBuffer);
+        // The previous frame's g buffer is in the other format for one frame, so it is neither reprojected nor blended by TAA
+        if(ImGui::Checkbox("Visibility buffer", &useVisibilityBuffer)) {
+            reprojectionHistoryValid = false;
+            taaHistoryValid = false;
+        }
+        ImGui::Checkbox("Depth prepass", &enableDepthPrepass);
+        ImGui::Checkbox("Temporal reprojection", &enableReprojection);
+        ImGui::Text("Ambient occlusion resolution");
+        ImGui::SameLine();
+        ImGui::RadioButton("Full", &aoResolutionScale, 1);
+        ImGui::SameLine();
+        ImGui::RadioButton("Half", &aoResolutionScale, 2);
+        ImGui::SameLine();
+        ImGui::RadioButton("Quarter", &aoResolutionScale, 4);
+        if(!octreeRopes.empty()) ImGui::Checkbox("Octree ropes", &enableOctreeRopes);
+        ImGui::Checkbox("Dynamic resolution", &enableDynamicResolution);
+        ImGui::SliderFloat("Target GPU frame time (ms)", &targetFrameTime, 1.0, 100.0);
+        ImGui::SliderFloat("Min render scale", &minRenderScale, 0.25, 1.0);
+        ImGui::Text("Render resolution: %dx%d (%.0f%%)", renderSize.x, renderSize.y, renderScale * 100.0f);
+
         ImGui::SliderFloat("TAA alpha", &taaAlpha, 0.0, 1.0, "%f");
         ImGui::SliderFloat("TAA dist weight scaler", &taaDistWeightScaler, 0.0, 1.0);
         ImGui::SliderFloat("TAA normal weight scaler", &taaNormalWeightScaler, 0.0, 1.0);
@@ -389,22 +796,128 @@ int main(void) {
         ImGui::Checkbox("Enable denoising", &enableDenoising);
         ImGui::SliderInt("Denoise iterations", &denoiseIterations, 0, 10);
 
+        ImGui::SliderInt3("Edit box min", editBoxMin, 0, octree.worldWidth);
+        ImGui::SliderInt3("Edit box max", editBoxMax, 0, octree.worldWidth);
+        ImGui::SliderInt("Edit palette index", &editPaletteIndex, 1, 255);
+        bool fillEditBox = ImGui::Button("Fill box");
+        ImGui::SameLine();
+        bool clearEditBox = ImGui::Button("Clear box");
+        if(fillEditBox || clearEditBox) {
+            if(!editableOctree) {
+                editableOctree = std::make_unique<Octree>(octree.nodes, octree.nodeCount, octree.chunkData, octree.chunkDataSize, octree.worldWidth, octree.maxDepth, octree.isDAG);
+            }
+
+            auto editStart = std::chrono::high_resolution_clock::now();
+            uint8_t paletteIndex = clearEditBox ? 0 : editPaletteIndex;
+            if(editableOctree->fillBox(editBoxMin[0], editBoxMin[1], editBoxMin[2], editBoxMax[0], editBoxMax[1], editBoxMax[2], paletteIndex)) {
+                editUploadSize = uploadOctreeRanges(octreeNodesSSB, editableOctree->nodes.data(), editableOctree->nodes.size() * sizeof(OctreeNode), editableOctree->takeDirtyNodeRanges());
+                editUploadSize += uploadOctreeRanges(chunkDataSSB, editableOctree->chunkData.data(), editableOctree->chunkData.size(), editableOctree->takeDirtyChunkDataRanges());
+
+                // Edits move nodes around, so the ropes of the nodes around the edit are updated
+                if(!octreeRopes.empty()) {
+                    std::vector<OctreeDirtyRange> dirtyRopeRanges = editableOctree->updateRopes(octreeRopes);
+                    editUploadSize += uploadOctreeRanges(octreeRopesSSB, octreeRopes.data(), octreeRopes.size() * sizeof(uint32_t), dirtyRopeRanges);
+                }
+                editTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - editStart).count();
+
+                // The hits of this frame do not show the edit
+                reprojectionHistoryValid = false;
+            }
+        }
+        ImGui::Text("Last edit: %.3f ms, %u bytes uploaded", editTime, (unsigned int)editUploadSize);
+
         if(ImGui::Button("Hide cursor")) {
             cursorHidden = true;
             glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
         }
 
+        // GPU time of each pass over the latest 256 frames it ran in
+        ImGui::Begin("GPU profiler");
+        ImGui::Text("%-16s %8s %8s %8s %8s", "Pass (ms)", "last", "min", "avg", "p99");
+        for(auto& passTimer : passTimers) {
+            GpuTimerStatistics statistics = passTimer.second->getStatistics();
+            ImGui::Text("%-16s %8.3f %8.3f %8.3f %8.3f", passTimer.first.c_str(), passTimer.second->getTime(), statistics.min, statistics.average, statistics.p99);
+        }
+        bool recordPassTimes = passTimesLog.isOpen();
+        if(ImGui::Checkbox("Record pass times to CSV", &recordPassTimes)) {
+            if(recordPassTimes) passTimesLog.open(passTimesFilename.c_str());
+            else passTimesLog.close();
+        }
+        ImGui::End();
+        passTimesLog.update(frame);
+
+        // The time of the passes at the render resolution grows with its number of pixels, while TAA, denoising and post processing run at the
+        //  window resolution whatever the scale is. Only the time left after those is shared by the scaled passes. The timers lag a few frames
+        //  behind, so the scale only moves part of the way to the one that would meet the target each frame.
+        if(enableDynamicResolution) {
+            double scaledTime = lightingTimer.getTime();
+            scaledTime += useComputeGBuffer ? computeGBufferTimer.getTime() : fragmentGBufferTimer.getTime();
+            if(frameData.reprojectionEnabled) scaledTime += reprojectionTimer.getTime();
+            if(enableDepthPrepass) scaledTime += depthPrepassTimer.getTime();
+            if(aoResolutionScale > 1) scaledTime += ambientOcclusionTimer.getTime();
+
+            double fixedTime = taaTimer.getTime() + postProcessTimer.getTime();
+            if(enableDenoising) fixedTime += denoisingTimer.getTime();
+
+            // When the fixed passes alone miss the target no render scale can meet it, so the scale falls to the minimum at once
+            if(fixedTime >= targetFrameTime) renderScale = minRenderScale;
+            else if(scaledTime > 0.0) {
+                float targetRenderScale = renderScale * (float)std::sqrt((targetFrameTime - fixedTime) / scaledTime);
+                renderScale += (std::clamp(targetRenderScale, minRenderScale, 1.0f) - renderScale) * 0.1f;
+            }
+        }
+        prevRenderSize = renderSize;
+
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        if(!benchmarkMode) ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        else {
+            outputFramebuffer.unbind();
+            glFinish();
+            benchmarkFrameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count());
+            benchmarkRenderScales.push_back((float)renderSize.x / (float)windowSize.x);
+            benchmarkFrame++;
+        }
+
+        frameDataUB.nextPartition();
 
         std::swap(frameTexture, prevFrameTexture);
         std::swap(normalTexture, prevNormalTexture);
         std::swap(posTexture, prevPosTexture);
+        std::swap(visibilityTexture, prevVisibilityTexture);
 
-        glfwSwapBuffers(window);
+        if(!benchmarkMode) glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    if(benchmarkMode && benchmarkFrame == benchmarkFrameCount) {
+        std::string outputPath = std::string(benchmarkOutputDirectory) + "/";
+
+        std::ofstream frameTimesFile(outputPath + "frameTimes.csv");
+        frameTimesFile << "frame,frameTimeMs,renderScale\n";
+        for(unsigned int i = 0; i < benchmarkFrameCount; ++i) {
+            frameTimesFile << i << "," << benchmarkFrameTimes[i] << "," << benchmarkRenderScales[i] << "\n";
+        }
+        if(!frameTimesFile.good()) std::cout << "ERROR: Could not write " << outputPath << "frameTimes.csv" << std::endl;
+
+        outputTexture->saveImage((outputPath + "finalFrame.ppm").c_str());
+
+        std::vector<double> sortedFrameTimes = benchmarkFrameTimes;
+        std::sort(sortedFrameTimes.begin(), sortedFrameTimes.end());
+        double averageFrameTime = 0.0;
+        for(double frameTime : sortedFrameTimes) averageFrameTime += frameTime / sortedFrameTimes.size();
+        std::cout << "Benchmark: " << benchmarkFrameCount << " frames at " << windowSize.x << "x" << windowSize.y << ", frame time avg " << averageFrameTime
+                  << " ms, median " << sortedFrameTimes[sortedFrameTimes.size() / 2] << " ms, p99 " << sortedFrameTimes[(sortedFrameTimes.size() - 1) * 99 / 100] << " ms" << std::endl;
+        if(enableDynamicResolution) {
+            double averageRenderScale = 0.0;
+            for(float scale : benchmarkRenderScales) averageRenderScale += scale / benchmarkRenderScales.size();
+            std::cout << "Render scale avg " << averageRenderScale << ", last " << benchmarkRenderScales.back() << std::endl;
+        }
+    }
+
+    // Reads the last times from the timers, which needs the context
+    passTimesLog.close();
+    OctreeCache::unloadOctreeCache(octree);
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext(NULL);
@@ -11,22 +11,20 @@ void main() {
 
 layout (location = 0) out vec4 frameTexture;
 
+// The lighting of this frame at u_renderSize, and the g buffer of this frame and the previous one at u_renderSize and u_prevRenderSize.
+//  The previous frame is the output of this shader, which is always at u_windowSize.
 uniform sampler2D u_frameTexture;
 uniform sampler2D u_normalTexture;
 uniform sampler2D u_posTexture;
 uniform sampler2D u_prevFrameTexture;
 uniform sampler2D u_prevNormalTexture;
 uniform sampler2D u_prevPosTexture;
+// Used instead of the normal and position textures when u_visibilityBufferEnabled is set, there is no albedo texture bound
+uniform usampler2D u_visibilityTexture;
+uniform usampler2D u_prevVisibilityTexture;
 
-uniform vec3 u_cameraPos;
-uniform mat3 u_prevCameraRotMatrix;
-uniform vec3 u_prevCameraPos;
-uniform vec2 u_windowSize;
-uniform float u_fov;
-uniform float u_taaAlpha;
-uniform float u_taaDistWeightScaler;
-uniform float u_taaNormalWeightScaler;
-uniform float u_taaColorWeightScaler;
+#include "frameData.glsl"
+#include "gBuffer.glsl"
 
 vec2 getScreenSpacePosition(vec3 worldSpacePos, vec3 cameraPos, mat3 cameraRotMatrix, float aspectRatio, float fov) {
     vec3 rayDir = normalize(worldSpacePos - cameraPos); // Ray dir in world space
@@ -41,27 +39,48 @@ vec2 getScreenSpacePosition(vec3 worldSpacePos, vec3 cameraPos, mat3 cameraRotMa
     return screenSpaceCoordinates;
 }
 
+// Returns where the ray through 'screenPos' hits the face that the g buffer sample at 'pos' lies on. A g buffer pixel can cover several
+//  output pixels, each of them is reprojected from its own point on the face.
+vec3 getOutputPixelPos(vec2 screenPos, vec3 normal, vec3 pos, vec3 cameraPos, mat3 cameraRotMatrix, float aspectRatio, float fov) {
+    vec2 screenSpaceCoordinates = screenPos - vec2(0.5);
+    vec3 rayDir = cameraRotMatrix * normalize(vec3(screenSpaceCoordinates.x * tan(fov) * aspectRatio, screenSpaceCoordinates.y * tan(fov), -1.0));
+
+    float rayDirDotNormal = dot(rayDir, normal);
+    if(abs(rayDirDotNormal) < 1e-4) return pos; // Nothing was hit or the face is seen from the side
+    return cameraPos + rayDir * (dot(pos - cameraPos, normal) / rayDirDotNormal);
+}
+
 void main() {
     vec2 fragPos = gl_FragCoord.xy / u_windowSize;
-    vec3 framePixel = texture(u_frameTexture, fragPos).rgb;
-    vec3 normal = texture(u_normalTexture, fragPos).xyz;
-    vec3 pos = texture(u_posTexture, fragPos).xyz;
-
+    ivec2 gBufferPixel = getGBufferPixel(fragPos);
+    vec3 framePixel = texelFetch(u_frameTexture, gBufferPixel, 0).rgb;
+    gBufferData gbd = readGBufferGeometry(u_normalTexture, u_posTexture, u_visibilityTexture, gBufferPixel);
+    vec3 normal = gbd.normal;
     float aspectRatio = u_windowSize.x / u_windowSize.y;
+    vec3 pos = getOutputPixelPos(fragPos, normal, gbd.pos, u_cameraPos, u_cameraRotMatrix, aspectRatio, u_fov);
+
+    // The further the ray of the g buffer pixel is from the center of the output pixel, the less weight this frame has
+    vec2 sampleOffset = (vec2(gBufferPixel) + vec2(0.5) + u_jitter) / u_renderSize - fragPos;
+    sampleOffset *= u_windowSize;
+    float sampleWeight = exp(-2.0 * dot(sampleOffset, sampleOffset));
+
     vec2 screenSpaceCoordinates = getScreenSpacePosition(pos, u_prevCameraPos, u_prevCameraRotMatrix, aspectRatio, u_fov);
 
     vec2 pixelSize = 1.0 / u_windowSize;
     float n = 0.0;
     vec3 accumulatedPixel = vec3(0.0);
+    float accumulatedHistoryWeight = 0.0;
 
-    for(int x = -1; x <= 1; ++x) {
+    for(int x = -1; x <= 1 && u_taaAlpha < 1.0; ++x) {
         for(int y = -1; y <= 1; ++y) {
             vec2 pixelPos = screenSpaceCoordinates + vec2(x * pixelSize.x, y * pixelSize.y);
             if(pixelPos.x >= 0.0 && pixelPos.x <= 1.0 && pixelPos.y >= 0.0 && pixelPos.y <= 1.0) {
-                vec3 prevPixel = texture(u_prevFrameTexture, pixelPos).rgb;
-                vec3 prevNormal = texture(u_prevNormalTexture, pixelPos).rgb;
-                vec3 prevFragmentPos = texture(u_prevPosTexture, pixelPos).xyz;
-                
+                ivec2 prevGBufferPixel = ivec2(clamp(floor(pixelPos * u_prevRenderSize - u_prevJitter), vec2(0.0), u_prevRenderSize - vec2(1.0)));
+                vec4 prevPixelAndWeight = texture(u_prevFrameTexture, pixelPos);
+                vec3 prevPixel = prevPixelAndWeight.rgb;
+                gBufferData prevGbd = readPrevGBuffer(u_prevNormalTexture, u_prevPosTexture, u_prevVisibilityTexture, prevGBufferPixel);
+                vec3 prevNormal = prevGbd.normal;
+                vec3 prevFragmentPos = getOutputPixelPos(pixelPos, prevNormal, prevGbd.pos, u_prevCameraPos, u_prevCameraRotMatrix, aspectRatio, u_fov);
                 vec3 deltaFragmentPos = pos - prevFragmentPos;
                 float dist = distance(pos, prevFragmentPos);
                 float distWeight = min(exp(-dist / u_taaDistWeightScaler), 1.0);
@@ -75,14 +94,24 @@ void main() {
                 float weight = distWeight * normalWeight * colorWeight;
 
                 accumulatedPixel += prevPixel * weight;
+                accumulatedHistoryWeight += prevPixelAndWeight.a * weight;
                 n += weight;
             }
         }
     }
 
     vec3 result;
-    if(n > 0) result = accumulatedPixel / n;
+    float historyWeight = 0.0;
+    if(n > 0) {
+        result = accumulatedPixel / n;
+        historyWeight = accumulatedHistoryWeight / n;
+    }
     else result = framePixel;
 
-    frameTexture = vec4((1.0 - u_taaAlpha) * result + u_taaAlpha * framePixel, 1.0);
+    // The alpha channel holds the weight of the samples in the history. It is limited so that a sample with full weight is blended in with
+    //  u_taaAlpha, as it is at full resolution without jitter once the history has filled up. Until then, and with the weak samples far
+    //  from the center of the pixel, the history and this frame are averaged by their weights.
+    historyWeight = min(historyWeight, 1.0 / u_taaAlpha - 1.0);
+    float alpha = sampleWeight / (historyWeight + sampleWeight);
+    frameTexture = vec4((1.0 - alpha) * result + alpha * framePixel, historyWeight + sampleWeight);
 }
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "Octree.h"
+#include "OctreeRayCaster.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <cmath>
+#include <iostream>
+
+// Checks OctreeRayCaster against hits that were worked out by hand for a small world: a floor, a box and a single voxel floating in the air.
+//  Every ray is traced with castRay, castRayPacket and getRayLength, through octrees with two chunk widths and through a DAG of each. The
+//  test runs in well under a second, prints every ray whose hit is wrong and returns -1 if there was one.
+
+struct GoldenRay {
+    const char* name;
+    glm::vec3 origin, target;
+    bool hit;
+    uint8_t paletteIndex;
+    glm::vec3 pos, normal;
+    float distance;
+};
+
+std::vector<uint8_t> generateWorld();
+bool checkHit(const char* octreeName, const GoldenRay& ray, const char* method, const OctreeRayHit& hit);
+
+const unsigned int WORLD_WIDTH = 32;
+const unsigned int MAX_ITERATIONS = 1000;
+// How far the hits may be from the golden positions and distances, which are rounded to four decimals
+const float HIT_TOLERANCE = 1e-3f;
+
+// The positions are relative to the center of the world, like in the shaders, so the voxel (x, y, z) spans from (x, y, z) - 16 to one more
+const GoldenRay GOLDEN_RAYS[] = {
+    { "floor from above", glm::vec3(0.3f, 12.2f, 0.4f), glm::vec3(4.5f, -11.5f, -2.5f), true, 2, glm::vec3(4.5886f, -12.0f, -2.5612f), glm::vec3(0, 1, 0), 24.7548f },
+    { "side of the box", glm::vec3(-14.6f, -2.3f, -7.8f), glm::vec3(5.5f, -4.5f, -7.5f), true, 5, glm::vec3(4.0f, -4.3358f, -7.5224f), glm::vec3(-1, 0, 0), 18.7131f },
+    { "top of the box", glm::vec3(5.4f, 14.7f, -15.1f), glm::vec3(5.5f, -4.5f, -7.5f), true, 5, glm::vec3(5.4870f, -2.0f, -8.4896f), glm::vec3(0, 1, 0), 17.9609f },
+    { "top of the box from close by", glm::vec3(9.9f, 5.3f, -9.1f), glm::vec3(4.5f, -3.5f, -7.5f), true, 5, glm::vec3(5.4205f, -2.0f, -7.7727f), glm::vec3(0, 1, 0), 8.6671f },
+    { "single voxel", glm::vec3(-14.2f, 4.1f, 15.3f), glm::vec3(-10.5f, 4.5f, 9.5f), true, 9, glm::vec3(-10.8190f, 4.4655f, 10.0f), glm::vec3(0, 0, 1), 6.2972f },
+    { "straight down", glm::vec3(-3.3f, -8.4f, -3.6f), glm::vec3(-3.3f, -20.0f, -3.6f), true, 2, glm::vec3(-3.3f, -12.0f, -3.6f), glm::vec3(0, 1, 0), 3.6f },
+    // A ray that starts in a voxel hits it right away, with the normal the traversal starts with
+    { "inside the floor", glm::vec3(2.6f, -13.5f, 3.2f), glm::vec3(8.0f, -20.0f, 3.2f), true, 1, glm::vec3(2.6f, -13.5f, 3.2f), glm::vec3(1, 0, 0), 0.0f },
+    { "up and out of the world", glm::vec3(-15.3f, 10.2f, -15.6f), glm::vec3(15.0f, 11.0f, 15.0f), false, 0, glm::vec3(0.0f), glm::vec3(0.0f), -1.0f },
+    { "above the floor, beside the box", glm::vec3(0.7f, -1.1f, 0.2f), glm::vec3(1.7f, -1.1f, 0.2f), false, 0, glm::vec3(0.0f), glm::vec3(0.0f), -1.0f },
+    { "between the floor and the box", glm::vec3(-9.7f, -11.5f, -8.2f), glm::vec3(-9.7f, -11.5f, 10.0f), false, 0, glm::vec3(0.0f), glm::vec3(0.0f), -1.0f }
+};
+const unsigned int GOLDEN_RAY_COUNT = sizeof(GOLDEN_RAYS) / sizeof(GOLDEN_RAYS[0]);
+
+int main() {
+    std::vector<uint8_t> world = generateWorld();
+    unsigned int failures = 0;
+
+    // Chunks of width 8 and 16 use different instances of the ray caster
+    for(unsigned int maxDepth : { 2u, 1u }) {
+        Octree tree(world.data(), WORLD_WIDTH, maxDepth);
+        Octree dag(tree.nodes.data(), tree.nodes.size(), tree.chunkData.data(), tree.chunkData.size(), WORLD_WIDTH, maxDepth, false);
+        dag.convertToDAG();
+
+        for(const Octree* octree : { &tree, &dag }) {
+            std::string octreeName = std::string(octree->isDAG ? "DAG" : "tree") + " with chunks of width " + std::to_string(WORLD_WIDTH >> maxDepth);
+            std::unique_ptr<OctreeRayCaster> rayCaster = OctreeRayCaster::create(*octree);
+            if(!rayCaster) {
+                std::cout << "ERROR: There is no ray caster for the " << octreeName << std::endl;
+                return -1;
+            }
+
+            // The packets are filled with the golden rays in order and padded with the first one
+            std::vector<OctreeRayHit> packetHits((GOLDEN_RAY_COUNT + RAY_PACKET_SIZE - 1) / RAY_PACKET_SIZE * RAY_PACKET_SIZE);
+            for(unsigned int first = 0; first < packetHits.size(); first += RAY_PACKET_SIZE) {
+                OctreeRayPacket packet;
+                for(unsigned int lane = 0; lane < RAY_PACKET_SIZE; ++lane) {
+                    const GoldenRay& ray = GOLDEN_RAYS[(first + lane < GOLDEN_RAY_COUNT) ? first + lane : 0];
+                    glm::vec3 direction = glm::normalize(ray.target - ray.origin);
+                    packet.originX[lane] = ray.origin.x;
+                    packet.originY[lane] = ray.origin.y;
+                    packet.originZ[lane] = ray.origin.z;
+                    packet.directionX[lane] = direction.x;
+                    packet.directionY[lane] = direction.y;
+                    packet.directionZ[lane] = direction.z;
+                    packet.startDistance[lane] = 0.0f;
+                    packet.maxDistance[lane] = INFINITY;
+                }
+                rayCaster->castRayPacket(packet, MAX_ITERATIONS, &packetHits[first]);
+            }
+
+            for(unsigned int i = 0; i < GOLDEN_RAY_COUNT; ++i) {
+                const GoldenRay& ray = GOLDEN_RAYS[i];
+                glm::vec3 direction = glm::normalize(ray.target - ray.origin);
+                if(!checkHit(octreeName.c_str(), ray, "castRay", rayCaster->castRay(ray.origin, direction, 0.0f, MAX_ITERATIONS, INFINITY))) failures++;
+                if(!checkHit(octreeName.c_str(), ray, "castRayPacket", packetHits[i])) failures++;
+
+                // getRayLength returns the distance to the hit, or 'maxDistance' for a miss
+                float rayLength = rayCaster->getRayLength(ray.origin, direction, MAX_ITERATIONS, 64.0f);
+                if(std::abs(rayLength - (ray.hit ? ray.distance : 64.0f)) > HIT_TOLERANCE) {
+                    std::cout << "ERROR: getRayLength returns " << rayLength << " for the ray '" << ray.name << "' in the " << octreeName << std::endl;
+                    failures++;
+                }
+            }
+        }
+    }
+
+    if(failures > 0) {
+        std::cout << failures << " checks failed" << std::endl;
+        return -1;
+    }
+    std::cout << "All " << GOLDEN_RAY_COUNT << " golden rays hit what they should" << std::endl;
+    return 0;
+}
+
+// A floor of 4 layers with a different top layer, a 4^3 box above it and a single voxel further up
+std::vector<uint8_t> generateWorld() {
+    std::vector<uint8_t> world((size_t)WORLD_WIDTH * WORLD_WIDTH * WORLD_WIDTH, 0);
+    auto setVoxel = [&](unsigned int x, unsigned int y, unsigned int z, uint8_t paletteIndex) {
+        world[x + y * WORLD_WIDTH + z * WORLD_WIDTH * WORLD_WIDTH] = paletteIndex;
+    };
+
+    for(unsigned int z = 0; z < WORLD_WIDTH; ++z) {
+        for(unsigned int y = 0; y < 4; ++y) {
+            for(unsigned int x = 0; x < WORLD_WIDTH; ++x) setVoxel(x, y, z, (y == 3) ? 2 : 1);
+        }
+    }
+    for(unsigned int z = 6; z < 10; ++z) {
+        for(unsigned int y = 10; y < 14; ++y) {
+            for(unsigned int x = 20; x < 24; ++x) setVoxel(x, y, z, 5);
+        }
+    }
+    setVoxel(5, 20, 25, 9);
+    return world;
+}
+
+bool checkHit(const char* octreeName, const GoldenRay& ray, const char* method, const OctreeRayHit& hit) {
+    bool matches = hit.hit == ray.hit;
+    if(matches && ray.hit) {
+        matches = hit.paletteIndex == ray.paletteIndex && hit.normal == ray.normal && std::abs(hit.distance - ray.distance) < HIT_TOLERANCE
+            && std::abs(hit.pos.x - ray.pos.x) < HIT_TOLERANCE && std::abs(hit.pos.y - ray.pos.y) < HIT_TOLERANCE && std::abs(hit.pos.z - ray.pos.z) < HIT_TOLERANCE;
+    }
+    if(!matches) {
+        std::cout << "ERROR: " << method << " " << (hit.hit ? "hits" : "misses") << " the ray '" << ray.name << "' in the " << octreeName;
+        if(hit.hit) {
+            std::cout << ", palette index " << (unsigned int)hit.paletteIndex << " at (" << hit.pos.x << ", " << hit.pos.y << ", " << hit.pos.z
+                << ") with the normal (" << hit.normal.x << ", " << hit.normal.y << ", " << hit.normal.z << ")";
+        }
+        std::cout << std::endl;
+    }
+    return matches;
+}
\ No newline at end of file
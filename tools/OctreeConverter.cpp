@@ -0,0 +1,40 @@
+#include "OctreeCache.h"
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+
+// Builds the octree cache of a world offline, so that the renderer can map it directly instead of building the octree on startup.
+//  The renderer loads assets/world.xraw with Z up and a max depth of 5, use "--z-up" for a cache it accepts.
+int main(int argc, char** argv) {
+    if(argc < 3) {
+        std::cout << "Usage: OctreeConverter <world.xraw> <output.voct> [--max-depth N] [--dag] [--z-up] [--threads N] [--slab-budget MB]" << std::endl;
+        return -1;
+    }
+
+    const char* worldFilename = argv[1];
+    const char* cacheFilename = argv[2];
+    unsigned int maxDepth = 5;
+    bool convertToDAG = false;
+    VoxelDataAxis axis = VoxelDataAxis::Y_Up;
+    unsigned int threadCount = 0;
+    size_t slabMemoryBudget = 256 * 1024 * 1024;
+
+    for(int i = 3; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--max-depth") == 0 && i + 1 < argc) maxDepth = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--dag") == 0) convertToDAG = true;
+        else if(std::strcmp(argv[i], "--z-up") == 0) axis = VoxelDataAxis::Z_Up;
+        else if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--slab-budget") == 0 && i + 1 < argc) slabMemoryBudget = (size_t)std::atoi(argv[++i]) * 1024 * 1024;
+        else {
+            std::cout << "Unknown argument " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+
+    if(!OctreeCache::buildOctreeCache(worldFilename, axis, cacheFilename, maxDepth, convertToDAG, slabMemoryBudget, threadCount)) {
+        return -1;
+    }
+
+    std::cout << "Wrote " << cacheFilename << std::endl;
+    return 0;
+}
\ No newline at end of file